@@ -10,8 +10,10 @@ extern bool flashWrite(uint32_t address, const uint8_t* data, size_t length);
 extern bool flashWriteString(uint32_t address, const String& str);
 extern bool flashRead(uint32_t address, uint8_t* buffer, size_t length);
 extern bool flashReadString(uint32_t address, String& str);
+extern bool flashReadString(uint32_t address, char* buffer, size_t size, uint32_t& length);
 extern bool flashReadRange(uint32_t startAddress, uint32_t endAddress, uint8_t* buffer);
-extern void flashDumpAll(size_t chunkSize);
+extern bool flashReadStream(uint32_t address, size_t length, SPIFlash::streamCallback callback, void* context, size_t chunkSize = 1024);
+extern void flashDumpAll(size_t chunkSize = 256);
 extern bool flashEraseAll();
 extern bool flashEraseSector(uint32_t address);
 extern bool flashEraseRange(uint32_t startAddress, uint32_t endAddress);
@@ -19,6 +21,7 @@ extern bool flashEraseRange(uint32_t startAddress, uint32_t endAddress);
 // Ring buffer functions
 extern bool flashRingBufferInit();
 extern bool flashRingBufferWrite(const uint8_t* data, size_t length);
+extern bool flashRingBufferWritev(const SPIFlash::iovec* vec, uint8_t count);
 extern bool flashRingBufferWriteString(const String& str);
 extern uint32_t flashRingBufferGetPosition();
 extern bool flashRingBufferSetPosition(uint32_t address);
@@ -26,6 +29,11 @@ extern void flashRingBufferReset();
 extern void flashRingBufferPause();
 extern void flashRingBufferResume();
 extern bool flashRingBufferIsPaused();
+extern void flashRingBufferEraseAhead();
+extern void flashRingBufferSetEraseAhead(uint8_t sectors);
+extern uint8_t flashRingBufferGetEraseAhead();
+extern uint32_t flashRingBufferEraseStalls();
+extern uint16_t flashRingBufferLatency(uint32_t &p50, uint32_t &p99, uint32_t &maxLatency);
 
 // Ring buffer state
 extern bool ringBufferInitialized;
@@ -36,7 +44,8 @@ extern void stopAutoWrite();
 extern bool isAutoWriteEnabled();
 
 // Forward declarations
-extern SPIFlash flash;
+extern SPIFlashT<W25Q32JV> flash;
+extern SPIFlashVolume flashVolume;
 extern SemaphoreHandle_t spiMutex;
 extern bool flashInitialized;
 extern const uint32_t FLASH_SECTOR_SIZE;
@@ -164,6 +173,11 @@ private:
      */
     void handleRingResetCommand();
     
+    /**
+     * @brief Handle ring buffer erase-ahead command
+     */
+    void handleRingAheadCommand(String args);
+    
     /**
      * @brief Handle auto-write start command
      */
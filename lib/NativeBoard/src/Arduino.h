@@ -0,0 +1,87 @@
+#ifndef NATIVEBOARD_ARDUINO_H
+#define NATIVEBOARD_ARDUINO_H
+
+/**
+ * @file Arduino.h
+ * @brief Arduino-ESP32 core shim for the host (native) build
+ *
+ * Provides just enough of the core for SPIMemory, the ring buffer and the
+ * SerialBT_Commander parser to build and run on Linux. Time is virtual: it
+ * follows the host clock, plus the wire time of every SPI byte and every
+ * delayMicroseconds() call, so that busy-wait loops see the timings of the
+ * emulated chips rather than the speed of the host. Every task keeps its own
+ * time, and tasks catch up with each other where they share a bus or a
+ * semaphore (see NativeBoard.h).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+
+#include "WString.h"
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define HIGH          0x1
+#define LOW           0x0
+
+#define INPUT         0x01
+#define OUTPUT        0x03
+#define INPUT_PULLUP  0x05
+
+#define LSBFIRST      0
+#define MSBFIRST      1
+
+#define SS            5
+
+#define F(string_literal) (string_literal)
+#define PROGMEM
+#define IRAM_ATTR
+
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef unsigned int word;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield(void);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// There is nothing to mask on the host - SPI transactions are serialised by the callers
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+class EspClass {
+public:
+  uint32_t getFreeHeap(void);
+  uint32_t getHeapSize(void);
+  uint32_t getCpuFreqMHz(void) { return 240; }
+};
+
+extern EspClass ESP;
+
+void setup(void);
+void loop(void);
+
+#endif // NATIVEBOARD_ARDUINO_H
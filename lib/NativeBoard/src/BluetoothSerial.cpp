@@ -0,0 +1,75 @@
+#include "BluetoothSerial.h"
+#include "NativeBoard.h"
+
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+static std::mutex inputMutex;
+static std::deque<uint8_t> input;
+static bool inputClosed = false;
+static bool readerStarted = false;
+
+static void readInput(void) {
+  int c;
+  while ((c = getchar()) != EOF) {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    input.push_back((uint8_t)c);
+  }
+  std::lock_guard<std::mutex> lock(inputMutex);
+  inputClosed = true;
+}
+
+bool BluetoothSerial::begin(const String &localName, bool isMaster) {
+  (void)localName;
+  (void)isMaster;
+  std::lock_guard<std::mutex> lock(inputMutex);
+  if (!readerStarted) {
+    readerStarted = true;
+    std::thread(readInput).detach();
+  }
+  return true;
+}
+
+// The client goes away once the script has been consumed in full. Nothing else is going to arrive, so the firmware
+// is stopped rather than left waiting for a reconnection
+bool BluetoothSerial::hasClient(void) {
+  bool done;
+  {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    done = inputClosed && input.empty();
+  }
+  if (done) {
+    nativeBoardExit(0);
+  }
+  return true;
+}
+
+int BluetoothSerial::available(void) {
+  std::lock_guard<std::mutex> lock(inputMutex);
+  return input.size();
+}
+
+int BluetoothSerial::read(void) {
+  std::lock_guard<std::mutex> lock(inputMutex);
+  if (input.empty()) {
+    return -1;
+  }
+  uint8_t c = input.front();
+  input.pop_front();
+  return c;
+}
+
+int BluetoothSerial::peek(void) {
+  std::lock_guard<std::mutex> lock(inputMutex);
+  return input.empty() ? -1 : input.front();
+}
+
+size_t BluetoothSerial::write(uint8_t c) {
+  return nativeConsoleWrite(&c, 1);
+}
+
+size_t BluetoothSerial::write(const uint8_t *buffer, size_t size) {
+  return nativeConsoleWrite(buffer, size);
+}
@@ -0,0 +1,32 @@
+#ifndef NATIVEBOARD_BLUETOOTHSERIAL_H
+#define NATIVEBOARD_BLUETOOTHSERIAL_H
+
+#include "Arduino.h"
+
+/**
+ * @brief Bluetooth SPP link of the board, mapped to stdin/stdout
+ * A client is connected from the start. Input is read from stdin by a
+ * background thread; once stdin is closed and everything has been read, the
+ * client counts as gone and the firmware is stopped (see nativeBoardExit()),
+ * so a command script can be piped in:
+ *
+ *   printf 'info\nerase 0\n' | .pio/build/native/program
+ */
+class BluetoothSerial : public Stream {
+public:
+  bool begin(const String &localName = String(), bool isMaster = false);
+  void end(void) {}
+  bool hasClient(void);
+  bool connected(void) { return hasClient(); }
+
+  int available(void) override;
+  int read(void) override;
+  int peek(void) override;
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  using Print::write;
+};
+
+#endif // NATIVEBOARD_BLUETOOTHSERIAL_H
@@ -0,0 +1,26 @@
+#include "HardwareSerial.h"
+
+#include <mutex>
+#include <stdio.h>
+
+HardwareSerial Serial;
+
+static std::mutex consoleMutex;
+
+size_t nativeConsoleWrite(const uint8_t *buffer, size_t size) {
+  std::lock_guard<std::mutex> lock(consoleMutex);
+  return fwrite(buffer, 1, size, stdout);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return nativeConsoleWrite(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  return nativeConsoleWrite(buffer, size);
+}
+
+void HardwareSerial::flush(void) {
+  std::lock_guard<std::mutex> lock(consoleMutex);
+  fflush(stdout);
+}
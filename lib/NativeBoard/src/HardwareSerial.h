@@ -0,0 +1,35 @@
+#ifndef NATIVEBOARD_HARDWARESERIAL_H
+#define NATIVEBOARD_HARDWARESERIAL_H
+
+#include "Stream.h"
+
+/**
+ * @brief UART0 of the board, mapped to stdout
+ * Output is line buffered and written under a lock, so that lines printed by
+ * different tasks do not interleave. There is no input - commands arrive
+ * through BluetoothSerial.
+ */
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end(void) {}
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  void flush(void) override;
+
+  int available(void) override { return 0; }
+  int read(void) override { return -1; }
+  int peek(void) override { return -1; }
+
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+/**
+ * @brief Writes to stdout under the lock shared by Serial and BluetoothSerial
+ */
+size_t nativeConsoleWrite(const uint8_t *buffer, size_t size);
+
+#endif // NATIVEBOARD_HARDWARESERIAL_H
@@ -0,0 +1,206 @@
+#include "NativeBoard.h"
+#include "SPI.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct NativeAttachedDevice {
+  SPIClass *bus;
+  uint8_t csPin;
+  NativeSPIDevice *device;
+  bool selected;
+};
+
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+static thread_local uint64_t advancedNs = 0;    // Wire time and busy-waits of this task
+static std::atomic<uint64_t> furthestNs(0);     // Largest advancedNs of any task
+static std::vector<NativeAttachedDevice> devices;
+static uint8_t pinLevel[256];
+static std::mutex randomMutex;
+static std::mt19937 randomEngine(0);
+
+EspClass ESP;
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                               Clock                                //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+static uint64_t hostNanos(void) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+// Every task runs on its own clock, as the two cores of an ESP32 do - what one task spends on its bus does not hold up
+// the others. Tasks line their clocks up wherever they meet: a shared bus or semaphore (see nativeBoardSync())
+uint64_t nativeBoardNanos(void) {
+  return hostNanos() + advancedNs;
+}
+
+uint64_t nativeBoardFurthestNanos(void) {
+  return hostNanos() + furthestNs.load(std::memory_order_relaxed);
+}
+
+void nativeBoardAdvance(uint64_t ns) {
+  advancedNs += ns;
+  uint64_t furthest = furthestNs.load(std::memory_order_relaxed);
+  while (advancedNs > furthest && !furthestNs.compare_exchange_weak(furthest, advancedNs, std::memory_order_relaxed)) {
+  }
+}
+
+void nativeBoardSync(uint64_t ns) {
+  uint64_t now = nativeBoardNanos();
+  if (ns > now) {
+    nativeBoardAdvance(ns - now);
+  }
+}
+
+unsigned long millis(void) {
+  return nativeBoardNanos() / 1000000ULL;
+}
+
+unsigned long micros(void) {
+  return nativeBoardNanos() / 1000ULL;
+}
+
+// Other tasks have to keep running, so this one really sleeps
+void delay(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Busy-waits on the board are skipped: the clock is moved forward instead of spinning the host
+void delayMicroseconds(uint32_t us) {
+  nativeBoardAdvance((uint64_t)us * 1000ULL);
+  std::this_thread::yield();
+}
+
+void yield(void) {
+  std::this_thread::yield();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                            GPIO and SPI                            //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+// Chip select pins are pulled up on the board, so a device starts deselected
+void nativeAttachSPIDevice(SPIClass &bus, uint8_t csPin, NativeSPIDevice &device) {
+  pinLevel[csPin] = HIGH;
+  devices.push_back({&bus, csPin, &device, false});
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  pinLevel[pin] = val ? HIGH : LOW;
+  for (NativeAttachedDevice &attached : devices) {
+    if (attached.csPin != pin) {
+      continue;
+    }
+    bool select = (val == LOW);
+    if (select == attached.selected) {
+      continue;
+    }
+    attached.selected = select;
+    if (select) {
+      attached.device->select();
+    }
+    else {
+      attached.device->deselect();
+    }
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return pinLevel[pin];
+}
+
+uint8_t nativeBoardTransfer(SPIClass *bus, uint8_t data, uint32_t clockSpeed, uint8_t lines) {
+  uint8_t miso = 0xFF;    // Pulled up when nothing drives it
+  for (NativeAttachedDevice &attached : devices) {
+    if (attached.bus == bus && attached.selected) {
+      miso &= attached.device->transfer(data, clockSpeed, lines);
+    }
+  }
+  if (clockSpeed) {
+    nativeBoardAdvance(8000000000ULL / ((uint64_t)clockSpeed * lines));
+  }
+  return miso;
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                               System                               //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+// Same sequence on every run unless the firmware seeds it, so that runs can be compared
+long random(long howbig) {
+  if (howbig <= 0) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(randomMutex);
+  return std::uniform_int_distribution<long>(0, howbig - 1)(randomEngine);
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) {
+    return howsmall;
+  }
+  return howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed) {
+  std::lock_guard<std::mutex> lock(randomMutex);
+  randomEngine.seed(seed);
+}
+
+// Roughly what an ESP32 has left once Bluetooth is up. Host allocations are not counted
+uint32_t EspClass::getFreeHeap(void) {
+  return 180 * 1024;
+}
+
+uint32_t EspClass::getHeapSize(void) {
+  return 320 * 1024;
+}
+
+void nativeBoardExit(int status) {
+  static std::atomic_flag exiting = ATOMIC_FLAG_INIT;
+  if (exiting.test_and_set()) {
+    while (true) {
+      pause();
+    }
+  }
+  Serial.printf("\n[NATIVE] Stopped after %llu ms\n", (unsigned long long)(nativeBoardFurthestNanos() / 1000000ULL));
+  for (NativeAttachedDevice &attached : devices) {
+    attached.device->printStats(Serial);
+    attached.device->end();
+  }
+  Serial.flush();
+  _exit(status);
+}
+
+static void watchRunTime(uint64_t runNs) {
+  while (nativeBoardFurthestNanos() < runNs) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  nativeBoardExit(0);
+}
+
+int main(void) {
+  setvbuf(stdout, NULL, _IOLBF, 0);
+
+  const char *runMs = getenv("NATIVEBOARD_RUN_MS");
+  if (runMs && atol(runMs) > 0) {
+    std::thread(watchRunTime, (uint64_t)atol(runMs) * 1000000ULL).detach();
+  }
+
+  setup();
+  while (true) {
+    loop();
+    yield();
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef NATIVEBOARD_H
+#define NATIVEBOARD_H
+
+/**
+ * @file NativeBoard.h
+ * @brief Host-side board model behind the Arduino shims
+ *
+ * The board owns the virtual clock and the SPI devices. A device is attached
+ * to an SPIClass and a chip select pin; digitalWrite() on that pin selects and
+ * deselects it, and the SPIClass exchanges bytes with it.
+ *
+ * Environment variables:
+ *   NATIVEBOARD_RUN_MS  Stops the firmware after this many milliseconds of
+ *                       board time and prints the device statistics
+ */
+
+#include "Arduino.h"
+
+class SPIClass;
+
+/**
+ * @brief A chip on one of the SPI buses of the board
+ * All calls are made with the bus held by the caller, so a device only needs
+ * to guard state that it shares with printStats().
+ */
+class NativeSPIDevice {
+public:
+  virtual ~NativeSPIDevice() {}
+
+  /** @brief Chip select went low */
+  virtual void select(void) = 0;
+
+  /** @brief Chip select went high */
+  virtual void deselect(void) = 0;
+
+  /**
+   * @brief Exchanges one byte
+   * @param data Byte on MOSI
+   * @param clockSpeed SCK frequency in Hz
+   * @param lines Data lines the byte is clocked over (1, 2 or 4). In and out
+   *              share the lines when there is more than one
+   * @return Byte on MISO
+   */
+  virtual uint8_t transfer(uint8_t data, uint32_t clockSpeed, uint8_t lines) = 0;
+
+  /** @brief Prints whatever the device counted - called when the firmware stops */
+  virtual void printStats(Print &out) { (void)out; }
+
+  /** @brief Called once when the firmware stops, e.g. to save state */
+  virtual void end(void) {}
+};
+
+/**
+ * @brief Puts a device on an SPI bus
+ * @param bus Bus the device is wired to
+ * @param csPin Chip select pin of the device (active low)
+ * @param device The device. It has to outlive the firmware
+ */
+void nativeAttachSPIDevice(SPIClass &bus, uint8_t csPin, NativeSPIDevice &device);
+
+/**
+ * @brief Board time in nanoseconds since start-up, as seen by the calling task
+ * Each task (host thread) keeps its own time: the host clock plus the wire
+ * time and busy-waits of that task only. Two tasks driving two buses
+ * therefore run side by side, as on the two cores of an ESP32.
+ */
+uint64_t nativeBoardNanos(void);
+
+/**
+ * @brief Board time of the task that has got furthest
+ */
+uint64_t nativeBoardFurthestNanos(void);
+
+/**
+ * @brief Moves the clock of the calling task forward without waiting
+ */
+void nativeBoardAdvance(uint64_t ns);
+
+/**
+ * @brief Brings the clock of the calling task up to ns, if it is behind
+ * Called where tasks meet - taking a semaphore another task gave, a bus
+ * another task used last - so that nothing happens before its cause.
+ */
+void nativeBoardSync(uint64_t ns);
+
+/**
+ * @brief Exchanges one byte with the selected device(s) on a bus - used by SPIClass
+ */
+uint8_t nativeBoardTransfer(SPIClass *bus, uint8_t data, uint32_t clockSpeed, uint8_t lines);
+
+/**
+ * @brief Stops the firmware: prints the device statistics, ends the devices and exits
+ */
+[[noreturn]] void nativeBoardExit(int status);
+
+#endif // NATIVEBOARD_H
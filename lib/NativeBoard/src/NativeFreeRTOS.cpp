@@ -0,0 +1,175 @@
+#include "Arduino.h"
+#include "NativeBoard.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
+
+struct NativeTask {
+  TaskFunction_t code;
+  void *parameters;
+  std::string name;
+  uint64_t createdNs;       // A task starts at the board time of the task that created it
+};
+
+struct NativeSemaphore {
+  std::mutex lock;
+  std::condition_variable changed;
+  UBaseType_t count;
+  UBaseType_t maxCount;
+  std::thread::id holder;
+  UBaseType_t depth;
+  uint64_t givenNs;         // Board time of the last give - the task that takes it next catches up with it
+};
+
+// The thread that runs setup() and loop() counts as the Arduino loopTask
+static std::atomic<UBaseType_t> taskCount(1);
+static thread_local NativeTask *currentTask = NULL;
+
+static void runTask(NativeTask *task) {
+  currentTask = task;
+  nativeBoardSync(task->createdNs);
+  task->code(task->parameters);
+  // Returning from a task function is an error on FreeRTOS. Treat it as vTaskDelete(NULL)
+  taskCount--;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask,
+                                   BaseType_t xCoreID) {
+  (void)usStackDepth;
+  (void)uxPriority;
+  (void)xCoreID;
+  NativeTask *task = new NativeTask{pvTaskCode, pvParameters, pcName ? pcName : "", nativeBoardNanos()};
+  if (pvCreatedTask) {
+    *pvCreatedTask = task;
+  }
+  taskCount++;
+  std::thread(runTask, task).detach();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete) {
+  if (xTaskToDelete != NULL && xTaskToDelete != currentTask) {
+    return;
+  }
+  taskCount--;
+  pthread_exit(NULL);
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay) {
+  delay(xTicksToDelay * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(millis() / portTICK_PERIOD_MS);
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void) {
+  return taskCount;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  return currentTask;
+}
+
+const char *pcTaskGetName(TaskHandle_t xTaskToQuery) {
+  if (xTaskToQuery == NULL) {
+    xTaskToQuery = currentTask;
+  }
+  return xTaskToQuery ? xTaskToQuery->name.c_str() : "loopTask";
+}
+
+static SemaphoreHandle_t createSemaphore(UBaseType_t maxCount, UBaseType_t initialCount) {
+  NativeSemaphore *sem = new NativeSemaphore;
+  sem->count = initialCount;
+  sem->maxCount = maxCount;
+  sem->depth = 0;
+  sem->givenNs = 0;
+  return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  return createSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+  return createSemaphore(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+  return createSemaphore(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount) {
+  return createSemaphore(uxMaxCount, uxInitialCount);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t xSemaphore) {
+  delete xSemaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime) {
+  std::unique_lock<std::mutex> lock(xSemaphore->lock);
+  auto ready = [xSemaphore] { return xSemaphore->count > 0; };
+  if (xBlockTime == portMAX_DELAY) {
+    xSemaphore->changed.wait(lock, ready);
+  }
+  else if (!xSemaphore->changed.wait_for(lock, std::chrono::milliseconds(xBlockTime * portTICK_PERIOD_MS), ready)) {
+    return pdFALSE;
+  }
+  xSemaphore->count--;
+  xSemaphore->holder = std::this_thread::get_id();
+  nativeBoardSync(xSemaphore->givenNs);
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore) {
+  std::lock_guard<std::mutex> lock(xSemaphore->lock);
+  if (xSemaphore->count >= xSemaphore->maxCount) {
+    return pdFALSE;
+  }
+  xSemaphore->count++;
+  xSemaphore->holder = std::thread::id();
+  xSemaphore->givenNs = std::max(xSemaphore->givenNs, nativeBoardNanos());
+  xSemaphore->changed.notify_one();
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t xMutex, TickType_t xBlockTime) {
+  {
+    std::lock_guard<std::mutex> lock(xMutex->lock);
+    if (xMutex->depth && xMutex->holder == std::this_thread::get_id()) {
+      xMutex->depth++;
+      return pdTRUE;
+    }
+  }
+  if (xSemaphoreTake(xMutex, xBlockTime) != pdTRUE) {
+    return pdFALSE;
+  }
+  std::lock_guard<std::mutex> lock(xMutex->lock);
+  xMutex->depth = 1;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t xMutex) {
+  {
+    std::lock_guard<std::mutex> lock(xMutex->lock);
+    if (!xMutex->depth || xMutex->holder != std::this_thread::get_id()) {
+      return pdFALSE;
+    }
+    if (--xMutex->depth) {
+      return pdTRUE;
+    }
+  }
+  return xSemaphoreGive(xMutex);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t xSemaphore) {
+  std::lock_guard<std::mutex> lock(xSemaphore->lock);
+  return xSemaphore->count;
+}
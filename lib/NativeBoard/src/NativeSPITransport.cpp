@@ -0,0 +1,13 @@
+#include "NativeSPITransport.h"
+
+NativeSPITransport::NativeSPITransport(uint8_t cs, SPIClass *spiinterface)
+  : SPIMemoryArduinoTransport(cs, spiinterface), _spi(spiinterface) {}
+
+// The SPI model has all four data lines
+bool NativeSPITransport::supportsIOMode(uint8_t ioMode) {
+  return (ioMode == SPIMEMORY_IO_SINGLE || ioMode == SPIMEMORY_IO_DUAL || ioMode == SPIMEMORY_IO_QUAD || ioMode == SPIMEMORY_IO_QUADIO);
+}
+
+void NativeSPITransport::_setDataLines(uint8_t lines) {
+  _spi->setDataLines(lines);
+}
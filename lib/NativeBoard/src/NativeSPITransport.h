@@ -0,0 +1,29 @@
+#ifndef NATIVESPITRANSPORT_H
+#define NATIVESPITRANSPORT_H
+
+#include <SPIMemory.h>
+
+/**
+ * @brief SPIMemory transport for the SPI buses of the host board
+ *
+ * The Arduino transport of the library, plus the dual and quad data lines
+ * that SPIClass::setDataLines() models here (see SPI.h). With it, SPIFlash
+ * can use the 2- and 4-line read and program modes against W25Q32Emulator,
+ * as it would over a DMA transport on the ESP32:
+ *
+ *   NativeSPITransport flashBus(SPI_FLASH_CS);
+ *   SPIFlash flash(flashBus);
+ */
+class NativeSPITransport : public SPIMemoryArduinoTransport {
+public:
+  NativeSPITransport(uint8_t cs, SPIClass *spiinterface = &SPI);
+  bool supportsIOMode(uint8_t ioMode) override;
+
+protected:
+  void _setDataLines(uint8_t lines) override;
+
+private:
+  SPIClass *_spi;
+};
+
+#endif // NATIVESPITRANSPORT_H
@@ -0,0 +1,104 @@
+#include "Print.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::write(const char *str) {
+  if (!str) {
+    return 0;
+  }
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::printf(const char *format, ...) {
+  char stackBuf[128];
+  va_list args;
+  va_start(args, format);
+  va_list copy;
+  va_copy(copy, args);
+  int len = vsnprintf(stackBuf, sizeof(stackBuf), format, copy);
+  va_end(copy);
+  if (len < 0) {
+    va_end(args);
+    return 0;
+  }
+  if ((size_t)len < sizeof(stackBuf)) {
+    va_end(args);
+    return write((const uint8_t *)stackBuf, len);
+  }
+  std::vector<char> heapBuf(len + 1);
+  vsnprintf(heapBuf.data(), heapBuf.size(), format, args);
+  va_end(args);
+  return write((const uint8_t *)heapBuf.data(), len);
+}
+
+size_t Print::print(const String &str) {
+  return write((const uint8_t *)str.c_str(), str.length());
+}
+
+size_t Print::print(const char *str) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char num, int base) {
+  return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(int num, int base) {
+  return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(unsigned int num, int base) {
+  return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(long num, int base) {
+  return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(unsigned long num, int base) {
+  return print(String(num, (unsigned char)base));
+}
+
+size_t Print::print(long long num, int base) {
+  if (base == DEC) {
+    return printf("%lld", num);
+  }
+  return print((unsigned long long)num, base);
+}
+
+size_t Print::print(unsigned long long num, int base) {
+  if (base < 2 || base > 36) {
+    base = DEC;
+  }
+  String str;
+  do {
+    uint8_t digit = num % base;
+    str = String((char)(digit < 10 ? '0' + digit : 'A' + digit - 10)) + str;
+    num /= base;
+  } while (num);
+  return print(str);
+}
+
+size_t Print::print(double num, int digits) {
+  return print(String(num, (unsigned int)digits));
+}
+
+// Plain "\n" rather than the "\r\n" of the board, so the host logs can be diffed and grepped as they are
+size_t Print::println(void) {
+  return write((uint8_t)'\n');
+}
@@ -0,0 +1,45 @@
+#ifndef NATIVEBOARD_PRINT_H
+#define NATIVEBOARD_PRINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/**
+ * @brief Host implementation of the Arduino Print class
+ * Subclasses only provide write(); everything else is formatted here.
+ */
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str);
+  virtual void flush(void) {}
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+  size_t print(const String &str);
+  size_t print(const char *str);
+  size_t print(char c);
+  size_t print(unsigned char num, int base = DEC);
+  size_t print(int num, int base = DEC);
+  size_t print(unsigned int num, int base = DEC);
+  size_t print(long num, int base = DEC);
+  size_t print(unsigned long num, int base = DEC);
+  size_t print(long long num, int base = DEC);
+  size_t print(unsigned long long num, int base = DEC);
+  size_t print(double num, int digits = 2);
+
+  size_t println(void);
+  template <class T> size_t println(const T &value) { size_t n = print(value); return n + println(); }
+  template <class T> size_t println(const T &value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+#endif // NATIVEBOARD_PRINT_H
@@ -0,0 +1,49 @@
+#include "SPI.h"
+#include "NativeBoard.h"
+
+SPIClass SPI(VSPI);
+
+void SPIClass::begin(int8_t sck, int8_t miso, int8_t mosi, int8_t ss) {
+  (void)sck;
+  (void)miso;
+  (void)mosi;
+  (void)ss;
+}
+
+void SPIClass::end(void) {}
+
+void SPIClass::beginTransaction(SPISettings settings) {
+  _clock = settings._clock;
+}
+
+void SPIClass::endTransaction(void) {}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+  nativeBoardSync(_freeNs);
+  uint8_t in = nativeBoardTransfer(this, data, _clock, _dataLines);
+  _freeNs = nativeBoardNanos();
+  return in;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data) {
+  uint16_t out = transfer(data >> 8) << 8;
+  return out | transfer(data & 0xFF);
+}
+
+// Full duplex, in place - as on the ESP32 core the buffer is sent and overwritten with what comes back
+void SPIClass::transfer(void *data, uint32_t size) {
+  transferBytes((const uint8_t *)data, (uint8_t *)data, size);
+}
+
+void SPIClass::transferBytes(const uint8_t *data, uint8_t *out, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++) {
+    uint8_t in = transfer(data ? data[i] : 0xFF);
+    if (out) {
+      out[i] = in;
+    }
+  }
+}
+
+void SPIClass::writeBytes(const uint8_t *data, uint32_t size) {
+  transferBytes(data, NULL, size);
+}
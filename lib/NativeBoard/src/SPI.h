@@ -0,0 +1,73 @@
+#ifndef NATIVEBOARD_SPI_H
+#define NATIVEBOARD_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_HAS_TRANSACTION
+
+#define SPI_MODE0 0
+#define SPI_MODE1 1
+#define SPI_MODE2 2
+#define SPI_MODE3 3
+
+#define FSPI 1
+#define HSPI 2
+#define VSPI 3
+
+class SPISettings {
+public:
+  SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+    : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+  uint32_t _clock;
+  uint8_t _bitOrder;
+  uint8_t _dataMode;
+};
+
+/**
+ * @brief SPI master of the host board
+ * Bytes are exchanged with whichever NativeSPIDevice attached to this bus has
+ * its chip select low (see nativeAttachSPIDevice()). Nothing selected reads as
+ * 0xFF. Every byte advances the board clock by its wire time at the current
+ * clock speed and bus width. Each bus is its own wire: a task using it first
+ * catches up with the last task that did, while tasks on other buses carry on
+ * at the same time (see nativeBoardNanos()).
+ *
+ * setDataLines() stands in for the dual/quad modes of the ESP32 SPI
+ * peripheral: the bytes that follow go out on 2 or 4 lines, which the
+ * attached device sees and which shortens their wire time.
+ */
+class SPIClass {
+public:
+  SPIClass(uint8_t spi_bus = HSPI) : _spiNum(spi_bus) {}
+
+  void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1);
+  void end(void);
+
+  void beginTransaction(SPISettings settings);
+  void endTransaction(void);
+  void setFrequency(uint32_t freq) { _clock = freq; }
+  void setDataMode(uint8_t dataMode) { (void)dataMode; }
+  void setBitOrder(uint8_t bitOrder) { (void)bitOrder; }
+  void setDataLines(uint8_t lines) { _dataLines = (lines == 2 || lines == 4) ? lines : 1; }
+
+  uint8_t transfer(uint8_t data);
+  uint16_t transfer16(uint16_t data);
+  void transfer(void *data, uint32_t size);
+  void transferBytes(const uint8_t *data, uint8_t *out, uint32_t size);
+  void writeBytes(const uint8_t *data, uint32_t size);
+  void write(uint8_t data) { transfer(data); }
+
+  uint32_t getClock(void) const { return _clock; }
+  uint8_t getSpiNum(void) const { return _spiNum; }
+  uint8_t getDataLines(void) const { return _dataLines; }
+
+private:
+  uint8_t _spiNum;
+  uint32_t _clock = 1000000;
+  uint8_t _dataLines = 1;
+  uint64_t _freeNs = 0;     // Board time the last byte on the bus finished
+};
+
+extern SPIClass SPI;
+
+#endif // NATIVEBOARD_SPI_H
@@ -0,0 +1,43 @@
+#include "Arduino.h"
+
+int Stream::timedRead(void) {
+  unsigned long start = millis();
+  do {
+    int c = read();
+    if (c >= 0) {
+      return c;
+    }
+    delay(1);
+  } while (millis() - start < _timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int c = timedRead();
+    if (c < 0) {
+      break;
+    }
+    buffer[count++] = (uint8_t)c;
+  }
+  return count;
+}
+
+String Stream::readString(void) {
+  String str;
+  int c;
+  while ((c = timedRead()) >= 0) {
+    str += (char)c;
+  }
+  return str;
+}
+
+String Stream::readStringUntil(char terminator) {
+  String str;
+  int c;
+  while ((c = timedRead()) >= 0 && c != terminator) {
+    str += (char)c;
+  }
+  return str;
+}
@@ -0,0 +1,29 @@
+#ifndef NATIVEBOARD_STREAM_H
+#define NATIVEBOARD_STREAM_H
+
+#include "Print.h"
+
+/**
+ * @brief Host implementation of the Arduino Stream class
+ * Reads wait up to the stream timeout (1000 ms by default) for each character.
+ */
+class Stream : public Print {
+public:
+  virtual int available(void) = 0;
+  virtual int read(void) = 0;
+  virtual int peek(void) = 0;
+
+  void setTimeout(unsigned long timeout) { _timeout = timeout; }
+  unsigned long getTimeout(void) const { return _timeout; }
+
+  size_t readBytes(uint8_t *buffer, size_t length);
+  String readString(void);
+  String readStringUntil(char terminator);
+
+protected:
+  int timedRead(void);
+
+  unsigned long _timeout = 1000;
+};
+
+#endif // NATIVEBOARD_STREAM_H
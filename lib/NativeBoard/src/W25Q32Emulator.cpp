@@ -0,0 +1,634 @@
+#include "W25Q32Emulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Instructions (W25Q32JV datasheet, section 8)
+#define W25Q_WRITEENABLE        0x06
+#define W25Q_VOLATILEWREN       0x50
+#define W25Q_WRITEDISABLE       0x04
+#define W25Q_READSTAT1          0x05
+#define W25Q_READSTAT2          0x35
+#define W25Q_READSTAT3          0x15
+#define W25Q_WRITESTAT1         0x01
+#define W25Q_WRITESTAT2         0x31
+#define W25Q_WRITESTAT3         0x11
+#define W25Q_READDATA           0x03
+#define W25Q_FASTREAD           0x0B
+#define W25Q_FASTREAD_DUAL      0x3B
+#define W25Q_FASTREAD_QUAD      0x6B
+#define W25Q_FASTREAD_QUADIO    0xEB
+#define W25Q_PAGEPROG           0x02
+#define W25Q_PAGEPROG_QUAD      0x32
+#define W25Q_SECTORERASE        0x20
+#define W25Q_BLOCK32ERASE       0x52
+#define W25Q_BLOCK64ERASE       0xD8
+#define W25Q_CHIPERASE          0xC7
+#define W25Q_ALT_CHIPERASE      0x60
+#define W25Q_SUSPEND            0x75
+#define W25Q_RESUME             0x7A
+#define W25Q_POWERDOWN          0xB9
+#define W25Q_RELEASE            0xAB
+#define W25Q_MANID              0x90
+#define W25Q_JEDECID            0x9F
+#define W25Q_UNIQUEID           0x4B
+#define W25Q_READSFDP           0x5A
+#define W25Q_ENABLERESET        0x66
+#define W25Q_RESET              0x99
+
+// Status register bits
+#define W25Q_BUSY               0x01
+#define W25Q_WEL                0x02
+#define W25Q_SUS                0x80
+#define W25Q_QE                 0x02    // Status register 2
+
+#define W25Q_MANUFACTURER       0xEF
+#define W25Q_MEMORYTYPE         0x40
+#define W25Q_CAPACITYID         0x16
+#define W25Q_DEVICEID           0x15
+
+#define W25Q_SECTOR_SIZE        4096
+#define W25Q_BLOCK32_SIZE       32768
+#define W25Q_BLOCK64_SIZE       65536
+#define W25Q_READDATA_MAXCLK    50000000
+
+// Typical AC characteristics (W25Q32JV datasheet, section 9.6), in ns
+#define W25Q_tBP1               30000ULL        // First byte of a page program
+#define W25Q_tBP2               2500ULL         // Each additional byte
+#define W25Q_tPP                400000ULL       // Whole page
+#define W25Q_tSE                45000000ULL     // 4 KB sector erase
+#define W25Q_tBE1               120000000ULL    // 32 KB block erase
+#define W25Q_tBE2               150000000ULL    // 64 KB block erase
+#define W25Q_tCE                10000000000ULL  // Chip erase
+#define W25Q_tW                 10000000ULL     // Status register write
+#define W25Q_tSUS               20000ULL        // Suspend latency (maximum - no typical is given)
+#define W25Q_tRST               30000ULL        // Software reset
+#define W25Q_tRES1              3000ULL         // Release from power-down
+
+static const uint8_t uniqueID[8] = {0xD2, 0x63, 0x48, 0x3C, 0x17, 0x59, 0x2A, 0x1F};
+
+// SFDP header, one parameter header and the JEDEC Basic Flash Parameter Table at 0x80.
+// Erase and program times in DWORDs 10 and 11 are encoded to match the typical times above
+static const uint8_t sfdpTable[] = {
+  // 0x00: "SFDP", revision 1.5, one parameter header, unused
+  0x53, 0x46, 0x44, 0x50, 0x05, 0x01, 0x00, 0xFF,
+  // 0x08: parameter ID 0x00 (BFPT), revision 1.5, 16 DWORDs at 0x000080
+  0x00, 0x05, 0x01, 0x10, 0x80, 0x00, 0x00, 0xFF,
+  // 0x10 - 0x7F: unused
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  // 0x80: BFPT
+  0xE5, 0x20, 0xF9, 0xFF,   // DWORD 1: 4 KB erase with 20h, 3-byte addressing, 1-1-2/1-2-2/1-1-4/1-4-4 reads
+  0xFF, 0xFF, 0xFF, 0x01,   // DWORD 2: 32 Mbit
+  0x44, 0xEB, 0x08, 0x6B,   // DWORD 3-4: quad and dual fast read instructions
+  0x08, 0x3B, 0x42, 0xBB,
+  0xFE, 0xFF, 0xFF, 0xFF,   // DWORD 5-7: 2-2-2 and 4-4-4 reads not supported
+  0xFF, 0xFF, 0x00, 0x00,
+  0xFF, 0xFF, 0x40, 0xEB,
+  0x0C, 0x20, 0x0F, 0x52,   // DWORD 8-9: erase types 4 KB (20h), 32 KB (52h), 64 KB (D8h)
+  0x10, 0xD8, 0x00, 0x00,
+  0x23, 0x3A, 0xA5, 0x00,   // DWORD 10: typical erase times 48 / 128 / 160 ms, max 8x typical
+  0x82, 0xE5, 0x14, 0x41,   // DWORD 11: 256-byte pages, page 384 us, first byte 32 us, next bytes 3 us, chip 8 s
+  0xE9, 0x63, 0x76, 0x33,   // DWORD 12-13: program/erase suspend and resume with 75h / 7Ah
+  0x7A, 0x75, 0x7A, 0x75,
+  0xF7, 0xA2, 0xD5, 0x5C,   // DWORD 14: busy is polled with 05h, power-down with B9h / ABh
+  0x19, 0xF7, 0x4D, 0xFF,   // DWORD 15-16: QE in status register 2, soft reset with 66h / 99h
+  0xE9, 0x30, 0xF8, 0x80,
+};
+
+W25Q32Emulator::W25Q32Emulator(void) : _memory(W25Q32_CAPACITY, 0xFF) {
+  resetStats();
+  const char *scale = getenv("NATIVEBOARD_FLASH_TIME_SCALE");
+  if (scale) {
+    setTimeScale(atof(scale));
+  }
+  _imagePath = getenv("NATIVEBOARD_FLASH_IMAGE");
+  if (_imagePath) {
+    loadImage(_imagePath);
+  }
+}
+
+void W25Q32Emulator::setTimeScale(float scale) {
+  std::lock_guard<std::mutex> lock(_lock);
+  _timeScale = (scale < 0) ? 0 : scale;
+}
+
+W25Q32Emulator::Stats W25Q32Emulator::getStats(void) {
+  std::lock_guard<std::mutex> lock(_lock);
+  return _stats;
+}
+
+void W25Q32Emulator::resetStats(void) {
+  std::lock_guard<std::mutex> lock(_lock);
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+bool W25Q32Emulator::loadImage(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(_lock);
+  size_t n = fread(_memory.data(), 1, _memory.size(), file);
+  fclose(file);
+  return n == _memory.size();
+}
+
+bool W25Q32Emulator::saveImage(const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(_lock);
+  size_t n = fwrite(_memory.data(), 1, _memory.size(), file);
+  fclose(file);
+  return n == _memory.size();
+}
+
+void W25Q32Emulator::end(void) {
+  if (_imagePath) {
+    saveImage(_imagePath);
+  }
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                         Internal operations                        //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+// Completes the operation in progress once its time is up. WEL is cleared at the end of every program, erase and
+// status register write
+void W25Q32Emulator::_update(uint64_t now) {
+  if (_op != _NONE && !_suspended && now >= _opEndNs) {
+    if (_op != _RECOVER) {
+      _wel = false;
+    }
+    _op = _NONE;
+  }
+}
+
+bool W25Q32Emulator::_busy(uint64_t now) {
+  _update(now);
+  if (_suspended) {
+    return now < _suspendReadyNs;
+  }
+  return _op != _NONE;
+}
+
+uint8_t W25Q32Emulator::_status1(uint64_t now) {
+  // BUSY first - an operation that has just finished clears WEL along with it
+  bool busy = _busy(now);
+  uint8_t status = _sr1 & ~(W25Q_BUSY | W25Q_WEL);
+  if (_wel) {
+    status |= W25Q_WEL;
+  }
+  if (busy) {
+    status |= W25Q_BUSY;
+  }
+  return status;
+}
+
+void W25Q32Emulator::_startOperation(_operation op, uint64_t durationNs, uint32_t address, uint32_t size) {
+  uint64_t scaledNs = durationNs * _timeScale;
+  _op = op;
+  _opEndNs = nativeBoardNanos() + scaledNs;
+  _opAddress = address;
+  _opSize = size;
+  if (op != _RECOVER) {
+    _stats.busyTimeNs += scaledNs;
+  }
+}
+
+// The effect on the array is applied at once; the chip then stays busy for the time the operation takes, so
+// nothing can observe the array half-way
+void W25Q32Emulator::_erase(uint32_t address, uint32_t size, uint64_t timeNs) {
+  address &= ~(size - 1);
+  memset(&_memory[address], 0xFF, size);
+  _startOperation(_ERASE, timeNs, address, size);
+}
+
+void W25Q32Emulator::_writeStatus(bool volatileWrite) {
+  uint8_t count = _frameBytes - 1;
+  switch (_opcode) {
+    case W25Q_WRITESTAT1:
+      _sr1 = _statusBytes[0] & 0xFC;
+      if (count > 1) {
+        // Lock bits LB1-3 are one-time programmable
+        _sr2 = (_statusBytes[1] & 0x43) | ((_sr2 | _statusBytes[1]) & 0x38);
+      }
+      break;
+    case W25Q_WRITESTAT2:
+      _sr2 = (_statusBytes[0] & 0x43) | ((_sr2 | _statusBytes[0]) & 0x38);
+      break;
+    case W25Q_WRITESTAT3:
+      _sr3 = _statusBytes[0] & 0x64;
+      break;
+  }
+  _stats.statusWrites++;
+  if (!volatileWrite) {
+    _startOperation(_WRITESTATUS, W25Q_tW, 0, 0);
+  }
+}
+
+void W25Q32Emulator::_softReset(void) {
+  _wel = false;
+  _volatileWrite = false;
+  _suspended = false;
+  _poweredDown = false;
+  _startOperation(_RECOVER, W25Q_tRST, 0, 0);
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                              SPI frames                            //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+// Number of data lines byte <index> of the current frame is clocked over. The instruction is always on one line
+//  - 3Bh: address and 8 dummy clocks on 1 line, data on 2
+//  - 6Bh: address and 8 dummy clocks on 1 line, data on 4
+//  - EBh: address, mode byte and 4 dummy clocks (2 bytes) on 4 lines, data on 4
+//  - 32h: address on 1 line, data on 4
+uint8_t W25Q32Emulator::_lines(uint32_t index) {
+  if (index == 0) {
+    return 1;
+  }
+  switch (_opcode) {
+    case W25Q_FASTREAD_DUAL:
+      return (index >= 5) ? 2 : 1;
+    case W25Q_FASTREAD_QUAD:
+      return (index >= 5) ? 4 : 1;
+    case W25Q_FASTREAD_QUADIO:
+      return 4;
+    case W25Q_PAGEPROG_QUAD:
+      return (index >= 4) ? 4 : 1;
+    default:
+      return 1;
+  }
+}
+
+void W25Q32Emulator::select(void) {
+  std::lock_guard<std::mutex> lock(_lock);
+  _selected = true;
+  _frameBytes = 0;
+  _address = 0;
+  _ignored = false;
+  _pageBytes = 0;
+}
+
+uint8_t W25Q32Emulator::transfer(uint8_t data, uint32_t clockSpeed, uint8_t lines) {
+  std::lock_guard<std::mutex> lock(_lock);
+  if (!_selected) {
+    return 0xFF;
+  }
+  uint64_t now = nativeBoardNanos();
+  uint32_t index = _frameBytes++;
+
+  // An instruction on the wrong lines is garbage to the chip - the rest of the frame goes nowhere
+  if (index == 0 && lines != 1) {
+    _stats.commands++;
+    _stats.lineViolations++;
+    _ignored = true;
+    return 0xFF;
+  }
+  if (index > 0 && !_ignored && lines != _lines(index)) {
+    _stats.lineViolations++;
+  }
+
+  // Instruction byte: decide whether the chip will listen to the rest of the frame
+  if (index == 0) {
+    _opcode = data;
+    _stats.commands++;
+    bool busy = _busy(now);
+    bool allowed;
+    if (_poweredDown) {
+      allowed = (data == W25Q_RELEASE);
+    }
+    else if (busy) {
+      allowed = (data == W25Q_READSTAT1 || data == W25Q_READSTAT2 || data == W25Q_READSTAT3 ||
+                 data == W25Q_ENABLERESET || data == W25Q_RESET ||
+                 (data == W25Q_SUSPEND && (_op == _PROGRAM || _op == _ERASE) && !_suspended));
+    }
+    else if (_suspended) {
+      // Only reads, IDs and resume while an erase/program is suspended. (The chip would also take a page program
+      // to another sector during an erase suspend - the driver never does that.)
+      allowed = !(data == W25Q_PAGEPROG || data == W25Q_PAGEPROG_QUAD || data == W25Q_SECTORERASE || data == W25Q_BLOCK32ERASE ||
+                  data == W25Q_BLOCK64ERASE || data == W25Q_CHIPERASE || data == W25Q_ALT_CHIPERASE ||
+                  data == W25Q_WRITESTAT1 || data == W25Q_WRITESTAT2 || data == W25Q_WRITESTAT3 ||
+                  data == W25Q_SUSPEND);
+    }
+    else {
+      allowed = true;
+    }
+    if ((data == W25Q_FASTREAD_QUAD || data == W25Q_FASTREAD_QUADIO || data == W25Q_PAGEPROG_QUAD) && !(_sr2 & W25Q_QE)) {
+      // IO2 and IO3 are /WP and /HOLD while QE is clear
+      allowed = false;
+    }
+    if (!allowed) {
+      _ignored = true;
+      _stats.ignoredCommands++;
+    }
+    else if (data == W25Q_PAGEPROG || data == W25Q_PAGEPROG_QUAD) {
+      memset(_pageBuffer, 0xFF, sizeof(_pageBuffer));
+      memset(_latched, 0, sizeof(_latched));
+    }
+    else if (data == W25Q_READDATA || data == W25Q_FASTREAD || data == W25Q_FASTREAD_DUAL ||
+             data == W25Q_FASTREAD_QUAD || data == W25Q_FASTREAD_QUADIO) {
+      _stats.readCommands++;
+      if (data == W25Q_READDATA && clockSpeed > W25Q_READDATA_MAXCLK) {
+        _stats.clockViolations++;
+      }
+    }
+    return 0xFF;
+  }
+  if (_ignored) {
+    return 0xFF;
+  }
+
+  switch (_opcode) {
+    case W25Q_READDATA:
+    case W25Q_FASTREAD:
+    case W25Q_FASTREAD_DUAL:
+    case W25Q_FASTREAD_QUAD:
+    case W25Q_FASTREAD_QUADIO: {
+      uint32_t dataStart = (_opcode == W25Q_READDATA) ? 4 : ((_opcode == W25Q_FASTREAD_QUADIO) ? 7 : 5);
+      if (index <= 3) {
+        _address = ((_address << 8) | data) & (W25Q32_CAPACITY - 1);
+        return 0xFF;
+      }
+      if (index < dataStart) {
+        return 0xFF;
+      }
+      if (_suspended && _address >= _opAddress && _address < _opAddress + _opSize) {
+        _stats.suspendedReadViolations++;
+      }
+      uint8_t out = _memory[_address];
+      _address = (_address + 1) & (W25Q32_CAPACITY - 1);
+      _stats.bytesRead++;
+      return out;
+    }
+
+    case W25Q_PAGEPROG:
+    case W25Q_PAGEPROG_QUAD:
+      if (index <= 3) {
+        _address = ((_address << 8) | data) & (W25Q32_CAPACITY - 1);
+        return 0xFF;
+      }
+      // Bytes past the end of the page wrap around to its start and replace what was latched there
+      {
+        uint32_t offset = ((_address & 0xFF) + _pageBytes) % W25Q32_PAGE_SIZE;
+        _pageBuffer[offset] = data;
+        _latched[offset] = true;
+        _pageBytes++;
+      }
+      return 0xFF;
+
+    case W25Q_SECTORERASE:
+    case W25Q_BLOCK32ERASE:
+    case W25Q_BLOCK64ERASE:
+      if (index <= 3) {
+        _address = ((_address << 8) | data) & (W25Q32_CAPACITY - 1);
+      }
+      return 0xFF;
+
+    case W25Q_READSTAT1: {
+      uint8_t status = _status1(now);
+      _stats.statusReads++;
+      if (status & W25Q_BUSY) {
+        _stats.busyPolls++;
+      }
+      return status;
+    }
+
+    case W25Q_READSTAT2:
+      _stats.statusReads++;
+      return _sr2 | (_suspended ? W25Q_SUS : 0);
+
+    case W25Q_READSTAT3:
+      _stats.statusReads++;
+      return _sr3;
+
+    case W25Q_WRITESTAT1:
+    case W25Q_WRITESTAT2:
+    case W25Q_WRITESTAT3:
+      if (index <= 2) {
+        _statusBytes[index - 1] = data;
+      }
+      return 0xFF;
+
+    case W25Q_JEDECID: {
+      static const uint8_t jedec[3] = {W25Q_MANUFACTURER, W25Q_MEMORYTYPE, W25Q_CAPACITYID};
+      return (index <= 3) ? jedec[index - 1] : 0xFF;
+    }
+
+    case W25Q_MANID:
+      if (index <= 3) {
+        _address = (_address << 8) | data;
+        return 0xFF;
+      }
+      // Address bit 0 picks which of the two IDs comes first
+      return (((index - 4) + (_address & 0x01)) % 2) ? W25Q_DEVICEID : W25Q_MANUFACTURER;
+
+    case W25Q_RELEASE:
+      return (index >= 4) ? W25Q_DEVICEID : 0xFF;
+
+    case W25Q_UNIQUEID:
+      if (index <= 4) {
+        return 0xFF;
+      }
+      return (index - 5 < sizeof(uniqueID)) ? uniqueID[index - 5] : 0xFF;
+
+    case W25Q_READSFDP:
+      if (index <= 3) {
+        _address = ((_address << 8) | data) & 0xFFFFFF;
+        return 0xFF;
+      }
+      if (index == 4) {
+        return 0xFF;
+      }
+      {
+        uint8_t out = (_address < sizeof(sfdpTable)) ? sfdpTable[_address] : 0xFF;
+        _address++;
+        return out;
+      }
+
+    default:
+      return 0xFF;
+  }
+}
+
+void W25Q32Emulator::deselect(void) {
+  std::lock_guard<std::mutex> lock(_lock);
+  if (!_selected) {
+    return;
+  }
+  _selected = false;
+  if (_frameBytes && !_ignored) {
+    _execute(nativeBoardNanos());
+  }
+}
+
+// Instructions that act when chip select goes high. Each one has to have exactly the right number of bytes - the
+// chip ignores it otherwise
+void W25Q32Emulator::_execute(uint64_t now) {
+  bool accepted = true;
+  bool volatileWrite = _volatileWrite;
+  _volatileWrite = false;
+  bool resetEnabled = _resetEnabled;
+  _resetEnabled = false;
+
+  switch (_opcode) {
+    case W25Q_WRITEENABLE:
+      accepted = (_frameBytes == 1);
+      if (accepted) {
+        _wel = true;
+      }
+      break;
+
+    case W25Q_WRITEDISABLE:
+      accepted = (_frameBytes == 1);
+      if (accepted) {
+        _wel = false;
+      }
+      break;
+
+    case W25Q_VOLATILEWREN:
+      accepted = (_frameBytes == 1);
+      _volatileWrite = accepted;
+      break;
+
+    case W25Q_PAGEPROG:
+    case W25Q_PAGEPROG_QUAD: {
+      accepted = (_wel && _frameBytes >= 5);
+      if (!accepted) {
+        break;
+      }
+      uint32_t pageStart = _address & ~(W25Q32_PAGE_SIZE - 1);
+      uint32_t count = (_pageBytes < W25Q32_PAGE_SIZE) ? _pageBytes : W25Q32_PAGE_SIZE;
+      for (uint32_t i = 0; i < W25Q32_PAGE_SIZE; i++) {
+        uint8_t &cell = _memory[pageStart + i];
+        uint8_t raised = (uint8_t)(_pageBuffer[i] & ~cell);
+        if (_latched[i] && raised) {
+          _stats.programViolations += __builtin_popcount(raised);
+        }
+        cell &= _pageBuffer[i];
+      }
+      _stats.pagePrograms++;
+      _stats.bytesProgrammed += count;
+      uint64_t timeNs = W25Q_tBP1 + W25Q_tBP2 * (count - 1);
+      _startOperation(_PROGRAM, (timeNs < W25Q_tPP) ? timeNs : W25Q_tPP, pageStart, W25Q32_PAGE_SIZE);
+      break;
+    }
+
+    case W25Q_SECTORERASE:
+      accepted = (_wel && _frameBytes == 4);
+      if (accepted) {
+        _stats.sectorErases++;
+        _erase(_address, W25Q_SECTOR_SIZE, W25Q_tSE);
+      }
+      break;
+
+    case W25Q_BLOCK32ERASE:
+      accepted = (_wel && _frameBytes == 4);
+      if (accepted) {
+        _stats.block32Erases++;
+        _erase(_address, W25Q_BLOCK32_SIZE, W25Q_tBE1);
+      }
+      break;
+
+    case W25Q_BLOCK64ERASE:
+      accepted = (_wel && _frameBytes == 4);
+      if (accepted) {
+        _stats.block64Erases++;
+        _erase(_address, W25Q_BLOCK64_SIZE, W25Q_tBE2);
+      }
+      break;
+
+    case W25Q_CHIPERASE:
+    case W25Q_ALT_CHIPERASE:
+      accepted = (_wel && _frameBytes == 1);
+      if (accepted) {
+        _stats.chipErases++;
+        _erase(0, W25Q32_CAPACITY, W25Q_tCE);
+      }
+      break;
+
+    case W25Q_WRITESTAT1:
+    case W25Q_WRITESTAT2:
+    case W25Q_WRITESTAT3:
+      accepted = ((_wel || volatileWrite) && _frameBytes >= 2 && _frameBytes <= ((_opcode == W25Q_WRITESTAT1) ? 3 : 2));
+      if (accepted) {
+        _writeStatus(volatileWrite);
+      }
+      break;
+
+    case W25Q_SUSPEND:
+      accepted = (_frameBytes == 1 && (_op == _PROGRAM || _op == _ERASE) && !_suspended);
+      if (accepted) {
+        _remainingNs = (_opEndNs > now) ? _opEndNs - now : 0;
+        _suspended = true;
+        _suspendReadyNs = now + (uint64_t)(W25Q_tSUS * _timeScale);
+        _stats.suspends++;
+      }
+      break;
+
+    case W25Q_RESUME:
+      accepted = (_frameBytes == 1 && _suspended);
+      if (accepted) {
+        _suspended = false;
+        _opEndNs = now + _remainingNs;
+        _stats.resumes++;
+      }
+      break;
+
+    case W25Q_POWERDOWN:
+      accepted = (_frameBytes == 1);
+      _poweredDown = accepted;
+      break;
+
+    case W25Q_RELEASE:
+      if (_poweredDown) {
+        _poweredDown = false;
+        _startOperation(_RECOVER, W25Q_tRES1, 0, 0);
+      }
+      break;
+
+    case W25Q_ENABLERESET:
+      accepted = (_frameBytes == 1);
+      _resetEnabled = accepted;
+      break;
+
+    case W25Q_RESET:
+      accepted = (_frameBytes == 1 && resetEnabled);
+      if (accepted) {
+        _softReset();
+      }
+      break;
+
+    default:
+      break;
+  }
+  if (!accepted) {
+    _stats.ignoredCommands++;
+  }
+}
+
+void W25Q32Emulator::printStats(Print &out) {
+  Stats stats = getStats();
+  out.printf("[W25Q32] Commands: %llu (%llu ignored)\n", (unsigned long long)stats.commands, (unsigned long long)stats.ignoredCommands);
+  out.printf("[W25Q32] Reads: %llu commands, %llu bytes\n", (unsigned long long)stats.readCommands, (unsigned long long)stats.bytesRead);
+  out.printf("[W25Q32] Page programs: %llu, %llu bytes\n", (unsigned long long)stats.pagePrograms, (unsigned long long)stats.bytesProgrammed);
+  out.printf("[W25Q32] Erases: 4K %llu, 32K %llu, 64K %llu, chip %llu\n", (unsigned long long)stats.sectorErases,
+             (unsigned long long)stats.block32Erases, (unsigned long long)stats.block64Erases, (unsigned long long)stats.chipErases);
+  out.printf("[W25Q32] Status reads: %llu (%llu busy), status writes: %llu\n", (unsigned long long)stats.statusReads,
+             (unsigned long long)stats.busyPolls, (unsigned long long)stats.statusWrites);
+  out.printf("[W25Q32] Suspends: %llu, resumes: %llu\n", (unsigned long long)stats.suspends, (unsigned long long)stats.resumes);
+  out.printf("[W25Q32] Busy time: %.3f ms\n", stats.busyTimeNs / 1000000.0);
+  out.printf("[W25Q32] Violations: %llu bits programmed 0->1, %llu bytes read from a suspended sector, %llu reads over 50 MHz, "
+             "%llu bytes on the wrong lines\n",
+             (unsigned long long)stats.programViolations, (unsigned long long)stats.suspendedReadViolations,
+             (unsigned long long)stats.clockViolations, (unsigned long long)stats.lineViolations);
+}
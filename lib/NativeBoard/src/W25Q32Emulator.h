@@ -0,0 +1,132 @@
+#ifndef W25Q32EMULATOR_H
+#define W25Q32EMULATOR_H
+
+#include "NativeBoard.h"
+
+#include <mutex>
+#include <vector>
+
+#define W25Q32_CAPACITY      4194304
+#define W25Q32_PAGE_SIZE     256
+
+/**
+ * @brief Behavioral model of a Winbond W25Q32JV on the SPI bus
+ *
+ * Follows the datasheet closely enough to catch access-pattern bugs in the
+ * driver and to measure them:
+ *  - programming only clears bits (1 -> 0); asking for a 0 -> 1 is counted
+ *  - page program wraps around inside the 256-byte page
+ *  - erases work on 4 KB / 32 KB / 64 KB / whole-chip granularity only
+ *  - BUSY and WEL behave as in status register 1, and commands other than
+ *    status reads and suspend are ignored while BUSY is set
+ *  - program, erase and status register writes keep the chip busy for the
+ *    typical datasheet times (tBP1/tBP2/tPP, tSE, tBE1, tBE2, tCE, tW)
+ *  - erase/program suspend and resume, power-down, software reset, JEDEC,
+ *    manufacturer/device ID, unique ID and the SFDP table
+ *  - dual and quad reads (3Bh, 6Bh, EBh) and quad page program (32h). Every
+ *    phase has to come on the right number of lines, and the quad commands
+ *    are ignored while QE is clear
+ *
+ * Time is taken from the board clock, so a driver that polls BUSY advances
+ * it by the wire time of its status reads. NATIVEBOARD_FLASH_TIME_SCALE
+ * scales every busy time (e.g. 0.01 for quick runs, 0 for none), and
+ * NATIVEBOARD_FLASH_IMAGE names a file that the array is loaded from at
+ * start-up and saved to when the firmware stops.
+ */
+class W25Q32Emulator : public NativeSPIDevice {
+public:
+  struct Stats {
+    uint64_t commands;
+    uint64_t statusReads;               // Status register bytes clocked out
+    uint64_t busyPolls;                 // ... of which had BUSY set
+    uint64_t readCommands;
+    uint64_t bytesRead;
+    uint64_t pagePrograms;
+    uint64_t bytesProgrammed;
+    uint64_t sectorErases;
+    uint64_t block32Erases;
+    uint64_t block64Erases;
+    uint64_t chipErases;
+    uint64_t statusWrites;
+    uint64_t suspends;
+    uint64_t resumes;
+    uint64_t ignoredCommands;           // Sent while busy, powered down, without WEL or with the wrong length
+    uint64_t programViolations;         // Bits that were asked to go from 0 to 1
+    uint64_t suspendedReadViolations;   // Bytes read from the sector/page whose erase/program is suspended
+    uint64_t clockViolations;           // Read Data (03h) above 50 MHz
+    uint64_t lineViolations;            // Bytes clocked over the wrong number of data lines
+    uint64_t busyTimeNs;                // Sum of all program, erase and status write times
+  };
+
+  W25Q32Emulator(void);
+
+  void select(void) override;
+  void deselect(void) override;
+  uint8_t transfer(uint8_t data, uint32_t clockSpeed, uint8_t lines) override;
+  void printStats(Print &out) override;
+  void end(void) override;
+
+  /**
+   * @brief Scales every busy time. 1.0 is the typical datasheet time
+   */
+  void setTimeScale(float scale);
+
+  Stats getStats(void);
+  void resetStats(void);
+
+  bool loadImage(const char *path);
+  bool saveImage(const char *path);
+
+  /** @brief Direct access to the array, e.g. to check what the driver wrote */
+  const uint8_t *memory(void) const { return _memory.data(); }
+
+private:
+  enum _operation { _NONE, _PROGRAM, _ERASE, _WRITESTATUS, _RECOVER };   // _RECOVER --> tRST / tRES1
+
+  uint8_t _lines(uint32_t index);
+  void    _update(uint64_t now);
+  bool    _busy(uint64_t now);
+  uint8_t _status1(uint64_t now);
+  void    _startOperation(_operation op, uint64_t durationNs, uint32_t address, uint32_t size);
+  void    _execute(uint64_t now);
+  void    _erase(uint32_t address, uint32_t size, uint64_t timeNs);
+  void    _writeStatus(bool volatileWrite);
+  void    _softReset(void);
+
+  std::mutex _lock;
+  std::vector<uint8_t> _memory;
+  Stats    _stats;
+  float    _timeScale = 1.0;
+  const char *_imagePath = NULL;
+
+  // Status registers. BUSY, WEL and SUS are kept apart from the stored bits
+  uint8_t  _sr1 = 0x00;
+  uint8_t  _sr2 = 0x02;     // QE is set at the factory on the IQ parts
+  uint8_t  _sr3 = 0x60;
+  bool     _wel = false;
+  bool     _volatileWrite = false;   // Write Enable for Volatile Status Register (50h) was the last command
+  bool     _poweredDown = false;
+  bool     _resetEnabled = false;
+
+  // Operation in progress
+  _operation _op = _NONE;
+  uint64_t _opEndNs = 0;
+  uint32_t _opAddress = 0;
+  uint32_t _opSize = 0;
+  bool     _suspended = false;
+  uint64_t _suspendReadyNs = 0;
+  uint64_t _remainingNs = 0;
+
+  // Current frame (one chip select low period)
+  bool     _selected = false;
+  uint8_t  _opcode = 0;
+  uint32_t _frameBytes = 0;
+  uint32_t _address = 0;
+  bool     _ignored = false;
+  uint8_t  _statusBytes[2];
+  uint8_t  _pageBuffer[W25Q32_PAGE_SIZE];
+  bool     _latched[W25Q32_PAGE_SIZE];     // Bytes of the page that were sent - only these can ask for a 0 -> 1
+  uint32_t _pageBytes = 0;
+};
+
+#endif // W25Q32EMULATOR_H
@@ -0,0 +1,231 @@
+#include "WString.h"
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Formats an unsigned number in the given base (2-36), uppercase digits
+ */
+static std::string formatUnsigned(unsigned long long value, unsigned char base) {
+  if (base < 2 || base > 36) {
+    base = 10;
+  }
+  char digits[65];
+  int pos = sizeof(digits) - 1;
+  digits[pos] = '\0';
+  do {
+    uint8_t digit = value % base;
+    digits[--pos] = (digit < 10) ? ('0' + digit) : ('A' + digit - 10);
+    value /= base;
+  } while (value);
+  return std::string(&digits[pos]);
+}
+
+/**
+ * @brief Formats a signed number. Only base 10 gets a minus sign, as on the Arduino core
+ */
+static std::string formatSigned(long long value, unsigned char base) {
+  if (base == 10 && value < 0) {
+    return "-" + formatUnsigned(-(unsigned long long)value, base);
+  }
+  return formatUnsigned((unsigned long long)value, base);
+}
+
+static std::string formatFloat(double value, unsigned int decimalPlaces) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  return std::string(buf);
+}
+
+String::String(const char *cstr) : _buffer(cstr ? cstr : "") {}
+String::String(char c) : _buffer(1, c) {}
+String::String(unsigned char value, unsigned char base) : _buffer(formatUnsigned(value, base)) {}
+String::String(int value, unsigned char base) : _buffer(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : _buffer(formatUnsigned(value, base)) {}
+String::String(long value, unsigned char base) : _buffer(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : _buffer(formatUnsigned(value, base)) {}
+String::String(float value, unsigned int decimalPlaces) : _buffer(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned int decimalPlaces) : _buffer(formatFloat(value, decimalPlaces)) {}
+
+String &String::operator=(const char *cstr) {
+  _buffer = cstr ? cstr : "";
+  return *this;
+}
+
+bool String::reserve(unsigned int size) {
+  _buffer.reserve(size);
+  return true;
+}
+
+bool String::concat(const String &str) { _buffer += str._buffer; return true; }
+bool String::concat(const char *cstr) { if (!cstr) return false; _buffer += cstr; return true; }
+bool String::concat(char c) { _buffer += c; return true; }
+bool String::concat(unsigned char num) { _buffer += formatUnsigned(num, 10); return true; }
+bool String::concat(int num) { _buffer += formatSigned(num, 10); return true; }
+bool String::concat(unsigned int num) { _buffer += formatUnsigned(num, 10); return true; }
+bool String::concat(long num) { _buffer += formatSigned(num, 10); return true; }
+bool String::concat(unsigned long num) { _buffer += formatUnsigned(num, 10); return true; }
+bool String::concat(long long num) { _buffer += formatSigned(num, 10); return true; }
+bool String::concat(unsigned long long num) { _buffer += formatUnsigned(num, 10); return true; }
+bool String::concat(float num) { _buffer += formatFloat(num, 2); return true; }
+bool String::concat(double num) { _buffer += formatFloat(num, 2); return true; }
+
+bool String::equalsIgnoreCase(const String &str) const {
+  if (length() != str.length()) {
+    return false;
+  }
+  for (unsigned int i = 0; i < length(); i++) {
+    if (tolower((unsigned char)_buffer[i]) != tolower((unsigned char)str._buffer[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool String::startsWith(const String &prefix) const {
+  return _buffer.compare(0, prefix._buffer.length(), prefix._buffer) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  if (suffix.length() > length()) {
+    return false;
+  }
+  return _buffer.compare(length() - suffix.length(), suffix.length(), suffix._buffer) == 0;
+}
+
+char String::charAt(unsigned int index) const {
+  return (index < length()) ? _buffer[index] : 0;
+}
+
+void String::setCharAt(unsigned int index, char c) {
+  if (index < length()) {
+    _buffer[index] = c;
+  }
+}
+
+char &String::operator[](unsigned int index) {
+  static char dummy;
+  if (index >= length()) {
+    dummy = 0;
+    return dummy;
+  }
+  return _buffer[index];
+}
+
+void String::getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index) const {
+  if (!bufsize || !buf) {
+    return;
+  }
+  if (index >= length()) {
+    buf[0] = 0;
+    return;
+  }
+  unsigned int n = std::min(bufsize - 1, length() - index);
+  memcpy(buf, _buffer.data() + index, n);
+  buf[n] = 0;
+}
+
+void String::toCharArray(char *buf, unsigned int bufsize, unsigned int index) const {
+  getBytes((unsigned char *)buf, bufsize, index);
+}
+
+int String::indexOf(char c, unsigned int fromIndex) const {
+  size_t pos = _buffer.find(c, fromIndex);
+  return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::indexOf(const String &str, unsigned int fromIndex) const {
+  size_t pos = _buffer.find(str._buffer, fromIndex);
+  return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(char c) const {
+  size_t pos = _buffer.rfind(c);
+  return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+int String::lastIndexOf(const String &str) const {
+  size_t pos = _buffer.rfind(str._buffer);
+  return (pos == std::string::npos) ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int beginIndex) const {
+  return substring(beginIndex, length());
+}
+
+String String::substring(unsigned int beginIndex, unsigned int endIndex) const {
+  if (beginIndex > endIndex) {
+    std::swap(beginIndex, endIndex);
+  }
+  if (beginIndex >= length()) {
+    return String();
+  }
+  endIndex = std::min(endIndex, length());
+  return String(_buffer.substr(beginIndex, endIndex - beginIndex).c_str());
+}
+
+void String::replace(char find, char replace) {
+  std::replace(_buffer.begin(), _buffer.end(), find, replace);
+}
+
+void String::replace(const String &find, const String &replace) {
+  if (find.isEmpty()) {
+    return;
+  }
+  size_t pos = 0;
+  while ((pos = _buffer.find(find._buffer, pos)) != std::string::npos) {
+    _buffer.replace(pos, find.length(), replace._buffer);
+    pos += replace.length();
+  }
+}
+
+void String::remove(unsigned int index) {
+  if (index < length()) {
+    _buffer.erase(index);
+  }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+  if (index < length()) {
+    _buffer.erase(index, count);
+  }
+}
+
+void String::toLowerCase(void) {
+  for (char &c : _buffer) {
+    c = tolower((unsigned char)c);
+  }
+}
+
+void String::toUpperCase(void) {
+  for (char &c : _buffer) {
+    c = toupper((unsigned char)c);
+  }
+}
+
+void String::trim(void) {
+  size_t begin = 0;
+  size_t end = _buffer.length();
+  while (begin < end && isspace((unsigned char)_buffer[begin])) {
+    begin++;
+  }
+  while (end > begin && isspace((unsigned char)_buffer[end - 1])) {
+    end--;
+  }
+  _buffer = _buffer.substr(begin, end - begin);
+}
+
+long String::toInt(void) const {
+  return atol(_buffer.c_str());
+}
+
+float String::toFloat(void) const {
+  return (float)atof(_buffer.c_str());
+}
+
+double String::toDouble(void) const {
+  return atof(_buffer.c_str());
+}
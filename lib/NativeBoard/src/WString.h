@@ -0,0 +1,104 @@
+#ifndef NATIVEBOARD_WSTRING_H
+#define NATIVEBOARD_WSTRING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+/**
+ * @brief Host implementation of the Arduino String class
+ * Covers the subset of the API used by the firmware and SPIMemory. Numbers are
+ * formatted the way the Arduino core does (base 10, floats with 2 decimals).
+ */
+class String {
+public:
+  String(const char *cstr = "");
+  String(const String &str) = default;
+  String(String &&str) = default;
+  explicit String(char c);
+  explicit String(unsigned char value, unsigned char base = 10);
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned int decimalPlaces = 2);
+  explicit String(double value, unsigned int decimalPlaces = 2);
+
+  String &operator=(const String &rhs) = default;
+  String &operator=(String &&rhs) = default;
+  String &operator=(const char *cstr);
+
+  unsigned int length(void) const { return _buffer.length(); }
+  bool isEmpty(void) const { return _buffer.empty(); }
+  const char *c_str(void) const { return _buffer.c_str(); }
+  bool reserve(unsigned int size);
+
+  bool concat(const String &str);
+  bool concat(const char *cstr);
+  bool concat(char c);
+  bool concat(unsigned char num);
+  bool concat(int num);
+  bool concat(unsigned int num);
+  bool concat(long num);
+  bool concat(unsigned long num);
+  bool concat(long long num);
+  bool concat(unsigned long long num);
+  bool concat(float num);
+  bool concat(double num);
+
+  template <class T> String &operator+=(const T &rhs) { concat(rhs); return *this; }
+
+  bool equals(const String &str) const { return _buffer == str._buffer; }
+  bool equals(const char *cstr) const { return _buffer == (cstr ? cstr : ""); }
+  bool equalsIgnoreCase(const String &str) const;
+  bool operator==(const String &rhs) const { return equals(rhs); }
+  bool operator==(const char *cstr) const { return equals(cstr); }
+  bool operator!=(const String &rhs) const { return !equals(rhs); }
+  bool operator!=(const char *cstr) const { return !equals(cstr); }
+  bool operator<(const String &rhs) const { return _buffer < rhs._buffer; }
+  bool startsWith(const String &prefix) const;
+  bool endsWith(const String &suffix) const;
+
+  char charAt(unsigned int index) const;
+  void setCharAt(unsigned int index, char c);
+  char operator[](unsigned int index) const { return charAt(index); }
+  char &operator[](unsigned int index);
+  void getBytes(unsigned char *buf, unsigned int bufsize, unsigned int index = 0) const;
+  void toCharArray(char *buf, unsigned int bufsize, unsigned int index = 0) const;
+
+  int indexOf(char c, unsigned int fromIndex = 0) const;
+  int indexOf(const String &str, unsigned int fromIndex = 0) const;
+  int lastIndexOf(char c) const;
+  int lastIndexOf(const String &str) const;
+  String substring(unsigned int beginIndex) const;
+  String substring(unsigned int beginIndex, unsigned int endIndex) const;
+
+  void replace(char find, char replace);
+  void replace(const String &find, const String &replace);
+  void remove(unsigned int index);
+  void remove(unsigned int index, unsigned int count);
+  void toLowerCase(void);
+  void toUpperCase(void);
+  void trim(void);
+
+  long toInt(void) const;
+  float toFloat(void) const;
+  double toDouble(void) const;
+
+private:
+  std::string _buffer;
+};
+
+template <class T> String operator+(const String &lhs, const T &rhs) {
+  String _retVal(lhs);
+  _retVal.concat(rhs);
+  return _retVal;
+}
+
+inline String operator+(const char *lhs, const String &rhs) {
+  String _retVal(lhs);
+  _retVal.concat(rhs);
+  return _retVal;
+}
+
+#endif // NATIVEBOARD_WSTRING_H
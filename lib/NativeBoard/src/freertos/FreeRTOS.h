@@ -0,0 +1,31 @@
+#ifndef NATIVEBOARD_FREERTOS_H
+#define NATIVEBOARD_FREERTOS_H
+
+/**
+ * @file FreeRTOS.h
+ * @brief FreeRTOS shim for the host build
+ *
+ * Tasks are detached host threads and semaphores are built on std::mutex and
+ * std::condition_variable. Priorities and core affinity are accepted and
+ * ignored; the host scheduler decides. One tick is one millisecond.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE             ((BaseType_t)0)
+#define pdTRUE              ((BaseType_t)1)
+#define pdFAIL              pdFALSE
+#define pdPASS              pdTRUE
+
+#define portMAX_DELAY       ((TickType_t)0xFFFFFFFFUL)
+#define configTICK_RATE_HZ  1000
+#define portTICK_PERIOD_MS  ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((TickType_t)(xTimeInMs) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+#define tskNO_AFFINITY      0x7FFFFFFF
+
+#endif // NATIVEBOARD_FREERTOS_H
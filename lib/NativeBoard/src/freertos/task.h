@@ -0,0 +1,32 @@
+#ifndef NATIVEBOARD_TASK_H
+#define NATIVEBOARD_TASK_H
+
+#include "FreeRTOS.h"
+
+struct NativeTask;
+typedef NativeTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask,
+                                   BaseType_t xCoreID);
+
+inline BaseType_t xTaskCreate(TaskFunction_t pvTaskCode, const char *pcName, uint32_t usStackDepth,
+                              void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pvCreatedTask) {
+  return xTaskCreatePinnedToCore(pvTaskCode, pcName, usStackDepth, pvParameters, uxPriority, pvCreatedTask, tskNO_AFFINITY);
+}
+
+/**
+ * @brief Deletes a task
+ * Only a task deleting itself (NULL or its own handle) is supported - a host
+ * thread cannot be stopped from the outside. Other handles are ignored.
+ */
+void vTaskDelete(TaskHandle_t xTaskToDelete);
+
+void vTaskDelay(const TickType_t xTicksToDelay);
+TickType_t xTaskGetTickCount(void);
+UBaseType_t uxTaskGetNumberOfTasks(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+const char *pcTaskGetName(TaskHandle_t xTaskToQuery);
+
+#endif // NATIVEBOARD_TASK_H
@@ -0,0 +1,535 @@
+/*
+  |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|
+  |                                                              FlashBenchmark.ino                                                               |
+  |                                                               SPIMemory library                                                                |
+  |                                                                   v 3.4.0                                                                     |
+  |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|
+  |                                                                                                                                               |
+  |                  This program measures read and page program throughput (bytes/sec) of the flash memory at various transfer                   |
+  |              sizes and compares it to the raw wire speed of the SPI bus. Small transfers are dominated by the per-call overhead;              |
+  |                     large transfers should get close to the wire speed when the bulk (_nextBuf) transfer path is in use.                      |
+  |              On the ESP32, define BENCH_IDF_TRANSPORT to compare the SPIClass transport with the DMA (SPIMemoryIDFTransport) one.             |
+  |         With a second chip on the other SPI bus, define BENCH_SECOND_BUS to program both from one task and from a task on each core.          |
+  |                                                                                                                                               |
+  |                  WARNING: The benchmark erases and overwrites the last 64 KB of the flash memory chip (BENCH_REGION_SIZE).                    |
+  |                                                                                                                                               |
+  |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|
+*/
+
+#include<SPIMemory.h>
+
+#if defined(ARDUINO_SAMD_ZERO) && defined(SERIAL_PORT_USBVIRTUAL)
+// Required for Serial on Zero based boards
+#define Serial SERIAL_PORT_USBVIRTUAL
+#endif
+
+#if defined (SIMBLEE)
+#define BAUD_RATE 250000
+#else
+#define BAUD_RATE 115200
+#endif
+
+#define BENCH_REGION_SIZE KB(64)
+#define BENCH_BUFFER_SIZE KB(4)
+#define BENCH_READ_BYTES  KB(64)
+#define BENCH_PREPARE_US  300         // Time spent building each page in the pipelined program benchmark
+
+#if defined (ARDUINO_ARCH_ESP32)
+// Pinout used by the ESP32 Winbond W25Q32JVSSIQ logger
+#define FLASH_CLK   14
+#define FLASH_MISO  12
+#define FLASH_MOSI  13
+#define FLASH_CS    26
+//#define BENCH_IDF_TRANSPORT          // Uncomment to run the benchmark over the ESP-IDF DMA transport instead of SPIClass
+#if defined (BENCH_IDF_TRANSPORT)
+SPIMemoryIDFTransport flashBus(SPI2_HOST, FLASH_CLK, FLASH_MISO, FLASH_MOSI, FLASH_CS);
+SPIFlash flash(flashBus);
+#else
+SPIFlash flash(FLASH_CS);
+#endif
+//#define BENCH_SECOND_BUS             // Uncomment if a second chip is wired to the pins below
+#if defined (BENCH_SECOND_BUS)
+// SPI is the VSPI peripheral, on the HSPI pins above - the second chip goes on the HSPI peripheral, on the VSPI pins
+#define FLASH2_CLK  18
+#define FLASH2_MISO 19
+#define FLASH2_MOSI 23
+#define FLASH2_CS   5
+SPIClass flash2Bus(HSPI);
+SPIFlash flash2(FLASH2_CS, &flash2Bus);
+#endif
+#else
+//SPIFlash flash(SS1, &SPI1);       //Use this constructor if using an SPI bus other than the default SPI. Only works with chips with more than one hardware SPI bus
+SPIFlash flash;
+#endif
+
+uint8_t benchBuffer[BENCH_BUFFER_SIZE];
+uint32_t benchRegion;
+
+void readBenchmarks();
+void writeBenchmarks();
+void bulkBenchmarks();
+void beginBenchmarks();
+void smallWriteBenchmarks();
+void cacheBenchmarks();
+void eraseBenchmarks();
+void suspendBenchmarks();
+void dualBusBenchmarks();
+uint32_t timePipelinedWrite(bool async);
+uint32_t timeRandomReads(uint32_t count);
+
+void setup() {
+  Serial.begin(BAUD_RATE);
+#if defined (ARDUINO_ARCH_SAMD) || (__AVR_ATmega32U4__) || defined(ARCH_STM32)
+  while (!Serial) ; // Wait for Serial monitor to open
+#endif
+  delay(50); //Time to terminal get connected
+#if defined (ARDUINO_ARCH_ESP32) && !defined (BENCH_IDF_TRANSPORT)
+  SPI.begin(FLASH_CLK, FLASH_MISO, FLASH_MOSI, FLASH_CS);
+#endif
+  if (!flash.begin()) {
+    Serial.println(F("Flash memory could not be initialised"));
+    flash.error(VERBOSE);
+    return;
+  }
+  benchRegion = flash.getCapacity() - BENCH_REGION_SIZE;
+
+  Serial.println(F("~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ Flash Benchmark ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~"));
+  Serial.print(F("Capacity: "));
+  Serial.print(flash.getCapacity());
+  Serial.print(F(" bytes, wire speed: "));
+  Serial.print(SPI_CLK / 8);
+  Serial.println(F(" bytes/sec"));
+  Serial.println();
+
+  readBenchmarks();
+  writeBenchmarks();
+  bulkBenchmarks();
+  smallWriteBenchmarks();
+  cacheBenchmarks();
+  beginBenchmarks();
+  eraseBenchmarks();
+  suspendBenchmarks();
+  dualBusBenchmarks();
+}
+
+void loop() {
+
+}
+
+// Prints one result line in the form "label | bytes | time | bytes/sec | % of wire speed"
+void printResult(const char *label, uint32_t bytes, uint32_t timeTaken) {
+  float bytesPerSec = (timeTaken) ? ((float)bytes * 1000000.0 / timeTaken) : 0;
+  Serial.print(label);
+  Serial.print(F("\t"));
+  Serial.print(bytes);
+  Serial.print(F(" B\t"));
+  Serial.print(timeTaken);
+  Serial.print(F(" us\t"));
+  Serial.print((uint32_t)bytesPerSec);
+  Serial.print(F(" B/s\t"));
+  Serial.print(bytesPerSec * 100.0 / (SPI_CLK / 8));
+  Serial.println(F(" %"));
+}
+
+// Reads BENCH_READ_BYTES from the benchmark region in chunks of chunkSize bytes
+uint32_t timeRead(uint32_t chunkSize, bool fastRead) {
+  uint32_t _time = micros();
+  for (uint32_t offset = 0; offset < BENCH_READ_BYTES; offset += chunkSize) {
+    flash.readByteArray(benchRegion + (offset % BENCH_REGION_SIZE), benchBuffer, chunkSize, fastRead);
+  }
+  return micros() - _time;
+}
+
+// Reads count single bytes from random addresses in the benchmark region - dominated by per-command overhead
+uint32_t timeRandomReads(uint32_t count) {
+  uint32_t _time = micros();
+  for (uint32_t i = 0; i < count; i++) {
+    flash.readByte(benchRegion + random(BENCH_REGION_SIZE));
+  }
+  return micros() - _time;
+}
+
+void readBenchmarks() {
+  const uint32_t chunkSizes[] = {16, 64, 256, 1024, 4096};
+  char label[24];
+
+  uint32_t randomTime = timeRandomReads(1000);
+  Serial.print(F("Random readByte: "));
+  Serial.print(randomTime / 1000.0);
+  Serial.println(F(" us per byte"));
+
+  Serial.println(F("Read (readByteArray)"));
+  for (uint8_t i = 0; i < arrayLen(chunkSizes); i++) {
+    sprintf(label, "  %5lu B chunks", (unsigned long)chunkSizes[i]);
+    printResult(label, BENCH_READ_BYTES, timeRead(chunkSizes[i], false));
+  }
+  Serial.println(F("Fast read (readByteArray)"));
+  for (uint8_t i = 0; i < arrayLen(chunkSizes); i++) {
+    sprintf(label, "  %5lu B chunks", (unsigned long)chunkSizes[i]);
+    printResult(label, BENCH_READ_BYTES, timeRead(chunkSizes[i], true));
+  }
+  Serial.println();
+}
+
+// Programs the benchmark region in chunks of chunkSize bytes. Erase time is not included.
+uint32_t timeWrite(uint32_t chunkSize, bool errorCheck) {
+  for (uint32_t i = 0; i < BENCH_BUFFER_SIZE; i++) {
+    benchBuffer[i] = (uint8_t)(i + chunkSize);
+  }
+  flash.eraseBlock64K(benchRegion);
+  uint32_t _time = micros();
+  for (uint32_t offset = 0; offset < BENCH_REGION_SIZE; offset += chunkSize) {
+    if (!flash.writeByteArray(benchRegion + offset, benchBuffer, chunkSize, errorCheck)) {
+      Serial.print(F("Write failed at 0x"));
+      Serial.println(benchRegion + offset, HEX);
+      break;
+    }
+  }
+  return micros() - _time;
+}
+
+void writeBenchmarks() {
+  const uint32_t chunkSizes[] = {64, 256, 4096};
+  char label[24];
+
+  Serial.println(F("Program (writeByteArray, no error check)"));
+  for (uint8_t i = 0; i < arrayLen(chunkSizes); i++) {
+    sprintf(label, "  %5lu B chunks", (unsigned long)chunkSizes[i]);
+    printResult(label, BENCH_REGION_SIZE, timeWrite(chunkSizes[i], NOERRCHK));
+  }
+  Serial.println(F("Program (writeByteArray, error check)"));
+  for (uint8_t i = 0; i < arrayLen(chunkSizes); i++) {
+    sprintf(label, "  %5lu B chunks", (unsigned long)chunkSizes[i]);
+    printResult(label, BENCH_REGION_SIZE, timeWrite(chunkSizes[i], true));
+  }
+  Serial.println(F("Program (writeByteArray, 256 B chunks, by verify policy)"));
+  flash.setVerifyPolicy(SPIMEMORY_VERIFY_SAMPLED, 16);
+  printResult("  1 page in 16     ", BENCH_REGION_SIZE, timeWrite(256, true));
+  flash.setVerifyPolicy(SPIMEMORY_VERIFY_FULL);
+  Serial.println(F("Program + prepare next page (BENCH_PREPARE_US per page)"));
+  printResult("  writeByteArray  ", BENCH_REGION_SIZE, timePipelinedWrite(false));
+  printResult("  programPageAsync", BENCH_REGION_SIZE, timePipelinedWrite(true));
+  flash.eraseBlock64K(benchRegion);
+  Serial.println();
+}
+
+// Programs the benchmark region page by page, spending BENCH_PREPARE_US on building every page first - as a logger
+// assembling its next record would. writeByteArray() waits for each page to be verified; programPageAsync() returns
+// while the chip is still busy, so the preparation of the next page overlaps the program time of the last one
+uint32_t timePipelinedWrite(bool async) {
+  flash.eraseBlock64K(benchRegion);
+  uint32_t _time = micros();
+  for (uint32_t offset = 0; offset < BENCH_REGION_SIZE; offset += SPI_PAGESIZE) {
+    for (uint32_t i = 0; i < SPI_PAGESIZE; i++) {
+      benchBuffer[i] = (uint8_t)(offset + i);
+    }
+    delayMicroseconds(BENCH_PREPARE_US);
+    bool _written = async ? flash.programPageAsync(benchRegion + offset, benchBuffer, SPI_PAGESIZE)
+                          : flash.writeByteArray(benchRegion + offset, benchBuffer, SPI_PAGESIZE);
+    if (!_written) {
+      Serial.print(F("Write failed at 0x"));
+      Serial.println(benchRegion + offset, HEX);
+      break;
+    }
+  }
+  flash.awaitProgram();
+  return micros() - _time;
+}
+
+// Reads and programs the whole benchmark region in a single call, against the same work done in 256 B calls. The
+// difference is the per-call overhead (command, address, _prep() checks) that large transfers no longer pay for every
+// page. Needs a BENCH_REGION_SIZE buffer, so it is skipped on boards without the RAM
+void bulkBenchmarks() {
+  uint8_t *bulkBuffer = NULL;
+  if (sizeof(size_t) >= sizeof(uint32_t)) {
+    bulkBuffer = (uint8_t*) malloc(BENCH_REGION_SIZE);
+  }
+  if (!bulkBuffer) {
+    Serial.println(F("Bulk transfers skipped - not enough RAM for a 64 KB buffer"));
+    Serial.println();
+    return;
+  }
+  uint32_t _time;
+
+  Serial.println(F("Bulk transfers (64 KB in one call vs 256 B calls)"));
+  _time = micros();
+  flash.readByteArray(benchRegion, bulkBuffer, BENCH_REGION_SIZE);
+  printResult("  readByteArray, 1 call    ", BENCH_REGION_SIZE, micros() - _time);
+  printResult("  readByteArray, 256 calls ", BENCH_REGION_SIZE, timeRead(256, false));
+
+  for (uint32_t i = 0; i < BENCH_REGION_SIZE; i++) {
+    bulkBuffer[i] = (uint8_t)(i >> 3);
+  }
+  flash.eraseBlock64K(benchRegion);
+  _time = micros();
+  if (!flash.writeByteArray(benchRegion, bulkBuffer, BENCH_REGION_SIZE, NOERRCHK)) {
+    Serial.println(F("Bulk write failed"));
+  }
+  printResult("  writeByteArray, 1 call   ", BENCH_REGION_SIZE, micros() - _time);
+  printResult("  writeByteArray, 256 calls", BENCH_REGION_SIZE, timeWrite(256, NOERRCHK));
+  flash.eraseBlock64K(benchRegion);
+  free(bulkBuffer);
+  Serial.println();
+}
+
+// Logs 4 KB of 32-bit values one at a time, with writeULong() against SPIFlashWriteBuffer::writeULong(). Every
+// writeULong() is a program operation of its own; the write buffer programs each page once
+void smallWriteBenchmarks() {
+  const uint32_t _count = KB(4) / sizeof(uint32_t);
+  uint32_t _time;
+
+  Serial.println(F("Small writes (4 KB as 32-bit values)"));
+  flash.eraseSector(benchRegion);
+  _time = micros();
+  for (uint32_t i = 0; i < _count; i++) {
+    flash.writeULong(benchRegion + i * sizeof(uint32_t), i, NOERRCHK);
+  }
+  _time = micros() - _time;
+  Serial.print(F("  writeULong            \t"));
+  Serial.print(_time);
+  Serial.print(F(" us\t"));
+  Serial.print(_count);
+  Serial.println(F(" programs"));
+
+  flash.eraseSector(benchRegion);
+  SPIFlashWriteBuffer buffer(flash, 0, NOERRCHK);
+  _time = micros();
+  for (uint32_t i = 0; i < _count; i++) {
+    buffer.writeULong(benchRegion + i * sizeof(uint32_t), i);
+  }
+  buffer.flush();
+  _time = micros() - _time;
+  Serial.print(F("  SPIFlashWriteBuffer   \t"));
+  Serial.print(_time);
+  Serial.print(F(" us\t"));
+  Serial.print(buffer.pagePrograms());
+  Serial.println(F(" programs"));
+  Serial.println();
+
+  // 64 records of a 4 byte header, 56 byte body and 4 byte CRC - three writes each, or one gathered write
+  uint32_t _header = 0xA5A5A5A5, _crc = 0;
+  SPIFlash::iovec _record[3] = {{&_header, sizeof(_header)}, {benchBuffer, 56}, {&_crc, sizeof(_crc)}};
+  Serial.println(F("Records (64 x header + 56 B + CRC)"));
+  flash.eraseSector(benchRegion);
+  _time = micros();
+  for (uint32_t i = 0; i < 64; i++) {
+    flash.writeByteArray(benchRegion + i * 64, (uint8_t*)&_header, sizeof(_header), NOERRCHK);
+    flash.writeByteArray(benchRegion + i * 64 + 4, benchBuffer, 56, NOERRCHK);
+    flash.writeByteArray(benchRegion + i * 64 + 60, (uint8_t*)&_crc, sizeof(_crc), NOERRCHK);
+  }
+  _time = micros() - _time;
+  Serial.print(F("  3 x writeByteArray    \t"));
+  Serial.print(_time);
+  Serial.println(F(" us"));
+
+  flash.eraseSector(benchRegion);
+  _time = micros();
+  for (uint32_t i = 0; i < 64; i++) {
+    flash.writev(benchRegion + i * 64, _record, 3, NOERRCHK);
+  }
+  _time = micros() - _time;
+  Serial.print(F("  writev                \t"));
+  Serial.print(_time);
+  Serial.println(F(" us"));
+  Serial.println();
+}
+
+// Reads the benchmark region as 32-bit fields of 64-byte records, every record twice, and then as 32-byte chunks in
+// address order - once straight from the chip and once through a 16 page read cache with 2 pages of read-ahead
+uint32_t timeCachedReads(void) {
+  uint32_t _time = micros();
+  for (uint8_t pass = 0; pass < 2; pass++) {
+    for (uint32_t record = 0; record < KB(4); record += 64) {
+      for (uint32_t field = 0; field < 64; field += sizeof(uint32_t)) {
+        flash.readULong(benchRegion + record + field);
+      }
+    }
+  }
+  for (uint32_t offset = 0; offset < KB(16); offset += 32) {
+    flash.readByteArray(benchRegion + offset, benchBuffer, 32);
+  }
+  return micros() - _time;
+}
+
+void cacheBenchmarks() {
+  uint32_t _time;
+
+  Serial.println(F("Read cache (2 x 4 KB of 32-bit fields, 16 KB of 32 B chunks)"));
+  _time = timeCachedReads();
+  Serial.print(F("  no cache              \t"));
+  Serial.print(_time);
+  Serial.println(F(" us"));
+
+  flash.setReadCache(16, SPI_PAGESIZE, 2);
+  flash.resetCacheStats();
+  _time = timeCachedReads();
+  SPIFlash::cacheStats _stats = flash.getCacheStats();
+  flash.setReadCache(0);
+  Serial.print(F("  16 x 256 B cache      \t"));
+  Serial.print(_time);
+  Serial.print(F(" us\t"));
+  Serial.print(_stats.hits);
+  Serial.print(F(" hits, "));
+  Serial.print(_stats.misses);
+  Serial.print(F(" misses, "));
+  Serial.print(_stats.readAheads);
+  Serial.println(F(" read ahead"));
+  Serial.println();
+}
+
+// Times begin() against begin() with the parameters saved from it by getChipParams(), which only reads the JEDEC ID.
+// The difference is the SFDP discovery - only done when USES_SFDP is defined in SPIMemory.h
+void beginBenchmarks() {
+  SPIFlash::chipParams params;
+  uint32_t _time;
+
+  Serial.println(F("Start-up"));
+  _time = micros();
+  flash.begin();
+  _time = micros() - _time;
+  Serial.print(F("  begin()               \t"));
+  Serial.print(_time);
+  Serial.println(F(" us"));
+  flash.getChipParams(params);
+  _time = micros();
+  flash.begin(params);
+  _time = micros() - _time;
+  Serial.print(F("  begin(saved params)   \t"));
+  Serial.print(_time);
+  Serial.println(F(" us"));
+  Serial.println();
+}
+
+// Erases the benchmark region sector by sector, against eraseSection(), which plans a single 64KB block erase for it
+void eraseBenchmarks() {
+  SPIFlash::erasePlan plan;
+  uint32_t _time;
+
+  Serial.println(F("Erase"));
+  _time = micros();
+  for (uint32_t offset = 0; offset < BENCH_REGION_SIZE; offset += KB(4)) {
+    flash.eraseSector(benchRegion + offset);
+  }
+  _time = micros() - _time;
+  Serial.print(F("  eraseSector loop      \t"));
+  Serial.print(_time);
+  Serial.println(F(" us"));
+  flash.planErase(benchRegion, BENCH_REGION_SIZE, plan);
+  _time = micros();
+  flash.eraseSection(benchRegion, BENCH_REGION_SIZE);
+  _time = micros() - _time;
+  Serial.print(F("  eraseSection          \t"));
+  Serial.print(_time);
+  Serial.print(F(" us (estimated "));
+  Serial.print(plan.estimate);
+  Serial.println(F(" us)"));
+  Serial.println();
+}
+
+// Erases the benchmark region with eraseBlock64KAsync() and reads 64 bytes from just below it every 2 ms until it is done. Returns
+// the longest of these reads. Without suspends the first read waits for most of tBE2, with them every read is served
+// right away, until maxSuspends runs out
+uint32_t timeReadsDuringErase(uint8_t maxSuspends) {
+  uint32_t _longest = 0;
+  uint8_t _reads = 0;
+  flash.setReadSuspend(maxSuspends);
+  flash.eraseBlock64KAsync(benchRegion);
+  while (flash.eraseBusy()) {
+    uint32_t _time = micros();
+    flash.readByteArray(benchRegion - KB(4), benchBuffer, 64);     // Only read - the data there is left alone
+    _time = micros() - _time;
+    if ((!maxSuspends || _reads++ < maxSuspends) && _time > _longest) {
+      _longest = _time;
+    }
+    delayMicroseconds(2000);
+  }
+  flash.setReadSuspend(0);
+  return _longest;
+}
+
+// Read latency while a block erase is running, with reads waiting for it against reads suspending it
+void suspendBenchmarks() {
+  Serial.println(F("Reads during a 64KB erase"));
+  Serial.print(F("  waiting for the erase \t"));
+  Serial.print(timeReadsDuringErase(0));
+  Serial.println(F(" us (longest read)"));
+  Serial.print(F("  suspending the erase  \t"));
+  Serial.print(timeReadsDuringErase(16));
+  Serial.println(F(" us (longest read)"));
+  Serial.println();
+}
+
+#if defined (BENCH_SECOND_BUS)
+struct busBenchJob {
+  SPIFlash *chip;
+  SemaphoreHandle_t done;
+  bool success;
+};
+
+// Programs the last BENCH_REGION_SIZE bytes of a chip page by page, without verifying them, and waits for the last page
+bool writeChipRegion(SPIFlash &chip) {
+  uint32_t _region = chip.getCapacity() - BENCH_REGION_SIZE;
+  for (uint32_t offset = 0; offset < BENCH_REGION_SIZE; offset += SPI_PAGESIZE) {
+    if (!chip.programPageAsync(_region + offset, benchBuffer, SPI_PAGESIZE)) {
+      return false;
+    }
+  }
+  return chip.awaitProgram();
+}
+
+void busBenchTask(void *parameter) {
+  busBenchJob *job = (busBenchJob*) parameter;
+  job->success = writeChipRegion(*job->chip);
+  xSemaphoreGive(job->done);
+  vTaskDelete(NULL);
+}
+
+// Programs the benchmark region of both chips - one chip after the other from this task, then both at once from a
+// task on each core. Every SPIFlash only uses its own bus, so the two buses do not wait for each other
+void dualBusBenchmarks() {
+  flash2Bus.begin(FLASH2_CLK, FLASH2_MISO, FLASH2_MOSI, FLASH2_CS);
+  if (!flash2.begin()) {
+    Serial.println(F("Second chip could not be initialised"));
+    return;
+  }
+  SPIFlash *chips[2] = {&flash, &flash2};
+  for (uint32_t i = 0; i < SPI_PAGESIZE; i++) {
+    benchBuffer[i] = (uint8_t)i;
+  }
+  uint32_t _time;
+
+  Serial.println(F("Program both chips (programPageAsync, 2 x 64 KB)"));
+  for (uint8_t i = 0; i < 2; i++) {
+    chips[i]->eraseBlock64K(chips[i]->getCapacity() - BENCH_REGION_SIZE);
+  }
+  _time = micros();
+  bool _written = writeChipRegion(flash) && writeChipRegion(flash2);
+  printResult("  one after the other", 2 * BENCH_REGION_SIZE, micros() - _time);
+
+  busBenchJob jobs[2];
+  for (uint8_t i = 0; i < 2; i++) {
+    chips[i]->eraseBlock64K(chips[i]->getCapacity() - BENCH_REGION_SIZE);
+    jobs[i] = {chips[i], xSemaphoreCreateBinary(), false};
+  }
+  _time = micros();
+  for (uint8_t i = 0; i < 2; i++) {
+    xTaskCreatePinnedToCore(busBenchTask, "busBench", 4096, &jobs[i], 1, NULL, i);
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    xSemaphoreTake(jobs[i].done, portMAX_DELAY);
+    vSemaphoreDelete(jobs[i].done);
+    _written = _written && jobs[i].success;
+  }
+  printResult("  one task per core  ", 2 * BENCH_REGION_SIZE, micros() - _time);
+  if (!_written) {
+    Serial.println(F("Write failed"));
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    chips[i]->eraseBlock64K(chips[i]->getCapacity() - BENCH_REGION_SIZE);
+  }
+  Serial.println();
+}
+#else
+void dualBusBenchmarks() {
+}
+#endif
@@ -12,6 +12,10 @@
   |                                the process of address allocation when using a flash memory module. Please note                                |
   |                                         the special function used to get the size of the String object.                                       |
   |                                                                                                                                               |
+  |                               It then times getAddress() against stepping through the chip a slot at a time on a                              |
+  |                              chip that already holds BENCH_FILL bytes of data. The benchmark erases and overwrites                            |
+  |                                                       the first BENCH_FILL + 4 KB of the chip.                                                |
+  |                                                                                                                                               |
   |~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~|
 */
 #include<SPIMemory.h>
@@ -28,6 +32,9 @@
 #endif
 
 #define arrayLen(x) sizeof(x)/sizeof(x[0])
+#define BENCH_FILL      KB(256)     // Data already on the chip when the benchmark allocates
+#define BENCH_RECORD    32          // Size of every allocation
+#define BENCH_ALLOCS    100
 uint32_t strAddr[3], floatAddr[2], byteAddr[4];
 String testStr[] = {
   "Test String 0",
@@ -46,6 +53,7 @@ SPIFlash flash;
 
 void getAddresses();
 void writeData();
+void allocationBenchmark();
 
 void setup() {
   Serial.begin(BAUD_RATE);
@@ -65,6 +73,7 @@ void setup() {
 
   getAddresses();
   dataIO();
+  allocationBenchmark();
   //flash.eraseChip();      // Uncomment this if you would like to erase chip
 }
 
@@ -143,3 +152,60 @@ void dataIO() {
     _string = "";
   }
 }
+
+// Function to time getAddress() on a chip that already holds data
+void allocationBenchmark() {
+  uint8_t _page[256];
+  uint8_t _record[BENCH_RECORD];
+  uint32_t _start, _addr;
+
+  Serial.println();
+  Serial.println(F("getAddress() benchmark"));
+  flash.eraseSection(0, BENCH_FILL + KB(4));
+  memset(_page, 0x5A, sizeof(_page));
+  for (_addr = 0; _addr < BENCH_FILL; _addr += sizeof(_page)) {
+    flash.writeByteArray(_addr, _page, sizeof(_page), false);
+  }
+
+  // Stepping through the chip a slot at a time, as getAddress() used to - one read per slot passed over
+  uint32_t _probes = 0;
+  bool _blank = false;
+  _start = micros();
+  for (_addr = 0; !_blank; _addr += BENCH_RECORD) {
+    flash.readByteArray(_addr, _record, sizeof(_record));
+    _probes++;
+    _blank = true;
+    for (uint8_t i = 0; i < sizeof(_record); i++) {
+      _blank &= (_record[i] == 0xFF);
+    }
+  }
+  _start = micros() - _start;
+  Serial.print(F("Slot by slot: 0x"));
+  Serial.print(_addr - BENCH_RECORD, HEX);
+  Serial.print(F(" after "));
+  Serial.print(_probes);
+  Serial.print(F(" reads in "));
+  Serial.print(_start);
+  Serial.println(F(" us"));
+
+  // A second SPIFlash on the same chip starts allocating from address 0, as this sketch does after a reset
+  SPIFlash _logger;
+  _logger.begin();
+  _start = micros();
+  _addr = _logger.getAddress(BENCH_RECORD);
+  _start = micros() - _start;
+  Serial.print(F("getAddress(): 0x"));
+  Serial.print(_addr, HEX);
+  Serial.print(F(" in "));
+  Serial.print(_start);
+  Serial.println(F(" us"));
+
+  _start = micros();
+  for (uint8_t i = 0; i < BENCH_ALLOCS; i++) {
+    _logger.getAddress(BENCH_RECORD);
+  }
+  _start = micros() - _start;
+  Serial.print(F("Then "));
+  Serial.print(_start / BENCH_ALLOCS);
+  Serial.println(F(" us per getAddress()"));
+}
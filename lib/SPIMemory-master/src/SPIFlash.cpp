@@ -36,7 +36,25 @@ SPIFlash::SPIFlash(uint8_t cs) {
   pinMode(csPin, OUTPUT);
   CHIP_DESELECT
 }
-#elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32) || defined(ARDUINO_ARCH_ESP32)
+#elif defined (SPIMEMORY_TRANSPORT)
+// The chip select pin is set up by the transport when begin() is called
+SPIFlash::SPIFlash(uint8_t cs, SPIClass *spiinterface) : _defaultBus(cs, spiinterface) {
+  _spi = spiinterface;  //Sets SPI interface - if no user selection is made, this defaults to SPI
+  _bus = &_defaultBus;
+  _SPIInUse = (_spi == &SPI) ? STDSPI : ALTSPI;
+  csPin = cs;
+}
+
+//Lets the user choose how the chip is reached - e.g. SPIMemoryIDFTransport for DMA on the ESP32, or a mock on the host.
+//The transport has to outlive the SPIFlash object
+SPIFlash::SPIFlash(SPIMemoryTransport &transport) {
+  _spi = &SPI;
+  _bus = &transport;
+  _SPIInUse = ALTSPI;
+  csPin = CS;
+}
+
+#elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
 SPIFlash::SPIFlash(uint8_t cs, SPIClass *spiinterface) {
   _spi = spiinterface;  //Sets SPI interface - if no user selection is made, this defaults to SPI
   if (_spi == &SPI) {
@@ -98,6 +116,24 @@ SPIFlash::SPIFlash(uint8_t cs) {
 
 #endif
 
+// Frees the erased page map and the read cache
+SPIFlash::~SPIFlash(void) {
+  untrackErasedPages();
+  setReadCache(0);
+}
+
+// Chip identification tables. Shared by every instance
+const uint8_t SPIFlash::_capID[18]   =
+{0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x41, 0x42, 0x43, 0x4B, 0x00, 0x01, 0x13, 0x37};
+
+const uint32_t SPIFlash::_memSize[18]  =
+{KB(64), KB(128), KB(256), KB(512), MB(1), MB(2), MB(4), MB(8), MB(16), MB(32), MB(2), MB(4), MB(8), MB(8), KB(256), KB(512), MB(4), KB(512)};
+// To understand the _memSize definitions check defines.h
+
+const uint8_t SPIFlash::_supportedManID[9] = {WINBOND_MANID, MICROCHIP_MANID, CYPRESS_MANID, ADESTO_MANID, MICRON_MANID, ON_MANID, GIGA_MANID, AMIC_MANID, MACRONIX_MANID};
+
+const uint8_t SPIFlash::_altChipEraseReq[3] = {A25L512, M25P40, SST26};
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 //     Public functions used for read, write and erase operations     //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
@@ -112,6 +148,96 @@ bool SPIFlash::begin(uint32_t flashChipSize) {
   Serial.println(F("Highspeed mode initiated."));
   Serial.println();
 #endif
+  _beginBus();
+  bool retVal = _chipID(flashChipSize);
+  _endSPI();
+  chipPoweredDown = false;
+  _disableGlobalBlockProtect();
+  return retVal;
+}
+
+//Identifies the chip from the parameters an earlier begin() found out about it, saved with getChipParams() - e.g. in
+//EEPROM or NVS - instead of finding them out again. Only the JEDEC ID is read from the chip. Takes two arguments -
+//  1. params --> The saved parameters. They are used if they are intact, were saved by this version of the library and
+//                have the JEDEC ID of the chip
+//  2. flashChipSize --> As in begin(flashChipSize), for when params can't be used
+//When params can't be used, this is begin(flashChipSize) - and getChipParams() should be called to save them again
+bool SPIFlash::begin(const chipParams &params, uint32_t flashChipSize) {
+  if (params.version != SPIMEMORY_CHIPPARAMS_VERSION || params.crc != crc32(0, (const uint8_t *)&params, offsetof(chipParams, crc))) {
+    return begin(flashChipSize);
+  }
+  _beginBus();
+  _defaultChipParams();
+  bool retVal = _getJedecId();
+  _endSPI();
+  if (!retVal) {
+    return false;
+  }
+  if (_chip.manufacturerID != params.manufacturerID || _chip.memoryTypeID != params.memoryTypeID || _chip.capacityID != params.capacityID) {
+    return begin(flashChipSize);
+  }
+  eraseParam *_erase[5] = {&kb4Erase, &kb32Erase, &kb64Erase, &kb256Erase, &chipErase};
+  for (uint8_t i = 0; i < 5; i++) {
+    _erase[i]->supported = params.eraseSupported & (0x01 << i);
+    _erase[i]->opcode = params.eraseOpcode[i];
+    _erase[i]->time = params.eraseTime[i];
+  }
+  _chip.supported = params.chipFlags & 0x01;
+  _chip.supportedMan = params.chipFlags & 0x02;
+  _chip.sfdpAvailable = params.chipFlags & 0x04;
+  _chip.capacity = params.capacity;
+  _sfdpIOModes = params.sfdpIOModes;
+  _pageSize = params.pageSize;
+  _eraseTimeMultiplier = params.eraseTimeMultiplier;
+  _prgmTimeMultiplier = params.prgmTimeMultiplier;
+  _pagePrgmTime = params.pagePrgmTime;
+  _byteFirstPrgmTime = params.byteFirstPrgmTime;
+  _byteAddnlPrgmTime = params.byteAddnlPrgmTime;
+  chipPoweredDown = false;
+  _disableGlobalBlockProtect();
+  return true;
+}
+
+//Fills params with what begin() found out about the chip - its capacity, erase instructions and times, program times
+//and read modes - for begin(params) to use on the next start instead of reading them from the chip again.
+//Returns false if begin() has not identified a chip
+bool SPIFlash::getChipParams(chipParams &params) {
+  if (!_chip.capacity) {
+    _troubleshoot(CALLBEGIN);
+    return false;
+  }
+  memset(&params, 0, sizeof(params));    // The padding is part of the CRC
+  params.version = SPIMEMORY_CHIPPARAMS_VERSION;
+  params.manufacturerID = _chip.manufacturerID;
+  params.memoryTypeID = _chip.memoryTypeID;
+  params.capacityID = _chip.capacityID;
+  params.chipFlags = (_chip.supported ? 0x01 : 0) | (_chip.supportedMan ? 0x02 : 0) | (_chip.sfdpAvailable ? 0x04 : 0);
+  params.sfdpIOModes = _sfdpIOModes;
+  eraseParam *_erase[5] = {&kb4Erase, &kb32Erase, &kb64Erase, &kb256Erase, &chipErase};
+  for (uint8_t i = 0; i < 5; i++) {
+    params.eraseSupported |= _erase[i]->supported ? (0x01 << i) : 0;
+    params.eraseOpcode[i] = _erase[i]->opcode;
+    params.eraseTime[i] = _erase[i]->time;
+  }
+  params.capacity = _chip.capacity;
+  params.pageSize = _pageSize;
+  params.eraseTimeMultiplier = _eraseTimeMultiplier;
+  params.prgmTimeMultiplier = _prgmTimeMultiplier;
+  params.pagePrgmTime = _pagePrgmTime;
+  params.byteFirstPrgmTime = _byteFirstPrgmTime;
+  params.byteAddnlPrgmTime = _byteAddnlPrgmTime;
+  params.crc = crc32(0, (const uint8_t *)&params, offsetof(chipParams, crc));
+  return true;
+}
+
+//Starts the SPI bus and sets up its clock, and drops the cached lines and free space bound left from before - the chip
+//may have been written to since. The first half of every begin() - the chip is identified by the caller
+void SPIFlash::_beginBus(void) {
+  clearReadCache();
+  _freeFromKnown = false;
+#if defined (SPIMEMORY_TRANSPORT)
+  BEGIN_SPI
+#else
   if (_SPIInUse == ALTSPI) {
     #if defined (ARDUINO_ARCH_ESP32)
     SPI.begin(_nonStdSPI.sck, _nonStdSPI.miso, _nonStdSPI.mosi, _nonStdSPI.ss);
@@ -120,6 +246,7 @@ bool SPIFlash::begin(uint32_t flashChipSize) {
   else {
     BEGIN_SPI
   }
+#endif
 
 #ifdef SPI_HAS_TRANSACTION
   //Define the settings to be used by the SPI bus
@@ -131,11 +258,6 @@ bool SPIFlash::begin(uint32_t flashChipSize) {
     _clockdiv = SPI_CLOCK_DIV2;
   }
 #endif
-  bool retVal = _chipID(flashChipSize);
-  _endSPI();
-  chipPoweredDown = false;
-  _disableGlobalBlockProtect();
-  return retVal;
 }
 
 //Allows the setting of a custom clock speed for the SPI bus to communicate with the chip.
@@ -144,6 +266,9 @@ bool SPIFlash::begin(uint32_t flashChipSize) {
 void SPIFlash::setClock(uint32_t clockSpeed) {
   _settings = SPISettings(clockSpeed, MSBFIRST, SPI_MODE0);
   _SPISettingsSet = true;
+#if defined (SPIMEMORY_TRANSPORT)
+  _bus->setClock(clockSpeed);
+#endif
 }
 #else
 void SPIFlash::setClock(uint8_t clockdiv) {
@@ -151,6 +276,29 @@ void SPIFlash::setClock(uint8_t clockdiv) {
 }
 #endif
 
+//Chooses how many data lines are used by the array reads and page programs (readByteArray(), writeByteArray(), etc.)
+//Must be called after begin(). Takes one argument -
+//  1. ioMode --> SPIMEMORY_IO_SINGLE, SPIMEMORY_IO_DUAL (3Bh), SPIMEMORY_IO_QUAD (6Bh / 32h) or SPIMEMORY_IO_QUADIO (EBh / 32h).
+//                SPIMEMORY_IO_AUTO (default) picks the widest mode that both the chip and the transport support
+//The quad modes set the Quad Enable bit of the chip, after which its /WP and /HOLD pins no longer work as such.
+//Only Winbond chips are driven in the multi-line modes. Returns false (and stays in the current mode) if the mode is not supported
+bool SPIFlash::setIOMode(uint8_t ioMode) {
+  const uint8_t _modes[4] = {SPIMEMORY_IO_QUADIO, SPIMEMORY_IO_QUAD, SPIMEMORY_IO_DUAL, SPIMEMORY_IO_SINGLE};
+  for (uint8_t i = 0; i < 4; i++) {
+    if ((ioMode == SPIMEMORY_IO_AUTO || ioMode == _modes[i]) && _ioModeSupported(_modes[i])) {
+      _ioMode = _modes[i];
+      return true;
+    }
+  }
+  _troubleshoot(UNSUPPORTEDFUNC);
+  return false;
+}
+
+//Returns the I/O mode in use - one of SPIMEMORY_IO_SINGLE, SPIMEMORY_IO_DUAL, SPIMEMORY_IO_QUAD or SPIMEMORY_IO_QUADIO
+uint8_t SPIFlash::getIOMode(void) {
+  return _ioMode;
+}
+
 uint8_t SPIFlash::error(bool _verbosity) {
   if (!_verbosity) {
     return diagnostics.errorcode;
@@ -181,6 +329,92 @@ float SPIFlash::functionRunTime(void) {
 #endif
 }
 
+//Returns what the busy waits after one kind of operation have cost. Takes one argument -
+//  1. waitType --> SPIMEMORY_WAIT_PROGRAM, SPIMEMORY_WAIT_ERASE4K, SPIMEMORY_WAIT_ERASE32K, SPIMEMORY_WAIT_ERASE64K,
+//                  SPIMEMORY_WAIT_CHIPERASE or SPIMEMORY_WAIT_OTHER
+//yieldTime is the part of waitTime the CPU was free for other tasks, rather than polling the chip
+SPIFlash::waitStats SPIFlash::getWaitStats(uint8_t waitType) {
+  if (waitType >= SPIMEMORY_WAIT_TYPES) {
+    waitStats _none = {};
+    return _none;
+  }
+  return _waitStats[waitType];
+}
+
+//Clears the busy wait statistics of all operations
+void SPIFlash::resetWaitStats(void) {
+  memset(_waitStats, 0, sizeof(_waitStats));
+}
+
+//Chooses what a write with errorCheck = true reads back. Takes two arguments -
+//  1. policy --> SPIMEMORY_VERIFY_OFF, SPIMEMORY_VERIFY_FULL (default) or SPIMEMORY_VERIFY_SAMPLED
+//  2. sampleInterval --> With SPIMEMORY_VERIFY_SAMPLED, one page in every sampleInterval is verified
+void SPIFlash::setVerifyPolicy(uint8_t policy, uint16_t sampleInterval) {
+  if (policy > SPIMEMORY_VERIFY_SAMPLED) {
+    _troubleshoot(UNSUPPORTEDFUNC);
+    return;
+  }
+  _verifyPolicy = policy;
+  _verifyInterval = sampleInterval ? sampleInterval : 1;
+}
+
+//Returns the write verify policy in use
+uint8_t SPIFlash::getVerifyPolicy(void) {
+  return _verifyPolicy;
+}
+
+//Reads a range back and checks it against the CRC-32 of the data that was written there - for a check made once that
+//data is gone, e.g. of a log record stored with its CRC. Fails with ERRORCHKFAIL if the CRCs differ. Takes three arguments -
+//  1. _addr --> Address of the first byte
+//  2. size --> Number of bytes
+//  3. crc --> crc32(0, data, size) of the data
+bool SPIFlash::verifyCRC(uint32_t _addr, uint32_t size, uint32_t crc) {
+  if (!_prep(READDATA, _addr, size)) {
+    return false;
+  }
+  uint8_t _chunk[SPIMEMORY_VERIFY_CHUNK];
+  uint32_t _crcRead = 0;
+  uint32_t _offset = 0;
+  while (_offset < size) {
+    uint32_t _chunkAddr = (_addr + _offset) % _chip.capacity;     // Reads wrap to 0 at the end of the chip
+    uint32_t _len = size - _offset;
+    if (_len > SPIMEMORY_VERIFY_CHUNK) {
+      _len = SPIMEMORY_VERIFY_CHUNK;
+    }
+    if (_len > _chip.capacity - _chunkAddr) {
+      _len = _chip.capacity - _chunkAddr;
+    }
+    _currentAddress = _chunkAddr;
+    _addressOverflow = false;
+    _readData(false, _chunk, _len);
+    _crcRead = crc32(_crcRead, _chunk, _len);
+    _offset += _len;
+  }
+  _endSPI();
+  if (_crcRead != crc) {
+    _troubleshoot(ERRORCHKFAIL);
+    return false;
+  }
+  return true;
+}
+
+//Sets the policies of this instance - SPIMEMORY_POLICY_SAFE, or any of SPIMEMORY_POLICY_HIGHSPEED and
+//SPIMEMORY_POLICY_NOOVERFLOW ORed together. Starts as SPIMEMORY_POLICY_DEFAULT, which follows the HIGHSPEED and
+//DISABLEOVERFLOW build flags. Takes one argument -
+//  1. policy --> The policies to use from now on
+void SPIFlash::setPolicy(uint8_t policy) {
+  if (policy & ~(SPIMEMORY_POLICY_HIGHSPEED | SPIMEMORY_POLICY_NOOVERFLOW)) {
+    _troubleshoot(UNSUPPORTEDFUNC);
+    return;
+  }
+  _policy = policy;
+}
+
+//Returns the policies in use
+uint8_t SPIFlash::getPolicy(void) {
+  return _policy;
+}
+
 //Returns the library version as three bytes
 bool SPIFlash::libver(uint8_t *b1, uint8_t *b2, uint8_t *b3) {
   *b1 = SPIFLASH_LIBVER;
@@ -241,29 +475,42 @@ uint64_t SPIFlash::getUniqueID(void) {
 //Gets the next available address for use.
 // Takes the size of the data as an argument and returns a 32-bit address
 // This function can be called anytime - even if there is preexisting data on the flash chip. It will simply find the next empty address block for the data.
+// The first call finds where the data already on the chip ends with a binary search (see _findFreeFrom()), and addresses
+// are handed out from there on - each one costs a single read to check it is blank. Blank space between earlier data is
+// only looked for once the end of the chip has been reached
 uint32_t SPIFlash::getAddress(uint16_t size) {
   if (!_addressCheck(currentAddress, size)){
     return false;
 	}
-   while (!_notPrevWritten(currentAddress, size)) {
-     currentAddress+=size;
-    _currentAddress = currentAddress;
-    if (_currentAddress >= _chip.capacity) {
-      if (_loopedOver) {
-        return false;
-      }
-    #ifdef DISABLEOVERFLOW
+  if (!size) {
+    return currentAddress;
+  }
+  if (!_freeFromKnown) {
+    _findFreeFrom();
+  }
+  uint32_t _addr = currentAddress;
+  if (_addr < _freeFrom) {
+    _addr += ((_freeFrom - _addr + size - 1) / size) * size;   // First slot past the data, in steps of size as before
+  }
+  if (_addr < _chip.capacity && _findFree(_addr, size, _addr + size) != _addr) {
+    _addr = _findFree(_addr, size, _chip.capacity);               // Not blank after all - look further up in one read
+  }
+  if (_addr + size > _chip.capacity) {
+    if (_loopedOver) {
+      return false;
+    }
+    if (_policy & SPIMEMORY_POLICY_NOOVERFLOW) {
       _troubleshoot(OUTOFBOUNDS);
       return false;					// At end of memory - (!pageOverflow)
-    #else
-      currentAddress = 0x00;// At end of memory - (pageOverflow)
-      _loopedOver = true;
-    #endif
+    }
+    _loopedOver = true;                                 // At end of memory - (pageOverflow)
+    _addr = _findFree(0, size, _chip.capacity);
+    if (_addr + size > _chip.capacity) {
+      return false;
     }
   }
-		uint32_t _addr = currentAddress;
-		currentAddress+=size;
-		return _addr;
+  currentAddress = _addr + size;
+  return _addr;
 }
 
 //Function for returning the size of the string (only to be used for the getAddress() function)
@@ -309,18 +556,102 @@ bool  SPIFlash::readByteArray(uint32_t _addr, uint8_t *data_buffer, size_t buffe
   if (!_prep(READDATA, _addr, bufferSize)) {
     return false;
   }
-  if(fastRead) {
-    _beginSPI(FASTREAD);
+  _readData(fastRead, data_buffer, bufferSize);
+  _endSPI();
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros() - _spifuncruntime;
+  #endif
+	return true;
+}
+
+// Reads consecutive bytes into several buffers, one after the other - the counterpart of writev(). The range is read
+// with one read command, or from the read cache if it is small enough to go through it.
+//  Takes four arguments -
+//    1. _addr --> Any address from 0 to capacity
+//    2. vec --> The buffers, in the order they are filled. Empty ones are skipped
+//    3. count --> Number of buffers in vec
+//    4. fastRead --> defaults to false - executes _beginFastRead() if set to true
+bool SPIFlash::readv(uint32_t _addr, const iovec *vec, uint8_t count, bool fastRead) {
+  return _readv(_addr, vec, count, fastRead, true);
+}
+
+// As readv(). If cached is false, the range is read from the chip even if it is small enough to go through the read
+// cache - for a range that is read once, and would only push out what is in the cache
+bool SPIFlash::_readv(uint32_t _addr, const iovec *vec, uint8_t count, bool fastRead, bool cached) {
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros();
+  #endif
+  uint32_t _sz = _vecSize(vec, count);
+  if (!_sz || !_prep(READDATA, _addr, _sz)) {
+    return false;
+  }
+  if (cached && _cacheLines && !_addressOverflow && _sz <= ((uint32_t)_cacheLines * _cacheLineSize) / 2) {
+    for (uint8_t i = 0; i < count; i++) {
+      _readCached(fastRead, (uint8_t*) vec[i].iov_base, vec[i].iov_len);
+      _currentAddress += vec[i].iov_len;
+    }
   }
   else {
-    _beginSPI(READDATA);
+    _beginRead(fastRead);
+    for (uint8_t i = 0; i < count; i++) {
+      if (vec[i].iov_len) {
+        _readNext((uint8_t*) vec[i].iov_base, vec[i].iov_len);
+      }
+    }
+    _endRead();
   }
-  _nextBuf(READDATA, &(*data_buffer), bufferSize);
   _endSPI();
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros() - _spifuncruntime;
   #endif
-	return true;
+  return true;
+}
+
+// Reads a long range - up to the whole chip - with a single read command, and hands it to callback one chunk at a
+// time. Only chunk_buffer has to fit in RAM, and there is no command, address or chip select gap between chunks.
+// The bus is held from the first chunk to the last, so to let other users of the bus in, read a large range as a
+// few calls (e.g. of 64 KB each) and yield between them.
+//  Takes seven arguments -
+//    1. _addr --> Any address from 0 to capacity
+//    2. size --> Number of bytes to read
+//    3. chunk_buffer --> Buffer the chunks are read into
+//    4. chunkSize --> Size of chunk_buffer. The last chunk may be shorter
+//    5. callback --> Called with the address, data and size of every chunk. Returning false stops the read
+//    6. context --> Passed on to callback as is
+//    7. fastRead --> defaults to false - executes _beginFastRead() if set to true
+// Returns false if the read could not be started, or was stopped by callback
+bool SPIFlash::readStream(uint32_t _addr, uint32_t size, uint8_t *chunk_buffer, uint32_t chunkSize, streamCallback callback, void *context, bool fastRead) {
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros();
+  #endif
+  if (!chunk_buffer || !chunkSize || !callback) {
+    _troubleshoot(UNKNOWNERROR);
+    return false;
+  }
+  if (!_prep(READDATA, _addr, size)) {
+    return false;
+  }
+  bool _retVal = true;
+  uint32_t _chunkAddr = _currentAddress;
+  _beginRead(fastRead);
+  while (size) {
+    uint32_t _len = (size < chunkSize) ? size : chunkSize;
+    _readNext(chunk_buffer, _len);
+    _currentAddress = _chunkAddr;
+    _checkErasedPages(chunk_buffer, _len);
+    if (!callback(_chunkAddr, chunk_buffer, _len, context)) {
+      _retVal = false;
+      break;
+    }
+    _chunkAddr = (_chunkAddr + _len) % _chip.capacity;
+    size -= _len;
+  }
+  _endRead();
+  _endSPI();
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros() - _spifuncruntime;
+  #endif
+  return _retVal;
 }
 
 // Reads an array of chars starting from a specific location in a page..
@@ -336,13 +667,7 @@ bool  SPIFlash::readCharArray(uint32_t _addr, char *data_buffer, size_t bufferSi
   if (!_prep(READDATA, _addr, bufferSize)) {
     return false;
 	}
-  if(fastRead) {
-    _beginSPI(FASTREAD);
-  }
-  else {
-    _beginSPI(READDATA);
-  }
-  _nextBuf(READDATA, (uint8_t*) &(*data_buffer), bufferSize);
+  _readData(fastRead, (uint8_t*) data_buffer, bufferSize);
   _endSPI();
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros() - _spifuncruntime;
@@ -405,45 +730,70 @@ float SPIFlash::readFloat(uint32_t _addr, bool fastRead) {
 //    1. _addr --> Any address from 0 to capacity
 //    2. outputString --> String variable to write the output to
 //    3. fastRead --> defaults to false - executes _beginFastRead() if set to true
+// The characters are read SPIMEMORY_STR_CHUNK bytes at a time straight into the String, so the stack used does not
+// depend on the length of the string
 bool SPIFlash::readStr(uint32_t _addr, String &data, bool fastRead) {
-  //return _read(_addr, data, sizeof(data), fastRead, _STRING_);
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros();
   #endif
-
-  uint32_t _sz = 0;
-
-  if (!_prep(READDATA, _addr, _sz)) {
+  uint32_t _sz;
+  if (!_readStrSize(_addr, _sz, fastRead)) {
     return false;
   }
-  else {
-    if (fastRead) {
-      _beginSPI(FASTREAD);
-    }
-    else {
-      _beginSPI(READDATA);
-    }
-    for (uint16_t i = 0; i < sizeof(_sz); i++) {
-      _sz |= (_nextByte(READ) << (8*i));
-    }
+  data = "";
+  if (!data.reserve(_sz)) {
     _endSPI();
+    _troubleshoot(LOWRAM);
+    return false;
   }
+  char _chunk[SPIMEMORY_STR_CHUNK + 1];
+  for (uint32_t _offset = 0; _offset < _sz;) {
+    uint32_t _len = (_sz - _offset < SPIMEMORY_STR_CHUNK) ? (_sz - _offset) : SPIMEMORY_STR_CHUNK;
+    _readData(fastRead, (uint8_t*) _chunk, _len);
+    _chunk[_len] = '\0';
+    data += _chunk;
+    if (strlen(_chunk) < _len) {     // Up to the terminator, as String(char*) did
+      break;
+    }
+    _currentAddress = (_currentAddress + _len) % _chip.capacity;
+    _offset += _len;
+  }
+  _endSPI();
 
-  char _inChar[_sz];
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros() - _spifuncruntime;
+  #endif
+	return true;
+}
 
-  if (!_addressCheck((_addr + sizeof(_sz)), _sz) || !_notBusy()) {
+// Reads a string written by writeStr() into a buffer - without a String, and without using more memory than the buffer.
+//  Takes five arguments
+//    1. _addr --> Any address from 0 to capacity
+//    2. data_buffer --> Filled with the characters and a null terminator
+//    3. bufferSize --> Size of data_buffer. Must be at least the length of the string + 1
+//    4. length --> If not NULL, set to the length of the string, without the terminator - also when the buffer is too
+//                  small for it, so that the caller knows what size is needed. 0 if there is no string at _addr
+//    5. fastRead --> defaults to false - executes _beginFastRead() if set to true
+bool SPIFlash::readStr(uint32_t _addr, char *data_buffer, uint32_t bufferSize, uint32_t *length, bool fastRead) {
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros();
+  #endif
+  uint32_t _sz;
+  bool _found = _readStrSize(_addr, _sz, fastRead);
+  if (length) {
+    *length = _found ? _sz - 1 : 0;
+  }
+  if (!_found) {
     return false;
-	}
-  if(fastRead) {
-    _beginSPI(FASTREAD);
   }
-  else {
-    _beginSPI(READDATA);
+  if (!data_buffer || _sz > bufferSize) {
+    _endSPI();
+    _troubleshoot(OUTOFBOUNDS);
+    return false;
   }
-  _nextBuf(READDATA, (uint8_t*) &(*_inChar), _sz);
+  _readData(fastRead, (uint8_t*) data_buffer, _sz);
   _endSPI();
-
-  data = String(_inChar);
+  data_buffer[_sz - 1] = '\0';
 
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros() - _spifuncruntime;
@@ -471,7 +821,7 @@ bool SPIFlash::writeByte(uint32_t _addr, uint8_t data, bool errorCheck) {
   _nextByte(WRITE, data);
   CHIP_DESELECT
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, sizeof(data))) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -524,7 +874,7 @@ bool SPIFlash::writeChar(uint32_t _addr, int8_t data, bool errorCheck) {
   _nextByte(WRITE, data);
   CHIP_DESELECT
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, sizeof(data))) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -572,48 +922,11 @@ bool SPIFlash::writeByteArray(uint32_t _addr, uint8_t *data_buffer, size_t buffe
   if (!_prep(PAGEPROG, _addr, bufferSize)) {
     return false;
   }
-  uint16_t maxBytes = SPI_PAGESIZE-(_addr % SPI_PAGESIZE);  // Force the first set of bytes to stay within the first page
-
-  if (bufferSize <= maxBytes) {
-    CHIP_SELECT
-    _nextByte(WRITE, PAGEPROG);
-    _transferAddress();
-    //_nextBuf(PAGEPROG, &data_buffer[0], bufferSize);
-    for (uint16_t i = 0; i < bufferSize; ++i) {
-      _nextByte(WRITE, data_buffer[i]);
-    }
-    CHIP_DESELECT
-  }
-  else {
-    uint16_t length = bufferSize;
-    uint16_t writeBufSz;
-    uint16_t data_offset = 0;
-
-    do {
-      writeBufSz = (length<=maxBytes) ? length : maxBytes;
-
-      CHIP_SELECT
-      _nextByte(WRITE, PAGEPROG);
-      _transferAddress();
-      //_nextBuf(PAGEPROG, &data_buffer[data_offset], writeBufSz);
-      for (uint16_t i = 0; i < writeBufSz; ++i) {
-        _nextByte(WRITE, data_buffer[data_offset + i]);
-      }
-      CHIP_DESELECT
-
-      _currentAddress += writeBufSz;
-      data_offset += writeBufSz;
-      length -= writeBufSz;
-      maxBytes = 256;   // Now we can do up to 256 bytes per loop
-
-      if(!_notBusy() || !_writeEnable()){
-        return false;
-      }
-
-    } while (length > 0);
+  if (!_programPages(data_buffer, bufferSize)) {
+    return false;
   }
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, bufferSize)) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -621,82 +934,124 @@ bool SPIFlash::writeByteArray(uint32_t _addr, uint8_t *data_buffer, size_t buffe
     return true;
   }
   else {
-    if (!_notBusy()) {
-      return false;
-    }
-    _currentAddress = _addr;
-    CHIP_SELECT
-    _nextByte(WRITE, READDATA);
-    _transferAddress();
-    for (uint16_t j = 0; j < bufferSize; j++) {
-      if (_nextByte(READ) != data_buffer[j]) {
-        return false;
-      }
-    }
-    _endSPI();
+    bool _retVal = _verify(_addr, data_buffer, bufferSize);
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
     #endif
-    return true;
+    return _retVal;
   }
 }
 
-// Writes an array of bytes starting from a specific location in a page.
+// Writes several buffers one after the other, as if they were one array - e.g. a header, the fields of a struct and a
+// CRC - without copying them into one buffer first. The range is split into page programs as writeByteArray() does.
 //  Takes four arguments -
 //    1. _addr --> Any address - from 0 to capacity
-//    2. data_buffer --> The pointer to the array of chars be written to a particular location on a page
-//    3. bufferSize --> Size of the array of chars - in number of bytes
+//    2. vec --> The buffers, in the order they are written. Empty ones are skipped
+//    3. count --> Number of buffers in vec
 //    4. errorCheck --> Turned on by default. Checks for writing errors
 // WARNING: You can only write to previously erased memory locations (see datasheet).
 // Use the eraseSector()/eraseBlock32K/eraseBlock64K commands to first clear memory (write 0xFFs)
-bool SPIFlash::writeCharArray(uint32_t _addr, char *data_buffer, size_t bufferSize, bool errorCheck) {
+bool SPIFlash::writev(uint32_t _addr, const iovec *vec, uint8_t count, bool errorCheck) {
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros();
   #endif
-  if (!_prep(PAGEPROG, _addr, bufferSize)) {
+  uint32_t _sz = _vecSize(vec, count);
+  if (!_sz || !_prep(PAGEPROG, _addr, _sz)) {
+    return false;
+  }
+  if (!_programVec(vec, count, _sz)) {
     return false;
   }
-  uint16_t maxBytes = SPI_PAGESIZE-(_addr % SPI_PAGESIZE);  // Force the first set of bytes to stay within the first page
 
-  if (bufferSize <= maxBytes) {
-    CHIP_SELECT
-    _nextByte(WRITE, PAGEPROG);
-    _transferAddress();
-    //_nextBuf(PAGEPROG, &data_buffer[0], bufferSize);
-    for (uint16_t i = 0; i < bufferSize; ++i) {
-      _nextByte(WRITE, data_buffer[i]);
+  bool _retVal = true;
+  if (errorCheck) {
+    for (uint8_t i = 0; i < count && _retVal; i++) {
+      if (vec[i].iov_len && _verifyWanted(_addr, vec[i].iov_len)) {
+        _retVal = _verify(_addr, (const uint8_t*) vec[i].iov_base, vec[i].iov_len);
+      }
+      _addr = (_addr + vec[i].iov_len) % _chip.capacity;
     }
-    CHIP_DESELECT
   }
-  else {
-    uint16_t length = bufferSize;
-    uint16_t writeBufSz;
-    uint16_t data_offset = 0;
-
-    do {
-      writeBufSz = (length<=maxBytes) ? length : maxBytes;
-
-      CHIP_SELECT
-      _nextByte(WRITE, PAGEPROG);
-      _transferAddress();
-      for (uint16_t i = 0; i < writeBufSz; ++i) {
-        _nextByte(WRITE, data_buffer[data_offset + i]);
-      }
-      CHIP_DESELECT
+  _endSPI();
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros() - _spifuncruntime;
+  #endif
+  return _retVal;
+}
 
-      _currentAddress += writeBufSz;
-      data_offset += writeBufSz;
-      length -= writeBufSz;
-      maxBytes = 256;   // Now we can do up to 256 bytes per loop
+// Starts programming up to one page and returns as soon as the data has been sent. The chip programs the page (tPP)
+// while the caller gets on with the next one. Only one page can be in flight - if the previous one is still being
+// programmed, this waits for it first. Every other function waits for it too, so awaitProgram() is only needed to
+// know when the data is safe.
+//  Takes three arguments -
+//    1. _addr --> Any address - from 0 to capacity
+//    2. data_buffer --> The bytes to be programmed. Only has to stay valid until the function returns
+//    3. bufferSize --> Size of the array - in number of bytes. Must not run past the end of the page _addr is in
+// WARNING: You can only write to previously erased memory locations (see datasheet).
+// Use the eraseSector()/eraseBlock32K/eraseBlock64K commands to first clear memory (write 0xFFs)
+bool SPIFlash::programPageAsync(uint32_t _addr, const uint8_t *data_buffer, uint16_t bufferSize) {
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros();
+  #endif
+  if (!bufferSize || (_addr % SPI_PAGESIZE) + bufferSize > SPI_PAGESIZE) {
+    _troubleshoot(OUTOFBOUNDS);
+    return false;
+  }
+  if (!_prep(PAGEPROG, _addr, bufferSize)) {
+    return false;
+  }
+  if (!_programPage(data_buffer, bufferSize, false)) {   // Write enable has been sent by _prep()
+    return false;
+  }
+  _programPending = true;
+  _endSPI();
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros() - _spifuncruntime;
+  #endif
+  return true;
+}
 
-      if(!_notBusy() || !_writeEnable()){
-        return false;
-      }
+// Returns true while the page started by programPageAsync() is being programmed. Reads the status register once - never waits
+bool SPIFlash::programBusy(void) {
+  if (!_programPending) {
+    return false;
+  }
+  _readStat1();
+  _endSPI();
+  _programPending = (stat1 & BUSY);
+  return _programPending;
+}
 
-    } while (length > 0);
+// Waits for the page started by programPageAsync() to be programmed. Returns false if it takes longer than timeout (in microseconds)
+bool SPIFlash::awaitProgram(uint32_t timeout) {
+  if (!_programPending) {
+    return true;
   }
+  bool _retVal = _notBusy(timeout);
+  _endSPI();
+  return _retVal;
+}
 
-  if (!errorCheck) {
+// Writes an array of bytes starting from a specific location in a page.
+//  Takes four arguments -
+//    1. _addr --> Any address - from 0 to capacity
+//    2. data_buffer --> The pointer to the array of chars be written to a particular location on a page
+//    3. bufferSize --> Size of the array of chars - in number of bytes
+//    4. errorCheck --> Turned on by default. Checks for writing errors
+// WARNING: You can only write to previously erased memory locations (see datasheet).
+// Use the eraseSector()/eraseBlock32K/eraseBlock64K commands to first clear memory (write 0xFFs)
+bool SPIFlash::writeCharArray(uint32_t _addr, char *data_buffer, size_t bufferSize, bool errorCheck) {
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros();
+  #endif
+  if (!_prep(PAGEPROG, _addr, bufferSize)) {
+    return false;
+  }
+  if (!_programPages((uint8_t*) data_buffer, bufferSize)) {
+    return false;
+  }
+
+  if (!errorCheck || !_verifyWanted(_addr, bufferSize)) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -704,23 +1059,11 @@ bool SPIFlash::writeCharArray(uint32_t _addr, char *data_buffer, size_t bufferSi
     return true;
   }
   else {
-    if (!_notBusy()) {
-      return false;
-    }
-    _currentAddress = _addr;
-    CHIP_SELECT
-    _nextByte(WRITE, READDATA);
-    _transferAddress();
-    for (uint16_t j = 0; j < bufferSize; j++) {
-      if ((char)_nextByte(READ) != data_buffer[j]) {
-        return false;
-      }
-    }
-    _endSPI();
+    bool _retVal = _verify(_addr, (uint8_t*) data_buffer, bufferSize);
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
     #endif
-    return true;
+    return _retVal;
   }
 }
 
@@ -746,7 +1089,7 @@ bool SPIFlash::writeWord(uint32_t _addr, uint16_t data, bool errorCheck) {
   }
   CHIP_DESELECT
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, sizeof(data))) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -804,7 +1147,7 @@ bool SPIFlash::writeShort(uint32_t _addr, int16_t data, bool errorCheck) {
   }
   CHIP_DESELECT
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, sizeof(data))) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -862,7 +1205,7 @@ bool SPIFlash::writeULong(uint32_t _addr, uint32_t data, bool errorCheck) {
   }
   CHIP_DESELECT
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, sizeof(data))) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -920,7 +1263,7 @@ bool SPIFlash::writeLong(uint32_t _addr, int32_t data, bool errorCheck) {
   }
   CHIP_DESELECT
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, sizeof(data))) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -984,7 +1327,7 @@ bool SPIFlash::writeFloat(uint32_t _addr, float data, bool errorCheck) {
   }
   CHIP_DESELECT
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, sizeof(data))) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -1027,197 +1370,181 @@ bool SPIFlash::writeFloat(uint32_t _addr, float data, bool errorCheck) {
 //    3. errorCheck --> Turned on by default. Checks for writing errors
 // WARNING: You can only write to previously erased memory locations (see datasheet).
 // Use the eraseSector()/eraseBlock32K/eraseBlock64K commands to first clear memory (write 0xFFs)
-bool SPIFlash::writeStr(uint32_t _addr, String &data, bool errorCheck) {
+bool SPIFlash::writeStr(uint32_t _addr, const String &data, bool errorCheck) {
+  return writeStr(_addr, data.c_str(), data.length(), errorCheck);
+}
 
-  #ifdef RUNDIAGNOSTIC
-  _spifuncruntime = micros();
-  #endif
+// Writes length characters as a string that readStr() reads back - its size, null terminator included, as a 32-bit
+// number, then the characters and the terminator. They are programmed straight from data, with one range check and
+// one page program sequence for all three (see writev()), so no copy of the string is made.
+//  Takes four arguments -
+//    1. _addr --> Any address - from 0 to capacity
+//    2. data --> The characters. Need not be null terminated
+//    3. length --> Number of characters
+//    4. errorCheck --> Turned on by default. Checks for writing errors
+// WARNING: You can only write to previously erased memory locations (see datasheet).
+// Use the eraseSector()/eraseBlock32K/eraseBlock64K commands to first clear memory (write 0xFFs)
+bool SPIFlash::writeStr(uint32_t _addr, const char *data, uint32_t length, bool errorCheck) {
+  uint32_t _sz = length + 1;
+  uint8_t _header[sizeof(_sz)];
+  for (uint8_t i = 0; i < sizeof(_sz); i++) {
+    _header[i] = _sz >> (8*i);
+  }
+  char _terminator = '\0';
+  iovec _vec[3] = {{_header, sizeof(_header)}, {(void*) data, length}, {&_terminator, sizeof(_terminator)}};
+  return writev(_addr, _vec, 3, errorCheck);
+}
 
-  uint32_t _sz = (sizeof(char)*(data.length()+1));
 
-  char _outCharArray[_sz];
-  data.toCharArray(_outCharArray, _sz);
 
-  if(_isChipPoweredDown() || !_addressCheck(_addr, sizeof(_sz)) || !_notPrevWritten(_addr, sizeof(_sz)+_sz) || !_notBusy() || !_writeEnable()) {
+// Starts keeping a map of the pages that are known to be erased - one bit per page, so 2 KB of RAM for a 4 MB chip.
+// While a page is marked erased, a write to it skips the _notPrevWritten() readback. Pages are marked by the erase
+// functions and by array reads that cover a whole page of 0xFF, and unmarked when they are programmed. A page that is
+// not marked is read back as before. Takes one argument -
+//  1. scan --> Reads the whole chip once to fill the map. Otherwise the map starts empty and fills as the chip is used
+bool SPIFlash::trackErasedPages(bool scan) {
+  if (!_chip.capacity) {
+    _troubleshoot(CALLBEGIN);
     return false;
   }
-
-  _beginSPI(PAGEPROG);
-  for (uint8_t i = 0; i < sizeof(_sz); i++) {
-    _nextByte(WRITE, _sz >> (8*i));
+  if (!_erasedPages) {
+    _erasedPages = (uint8_t*) calloc(((_chip.capacity / SPI_PAGESIZE) + 7) / 8, 1);
+    if (!_erasedPages) {
+      _troubleshoot(LOWRAM);
+      return false;
+    }
   }
-  CHIP_DESELECT
-  _endSPI();
+  if (scan) {
+    // Every blank page the stream goes past is marked - there is nothing else to do with the data
+    uint8_t _page[SPI_PAGESIZE];
+    return readStream(0, _chip.capacity, _page, SPI_PAGESIZE, [](uint32_t, const uint8_t*, uint32_t, void*) { return true; });
+  }
+  return true;
+}
+
+//Stops tracking erased pages and frees the map
+void SPIFlash::untrackErasedPages(void) {
+  free(_erasedPages);
+  _erasedPages = NULL;
+}
 
-  if(!_addressCheck(_addr+sizeof(_sz), _sz) || !_notBusy() || !_writeEnable()) {
+//Returns true if the page containing _addr is known to be erased. false if it has been programmed, or is not known
+bool SPIFlash::isPageErased(uint32_t _addr) {
+  return _knownErased(_addr, 1);
+}
+
+// Keeps the last chip reads in RAM, so that reading the same lines again - a record read field by field, a page read
+// over and over - does not go to the chip. Lines are replaced least recently read first. A miss on the line after the
+// last one read also reads the next readAhead lines, with the same read command. Programs and erases made through this
+// object drop the lines they touch; writes made any other way (another SPIFlash object on the same chip, a bootloader)
+// are not seen, so call clearReadCache() after them. Reads of more than half the cache, and stream reads, bypass it.
+//  Takes three arguments -
+//    1. lines --> Lines to keep. lines * lineSize bytes of RAM are allocated. 0 frees the cache
+//    2. lineSize --> Bytes per line - a power of two from 256 (a page) to 4096 (a sector)
+//    3. readAhead --> Lines read past a sequential miss, less than lines and at most SPIMEMORY_CACHE_MAX_READAHEAD.
+//                     0 to only read what is asked for
+bool SPIFlash::setReadCache(uint8_t lines, uint16_t lineSize, uint8_t readAhead) {
+  free(_cacheData);
+  free(_cacheTags);
+  free(_cacheUsed);
+  _cacheData = NULL;
+  _cacheTags = _cacheUsed = NULL;
+  _cacheLines = 0;
+  if (!lines) {
+    return true;
+  }
+  if (lineSize < SPI_PAGESIZE || lineSize > KB(4) || (lineSize & (lineSize - 1)) || readAhead >= lines ||
+      readAhead > SPIMEMORY_CACHE_MAX_READAHEAD) {
+    _troubleshoot(UNSUPPORTEDFUNC);
     return false;
   }
-  uint16_t maxBytes = SPI_PAGESIZE-(_addr % SPI_PAGESIZE);  // Force the first set of bytes to stay within the first page
+  _cacheData = (uint8_t*) malloc((uint32_t)lines * lineSize);
+  _cacheTags = (uint32_t*) malloc(lines * sizeof(uint32_t));
+  _cacheUsed = (uint32_t*) malloc(lines * sizeof(uint32_t));
+  if (!_cacheData || !_cacheTags || !_cacheUsed) {
+    setReadCache(0);
+    _troubleshoot(LOWRAM);
+    return false;
+  }
+  _cacheLines = lines;
+  _cacheLineSize = lineSize;
+  _cacheReadAhead = readAhead;
+  clearReadCache();
+  return true;
+}
 
-  if (_sz <= maxBytes) {
-    CHIP_SELECT
-    _nextByte(WRITE, PAGEPROG);
-    _transferAddress();
-    //_nextBuf(PAGEPROG, &_outCharArray[0], _sz);
-    for (uint16_t i = 0; i < _sz; ++i) {
-      _nextByte(WRITE, _outCharArray[i]);
-    }
-    CHIP_DESELECT
+//Drops every cached line, i.e. after the chip has been written to by something other than this object
+void SPIFlash::clearReadCache(void) {
+  for (uint8_t i = 0; i < _cacheLines; i++) {
+    _cacheTags[i] = SPIMEMORY_CACHE_EMPTY;
+    _cacheUsed[i] = 0;
   }
-  else {
-    uint16_t length = _sz;
-    uint16_t writeBufSz;
-    uint16_t data_offset = 0;
-
-    do {
-      writeBufSz = (length<=maxBytes) ? length : maxBytes;
-
-      CHIP_SELECT
-      _nextByte(WRITE, PAGEPROG);
-      _transferAddress();
-      for (uint16_t i = 0; i < writeBufSz; ++i) {
-        _nextByte(WRITE, _outCharArray[data_offset + i]);
-      }
-      CHIP_DESELECT
+  _cacheClock = 0;
+  _cacheNext = SPIMEMORY_CACHE_EMPTY;
+}
 
-      _currentAddress += writeBufSz;
-      data_offset += writeBufSz;
-      length -= writeBufSz;
-      maxBytes = 256;   // Now we can do up to 256 bytes per loop
+//Returns the read cache hit, miss and read-ahead counts since the last resetCacheStats()
+SPIFlash::cacheStats SPIFlash::getCacheStats(void) {
+  return _cacheStats;
+}
 
-      if(!_notBusy() || !_writeEnable()){
-        return false;
-      }
+//Clears the read cache statistics
+void SPIFlash::resetCacheStats(void) {
+  memset(&_cacheStats, 0, sizeof(_cacheStats));
+}
 
-    } while (length > 0);
+// Works out how eraseSection() would erase a range: the range is rounded out to whole 4 KB sectors and covered with as
+// few erases as possible - 64 KB and 32 KB blocks wherever they are aligned, and 4 KB sectors at the edges.
+//  Takes three arguments -
+//    1. _addr --> Start of the range
+//    2. _sz --> Bytes in the range
+//    3. plan --> Filled in with the rounded range, the erases it takes and how long they typically run
+bool SPIFlash::planErase(uint32_t _addr, uint32_t _sz, erasePlan &plan) {
+  memset(&plan, 0, sizeof(plan));
+  if (!_sz || !_addressCheck(_addr, _sz)) {
+    return false;
   }
-
-  if (!errorCheck) {
-    _endSPI();
-    #ifdef RUNDIAGNOSTIC
-      _spifuncruntime = micros() - _spifuncruntime;
-    #endif
-    return true;
+  plan.addr = _addr & ~(KB(4) - 1);
+  plan.size = ((_addr + _sz - plan.addr) + KB(4) - 1) & ~(KB(4) - 1);
+  if (plan.size > _chip.capacity) {
+    plan.size = _chip.capacity;
   }
-  else {
-    if (!_notBusy()) {
-      return false;
-    }
-    _currentAddress = (_addr + sizeof(_sz));
-    char _inCharArray[_sz];
 
-    CHIP_SELECT
-    _nextByte(WRITE, READDATA);
-    _transferAddress();
-    for (uint8_t i = 0; i < _sz; i++) {
-      _inCharArray[i] = _nextByte(READ);
-    }
-    _endSPI();
+  uint32_t _size;
+  for (uint32_t _done = 0; _done < plan.size; _done += _size) {
+    switch (_planStep((plan.addr + _done) % _chip.capacity, plan.size - _done, _size)) {
+      case SPIMEMORY_WAIT_ERASE64K:
+      plan.blocks64K++;
+      break;
 
-    for (uint8_t i = 0; i < _sz; i++) {
-      if (_inCharArray[i] != _outCharArray[i]) {
-        #ifdef RUNDIAGNOSTIC
-          _spifuncruntime = micros() - _spifuncruntime;
-          #endif
-          return false;
-        }
+      case SPIMEMORY_WAIT_ERASE32K:
+      plan.blocks32K++;
+      break;
+
+      default:
+      plan.sectors++;
+      break;
     }
-    #ifdef RUNDIAGNOSTIC
-      _spifuncruntime = micros() - _spifuncruntime;
-    #endif
   }
+  plan.estimate = plan.blocks64K * _typicalTime(kb64Erase.time, _eraseTimeMultiplier, SPIMEMORY_TYP_ERASE64K_US) +
+                  plan.blocks32K * _typicalTime(kb32Erase.time, _eraseTimeMultiplier, SPIMEMORY_TYP_ERASE32K_US) +
+                  plan.sectors * _typicalTime(kb4Erase.time, _eraseTimeMultiplier, SPIMEMORY_TYP_ERASE4K_US);
+  plan.maxTime = plan.blocks64K * _worstTime(kb64Erase.time, SPIMEMORY_MAX_ERASE64K_US) +
+                 plan.blocks32K * _worstTime(kb32Erase.time, SPIMEMORY_MAX_ERASE32K_US) +
+                 plan.sectors * _worstTime(kb4Erase.time, SPIMEMORY_MAX_ERASE4K_US);
   return true;
 }
 
-
-
-// Erases a number of sectors or blocks as needed by the data being input.
-//  Takes an address and the size of the data being input as the arguments and erases the block/s of memory containing the address.
+// Erases every sector with data from the range starting at _addr and _sz bytes long, with the erases picked by
+// planErase(). With address overflow allowed (see setPolicy), a range that runs past the end of the chip goes on from
+// address 0
 bool SPIFlash::eraseSection(uint32_t _addr, uint32_t _sz) {
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros();
   #endif
-
-  if (!_prep(ERASEFUNC, _addr, _sz)) {
+  if (!eraseSectionAsync(_addr, _sz) || !awaitErase()) {
     return false;
   }
-
-    // If size of data is > 4KB more than one sector needs to be erased. So the number of erase sessions is determined by the quotient of _sz/KB(4). If the _sz is not perfectly divisible by KB(4), then an additional sector has to be erased.
-  uint32_t noOfEraseRunsB4Boundary = 0;
-  uint32_t noOf4KBEraseRuns, KB64Blocks, KB32Blocks, KB4Blocks, totalBlocks;
-
-  if (_sz/KB(4)) {
-    noOf4KBEraseRuns = _sz/KB(4);
-  }
-  else {
-    noOf4KBEraseRuns = 1;
-  }
-  KB64Blocks = noOf4KBEraseRuns/16;
-  KB32Blocks = (noOf4KBEraseRuns % 16) / 8;
-  KB4Blocks = (noOf4KBEraseRuns % 8);
-  totalBlocks = KB64Blocks + KB32Blocks + KB4Blocks;
-  //Serial.print(F("noOf4KBEraseRuns: "));
-  //Serial.println(noOf4KBEraseRuns);
-  //Serial.print(F("totalBlocks: "));
-  //Serial.println(totalBlocks);
-
-  uint16_t _eraseFuncOrder[totalBlocks];
-
-  if (KB64Blocks) {
-    for (uint32_t i = 0; i < KB64Blocks; i++) {
-      _eraseFuncOrder[i] = kb64Erase.opcode;
-    }
-  }
-  if (KB32Blocks) {
-    for (uint32_t i = KB64Blocks; i < (KB64Blocks + KB32Blocks); i++) {
-      _eraseFuncOrder[i] = kb32Erase.opcode;
-    }
-  }
-  if (KB4Blocks) {
-    for (uint32_t i = (KB64Blocks + KB32Blocks); i < totalBlocks; i++) {
-      _eraseFuncOrder[i] = kb4Erase.opcode;
-    }
-  }
-
-// Now that the number of blocks to be erased have been calculated and the information saved, the erase function is carried out.
-  if (_addressOverflow) {
-    noOfEraseRunsB4Boundary = (_sz - _addressOverflow)/16;
-    noOfEraseRunsB4Boundary += ((_sz - _addressOverflow) % 16) / 8;
-    noOfEraseRunsB4Boundary += ((_sz - _addressOverflow) % 8);
-    //Serial.print(F("noOfEraseRunsB4Boundary: "));
-    //Serial.println(noOfEraseRunsB4Boundary);
-  }
-  if (!_addressOverflow) {
-    for (uint32_t j = 0; j < totalBlocks; j++) {
-      _beginSPI(_eraseFuncOrder[j]);   //The address is transferred as a part of this function
-      _endSPI();
-
-
-      //Serial.printF("_eraseFuncOrder: 0x"));
-      //Serial.println(_eraseFuncOrder[j], HEX);
-
-      uint16_t _timeFactor = 0;
-      if (_eraseFuncOrder[j] == kb64Erase.opcode) {
-        _timeFactor = kb64Erase.time;
-      }
-      if (_eraseFuncOrder[j] == kb32Erase.opcode) {
-        _timeFactor = kb32Erase.time;
-      }
-      if (_eraseFuncOrder[j] == kb4Erase.opcode) {
-        _timeFactor = kb4Erase.time;
-      }
-      if(!_notBusy(_timeFactor * 1000L)) {
-        return false;
-      }
-      if (j == noOfEraseRunsB4Boundary) {
-        if (!_prep(ERASEFUNC, (_addr + (_sz - _addressOverflow)), _sz)) {
-          return false;
-        }
-        //Serial.print(F("Overflow triggered"));
-      }
-    }
-  }
-  //_writeDisable();
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros() - _spifuncruntime;
   #endif
@@ -1228,23 +1555,12 @@ bool SPIFlash::eraseSection(uint32_t _addr, uint32_t _sz) {
 // Erases one 4k sector.
 //  Takes an address as the argument and erases the block containing the address.
 bool SPIFlash::eraseSector(uint32_t _addr) {
-  if (!kb4Erase.supported) {
-    _troubleshoot(UNSUPPORTEDFUNC);
-    return false;
-  }
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros();
   #endif
-  if (!_prep(ERASEFUNC, _addr, KB(4))) {
-    return false;
-  }
-  _beginSPI(kb4Erase.opcode);   //The address is transferred as a part of this function
-  _endSPI();
-
-  if(!_notBusy(kb4Erase.time)) {
+  if (!eraseSectorAsync(_addr) || !awaitErase(kb4Erase.time)) {
     return false;	//Datasheet says erasing a sector takes 400ms max
   }
-  //_writeDisable();
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros() - _spifuncruntime;
   #endif
@@ -1255,23 +1571,12 @@ bool SPIFlash::eraseSector(uint32_t _addr) {
 // Erases one 32k block.
 //  Takes an address as the argument and erases the block containing the address.
 bool SPIFlash::eraseBlock32K(uint32_t _addr) {
-  if (!kb32Erase.supported) {
-    _troubleshoot(UNSUPPORTEDFUNC);
-    return false;
-  }
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros();
   #endif
-  if (!_prep(ERASEFUNC, _addr, KB(32))) {
+  if (!eraseBlock32KAsync(_addr) || !awaitErase(kb32Erase.time)) {
     return false;
   }
-  _beginSPI(kb32Erase.opcode);
-  _endSPI();
-
-  if(!_notBusy(kb32Erase.time)) {
-    return false;	//Datasheet says erasing a sector takes 400ms max
-  }
-  _writeDisable();
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros() - _spifuncruntime;
   #endif
@@ -1282,27 +1587,106 @@ bool SPIFlash::eraseBlock32K(uint32_t _addr) {
 // Erases one 64k block.
 //  Takes an address as the argument and erases the block containing the address.
 bool SPIFlash::eraseBlock64K(uint32_t _addr) {
-  if (!kb64Erase.supported) {
-    _troubleshoot(UNSUPPORTEDFUNC);
+  #ifdef RUNDIAGNOSTIC
+    _spifuncruntime = micros();
+  #endif
+  if (!eraseBlock64KAsync(_addr) || !awaitErase(kb64Erase.time)) {
     return false;
   }
   #ifdef RUNDIAGNOSTIC
-    _spifuncruntime = micros();
+    _spifuncruntime = micros() - _spifuncruntime;
   #endif
-  if (!_prep(ERASEFUNC, _addr, KB(64))) {
+	return true;
+}
+
+// Start erasing the 4k sector / 32k block / 64k block containing _addr and return as soon as the instruction has been
+// sent, the way programPageAsync() does for a page. The erase runs for tSE / tBE1 / tBE2 while the caller gets on with
+// something else - e.g. lets go of a bus mutex and polls eraseBusy(). Every other function waits for the erase to finish,
+// except reads outside the range being erased once setReadSuspend() has been called: these suspend the erase instead
+bool SPIFlash::eraseSectorAsync(uint32_t _addr) {
+  _sectionLeft = 0;
+  return _startErase(_addr, SPIMEMORY_WAIT_ERASE4K);
+}
+
+bool SPIFlash::eraseBlock32KAsync(uint32_t _addr) {
+  _sectionLeft = 0;
+  return _startErase(_addr, SPIMEMORY_WAIT_ERASE32K);
+}
+
+bool SPIFlash::eraseBlock64KAsync(uint32_t _addr) {
+  _sectionLeft = 0;
+  return _startErase(_addr, SPIMEMORY_WAIT_ERASE64K);
+}
+
+// As eraseChip(), returning as soon as the instruction has been sent - e.g. so that several chips erase side by side.
+// A chip erase cannot be suspended, so every read waits for it
+bool SPIFlash::eraseChipAsync(void) {
+  _sectionLeft = 0;
+  return _startErase(0, SPIMEMORY_WAIT_CHIPERASE);
+}
+
+// As eraseSection(), one erase at a time: starts the first and returns. eraseBusy() and awaitErase() start each of the
+// others once the one before has finished
+bool SPIFlash::eraseSectionAsync(uint32_t _addr, uint32_t _sz) {
+  erasePlan _plan;
+  if (!planErase(_addr, _sz, _plan)) {
     return false;
   }
+  _sectionNext = _plan.addr;
+  _sectionLeft = _plan.size;
+  return _continueSection();
+}
 
-  _beginSPI(kb64Erase.opcode);
+// Returns true while the erase started by erase*Async() is running. Resumes it first if a read has suspended it, and
+// otherwise reads the status register once - never waits. Moves eraseSectionAsync() on to its next erase, and returns
+// false if that cannot be started - awaitErase() tells this apart from the range being done
+bool SPIFlash::eraseBusy(void) {
+  if (!_erasePending && !_sectionLeft) {
+    return false;
+  }
+  if (_suspendedForRead) {
+    _resumeErase();
+    _endSPI();
+    return true;
+  }
+  if (_erasePending) {
+    _readStat1();
+    if (!(stat1 & BUSY)) {
+      _operationDone();
+    }
+  }
+  if (!_erasePending && _sectionLeft) {
+    _continueSection();
+  }
   _endSPI();
+  return _erasePending;
+}
 
-  if(!_notBusy(kb64Erase.time)) {
-    return false;	//Datasheet says erasing a sector takes 400ms max
+// Waits for the erase started by erase*Async() - all of them for eraseSectionAsync() - to finish. Returns false if one
+// takes longer than timeout (in microseconds), or could not be started - also when eraseBusy() has run into that
+bool SPIFlash::awaitErase(uint32_t timeout) {
+  while (_erasePending || _sectionLeft) {
+    if ((!_erasePending && !_continueSection()) || !_notBusy(timeout)) {
+      _sectionLeft = 0;
+      _eraseFailed = true;
+      break;
+    }
   }
-  #ifdef RUNDIAGNOSTIC
-    _spifuncruntime = micros() - _spifuncruntime;
-  #endif
-	return true;
+  _endSPI();
+  return !_eraseFailed;
+}
+
+// Lets reads preempt an erase started by erase*Async(), on Winbond chips: a read of anything but the range being erased
+// suspends the erase (75h) and reads right away instead of waiting for tSE / tBE to run out. The erase stays suspended
+// until the next function that has to wait for the chip - eraseBusy() included - resumes it (7Ah).
+//  Takes two arguments -
+//    1. maxSuspends --> Times one erase can be suspended. Reads after that wait for it to finish, so that it always
+//                       does. 0 (default) turns suspending off
+//    2. minRunTime --> Least time (in microseconds) an erase runs after being resumed before it can be suspended
+//                      again. A read that comes sooner waits for the rest of it
+void SPIFlash::setReadSuspend(uint8_t maxSuspends, uint32_t minRunTime) {
+  _maxSuspends = maxSuspends;
+  _minRunTime = minRunTime;
 }
 
 //Erases whole chip. Think twice before using.
@@ -1310,17 +1694,11 @@ bool SPIFlash::eraseChip(void) {
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros();
   #endif
-	if(_isChipPoweredDown() || !_notBusy() || !_writeEnable()) {
+  if (!eraseChipAsync() || !awaitErase()) {
     return false;
   }
-
-	_beginSPI(chipErase.opcode);
-  _endSPI();
-
-	while(_readStat1() & BUSY) {
-    //_delay_us(30000L);
-  }
-  _endSPI();
+  _freeFrom = 0;
+  _freeFromKnown = true;
 
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros() - _spifuncruntime;
@@ -1350,6 +1728,7 @@ bool SPIFlash::suspendProg(void) {
 
   _beginSPI(SUSPEND);
   _endSPI();
+  _forgetChipState();
   _delay_us(20);
   if(!_notBusy(50) || _noSuspend()) {
     return false;
@@ -1371,6 +1750,7 @@ bool SPIFlash::resumeProg(void) {
 
 	_beginSPI(RESUME);
 	_endSPI();
+	_forgetChipState();
 
 	_delay_us(20);
 
@@ -1396,6 +1776,7 @@ bool SPIFlash::powerDown(void) {
 
   	_beginSPI(POWERDOWN);
     _endSPI();
+    _forgetChipState();
 
     _delay_us(5);
 
@@ -1417,11 +1798,16 @@ bool SPIFlash::powerDown(void) {
 
 //Wakes chip from low power state.
 bool SPIFlash::powerUp(void) {
+  if (_autoAsleep) {
+    _wakeUp();
+    return true;
+  }
   #ifdef RUNDIAGNOSTIC
     _spifuncruntime = micros();
   #endif
 	_beginSPI(RELEASE);
   _endSPI();
+  _forgetChipState();
 	_delay_us(3);						    //Max release enable time according to the Datasheet
 
   #ifdef RUNDIAGNOSTIC
@@ -1442,5 +1828,59 @@ bool SPIFlash::powerUp(void) {
   #endif
 }
 
+//Lets powerDownIfIdle() put the chip in deep power-down once it has gone idleTime ms without a command. The next command
+//wakes it up again first, so that nothing else has to know about it. 0 turns this off, and wakes the chip up if
+//powerDownIfIdle() has powered it down
+bool SPIFlash::setAutoPowerDown(uint32_t idleTime) {
+  if (idleTime && _chip.manufacturerID == MICROCHIP_MANID) {    // No power-down (see powerDown())
+    _troubleshoot(UNSUPPORTEDFUNC);
+    return false;
+  }
+  _autoPowerDown = idleTime;
+  _lastAccess = millis();
+  if (!idleTime && _autoAsleep) {
+    _wakeUp();
+  }
+  return true;
+}
+
+//Powers the chip down if it has gone the time set with setAutoPowerDown() without a command, and has no erase or
+//program under way. Call it regularly - from loop() or an idle task. Returns true if the chip is powered down
+//Unlike powerDown(), the chip is not asked whether it took the instruction: a powered down chip answers nothing, and a
+//pulled up MISO would read as WEL set. If it did not, the next command just finds it awake
+bool SPIFlash::powerDownIfIdle(void) {
+  if (chipPoweredDown) {
+    return true;
+  }
+  if (!_autoPowerDown || _erasePending || _programPending || _sectionLeft || millis() - _lastAccess < _autoPowerDown ||
+      !_notBusy(20)) {
+    return false;
+  }
+  _beginSPI(POWERDOWN);
+  _endSPI();
+  _forgetChipState();
+  _delay_us(SPIMEMORY_TDP_US);
+  chipPoweredDown = true;
+  _autoAsleep = true;
+  _asleepSince = millis();
+  _powerStats.powerDowns++;
+  return true;
+}
+
+//Returns the power-down and wake-up counts and times since the last resetPowerStats()
+SPIFlash::powerStats SPIFlash::getPowerStats(void) {
+  powerStats _stats = _powerStats;
+  if (_autoAsleep) {
+    _stats.timeAsleep += millis() - _asleepSince;
+  }
+  return _stats;
+}
+
+//Clears the power-down statistics
+void SPIFlash::resetPowerStats(void) {
+  memset(&_powerStats, 0, sizeof(_powerStats));
+  _asleepSince = millis();
+}
+
 /* Note: _writeDisable() is not required at the end of any function that writes to the Flash memory because the Write Enable Latch (WEL) flag is cleared to 0 i.e. to write disable state upon the following conditions being completed:
 Power-up, Write Disable, Page Program, Quad Page Program, Sector Erase, Block Erase, Chip Erase, Write Status Register, Erase Security Register and Program Security register */
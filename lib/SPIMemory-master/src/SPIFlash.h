@@ -33,7 +33,10 @@ class SPIFlash {
 public:
   //------------------------------------ Constructor ------------------------------------//
   //New Constructor to Accept the PinNames as a Chip select Parameter - @boseji <salearj@hotmail.com> 02.03.17
-  #if defined (ARDUINO_ARCH_SAMD) || defined(ARCH_STM32) || defined(ARDUINO_ARCH_ESP32)
+  #if defined (SPIMEMORY_TRANSPORT)
+  SPIFlash(uint8_t cs = CS, SPIClass *spiinterface=&SPI);
+  SPIFlash(SPIMemoryTransport &transport);
+  #elif defined (ARDUINO_ARCH_SAMD) || defined(ARCH_STM32)
   SPIFlash(uint8_t cs = CS, SPIClass *spiinterface=&SPI);
   #elif defined (BOARD_RTL8195A)
   SPIFlash(PinName cs = CS);
@@ -41,13 +44,39 @@ public:
   SPIFlash(uint8_t cs = CS);
   SPIFlash(int8_t *SPIPinsArray);
   #endif
+  ~SPIFlash(void);
+  SPIFlash(const SPIFlash&) = delete;               // The erased page map and the read cache are owned by the object
+  SPIFlash& operator=(const SPIFlash&) = delete;
   //----------------------------- Initial / Chip Functions ------------------------------//
   bool     begin(uint32_t flashChipSize = 0);
+  struct   chipParams {              // What begin() found out about the chip, to be saved and handed back to begin()
+             uint8_t  version;                // SPIMEMORY_CHIPPARAMS_VERSION
+             uint8_t  manufacturerID;
+             uint8_t  memoryTypeID;
+             uint8_t  capacityID;
+             uint8_t  chipFlags;              // Bit 0 supported, bit 1 supportedMan, bit 2 sfdpAvailable
+             uint8_t  sfdpIOModes;
+             uint8_t  eraseSupported;         // Bit n set if eraseOpcode[n] can be used
+             uint8_t  eraseOpcode[5];         // 4 KB, 32 KB, 64 KB, 256 KB and chip erase
+             uint32_t eraseTime[5];
+             uint32_t capacity;
+             uint16_t pageSize;
+             uint16_t eraseTimeMultiplier;
+             uint16_t prgmTimeMultiplier;
+             uint32_t pagePrgmTime;
+             uint32_t byteFirstPrgmTime;
+             uint32_t byteAddnlPrgmTime;
+             uint32_t crc;                    // CRC-32 of all of the above
+           };
+  bool     begin(const chipParams &params, uint32_t flashChipSize = 0);
+  bool     getChipParams(chipParams &params);
   #ifdef SPI_HAS_TRANSACTION
   void     setClock(uint32_t clockSpeed);
   #else
   void     setClock(uint8_t clockdiv);
   #endif
+  bool     setIOMode(uint8_t ioMode = SPIMEMORY_IO_AUTO);
+  uint8_t  getIOMode(void);
   bool     libver(uint8_t *b1, uint8_t *b2, uint8_t *b3);
   bool     sfdpPresent(void);
   uint8_t  error(bool verbosity = false);
@@ -59,12 +88,40 @@ public:
   uint32_t getCapacity(void);
   uint32_t getMaxPage(void);
   float    functionRunTime(void);
+  //------------------------------- Busy wait statistics --------------------------------//
+  struct   waitStats {
+             uint32_t waits;        // Waits that found the chip busy
+             uint32_t polls;        // Status register reads made by those waits
+             uint32_t waitTime;     // Total time spent waiting (us)
+             uint32_t yieldTime;    // ... of which in delay() - off the SPI bus, and handed to other tasks on RTOS cores (us)
+             uint32_t maxWaitTime;  // Longest single wait (us)
+           };
+  waitStats getWaitStats(uint8_t waitType);
+  void     resetWaitStats(void);
+  //-------------------------------- Write verification ---------------------------------//
+  void     setVerifyPolicy(uint8_t policy, uint16_t sampleInterval = 16);
+  uint8_t  getVerifyPolicy(void);
+  bool     verifyCRC(uint32_t _addr, uint32_t size, uint32_t crc);
+  uint32_t crc32(uint32_t crc, const uint8_t *data_buffer, uint32_t size);
+  //---------------------------------- Runtime policies ---------------------------------//
+  void     setPolicy(uint8_t policy);
+  uint8_t  getPolicy(void);
   //-------------------------------- Write / Read Bytes ---------------------------------//
   bool     writeByte(uint32_t _addr, uint8_t data, bool errorCheck = true);
   uint8_t  readByte(uint32_t _addr, bool fastRead = false);
   //----------------------------- Write / Read Byte Arrays ------------------------------//
   bool     writeByteArray(uint32_t _addr, uint8_t *data_buffer, size_t bufferSize, bool errorCheck = true);
   bool     readByteArray(uint32_t _addr, uint8_t *data_buffer, size_t bufferSize, bool fastRead = false);
+  //------------------------------- Scatter / gather I/O --------------------------------//
+  struct   iovec {                   // One buffer of writev() / readv(), as the POSIX struct of the same name
+             void    *iov_base;
+             size_t   iov_len;
+           };
+  bool     writev(uint32_t _addr, const iovec *vec, uint8_t count, bool errorCheck = true);
+  bool     readv(uint32_t _addr, const iovec *vec, uint8_t count, bool fastRead = false);
+  //----------------------------------- Stream reads ------------------------------------//
+  typedef  bool (*streamCallback)(uint32_t _addr, const uint8_t *data_buffer, uint32_t size, void *context);
+  bool     readStream(uint32_t _addr, uint32_t size, uint8_t *chunk_buffer, uint32_t chunkSize, streamCallback callback, void *context = NULL, bool fastRead = false);
   //-------------------------------- Write / Read Chars ---------------------------------//
   bool     writeChar(uint32_t _addr, int8_t data, bool errorCheck = true);
   int8_t   readChar(uint32_t _addr, bool fastRead = false);
@@ -87,13 +144,52 @@ public:
   bool     writeFloat(uint32_t _addr, float data, bool errorCheck = true);
   float    readFloat(uint32_t _addr, bool fastRead = false);
   //-------------------------------- Write / Read Strings -------------------------------//
-  bool     writeStr(uint32_t _addr, String &data, bool errorCheck = true);
+  bool     writeStr(uint32_t _addr, const String &data, bool errorCheck = true);
+  bool     writeStr(uint32_t _addr, const char *data, uint32_t length, bool errorCheck = true);
   bool     readStr(uint32_t _addr, String &data, bool fastRead = false);
+  bool     readStr(uint32_t _addr, char *data_buffer, uint32_t bufferSize, uint32_t *length = NULL, bool fastRead = false);
   //------------------------------- Write / Read Anything -------------------------------//
 
   template <class T> bool writeAnything(uint32_t _addr, const T& data, bool errorCheck = true);
   template <class T> bool readAnything(uint32_t _addr, T& data, bool fastRead = false);
+  //--------------------------- Asynchronous page program -------------------------------//
+  bool     programPageAsync(uint32_t _addr, const uint8_t *data_buffer, uint16_t bufferSize);
+  bool     programBusy(void);
+  bool     awaitProgram(uint32_t timeout = BUSY_TIMEOUT);
+  //------------------------------- Asynchronous erase ----------------------------------//
+  bool     eraseSectorAsync(uint32_t _addr);
+  bool     eraseBlock32KAsync(uint32_t _addr);
+  bool     eraseBlock64KAsync(uint32_t _addr);
+  bool     eraseChipAsync(void);
+  bool     eraseSectionAsync(uint32_t _addr, uint32_t _sz);
+  bool     eraseBusy(void);
+  bool     awaitErase(uint32_t timeout = BUSY_TIMEOUT);
+  void     setReadSuspend(uint8_t maxSuspends, uint32_t minRunTime = SPIMEMORY_SUSPEND_MIN_RUN_US);
+  //---------------------------------- Erased page map ----------------------------------//
+  bool     trackErasedPages(bool scan = false);
+  void     untrackErasedPages(void);
+  bool     isPageErased(uint32_t _addr);
+  //------------------------------------ Read cache -------------------------------------//
+  struct   cacheStats {
+             uint32_t hits;         // Lines read from the cache
+             uint32_t misses;       // Lines read from the chip because they were asked for
+             uint32_t readAheads;   // Lines read from the chip ahead of a sequential read
+           };
+  bool     setReadCache(uint8_t lines, uint16_t lineSize = SPIMEMORY_CACHE_LINE, uint8_t readAhead = SPIMEMORY_CACHE_READAHEAD);
+  void     clearReadCache(void);
+  cacheStats getCacheStats(void);
+  void     resetCacheStats(void);
   //-------------------------------- Erase functions ------------------------------------//
+  struct   erasePlan {               // How eraseSection() covers a range (see planErase())
+             uint32_t addr;          // First byte erased - the range rounded out to whole 4 KB sectors
+             uint32_t size;          // Bytes erased
+             uint32_t sectors;       // 4 KB sector erases
+             uint32_t blocks32K;     // 32 KB block erases
+             uint32_t blocks64K;     // 64 KB block erases
+             uint32_t estimate;      // Typical time of all of them (us)
+             uint32_t maxTime;       // Worst case time of all of them (us) - past it, the chip is not going to finish
+           };
+  bool     planErase(uint32_t _addr, uint32_t _sz, erasePlan &plan);
   bool     eraseSection(uint32_t _addr, uint32_t _sz);
   bool     eraseSector(uint32_t _addr);
   bool     eraseBlock32K(uint32_t _addr);
@@ -104,6 +200,17 @@ public:
   bool     resumeProg(void);
   bool     powerDown(void);
   bool     powerUp(void);
+  struct   powerStats {
+             uint32_t powerDowns;   // Times powerDownIfIdle() powered the chip down
+             uint32_t wakeUps;      // Times a command woke it up again
+             uint32_t wakeTime;     // Total time those wake-ups took, tRES1 included (us)
+             uint32_t maxWakeTime;  // Longest single wake-up (us)
+             uint32_t timeAsleep;   // Total time spent powered down by powerDownIfIdle() (ms)
+           };
+  bool     setAutoPowerDown(uint32_t idleTime);
+  bool     powerDownIfIdle(void);
+  powerStats getPowerStats(void);
+  void     resetPowerStats(void);
   //-------------------------- Public Arduino Due Functions -----------------------------//
 //#if defined (ARDUINO_ARCH_SAM)
   //uint32_t freeRAM(void);
@@ -115,40 +222,79 @@ private:
   unsigned _createMask(unsigned a, unsigned b);
   void     _troubleshoot(uint8_t _code, bool printoverride = false);
   void     _endSPI(void);
+  void     _beginBus(void);
   bool     _disableGlobalBlockProtect(void);
   bool     _isChipPoweredDown(void);
   bool     _prep(uint8_t opcode, uint32_t _addr, uint32_t size = 0);
   bool     _startSPIBus(void);
+  void     _stopSPIBus(void);
   bool     _beginSPI(uint8_t opcode);
   bool     _noSuspend(void);
+  bool     _startErase(uint32_t _addr, uint8_t waitType);
+  uint8_t  _planStep(uint32_t _addr, uint32_t _remaining, uint32_t &size);
+  bool     _continueSection(void);
+  bool     _readyToRead(uint32_t _addr, uint32_t size);
+  bool     _suspendForRead(uint32_t _addr, uint32_t size);
+  void     _resumeErase(void);
+  void     _operationDone(void);
   bool     _notBusy(uint32_t timeout = BUSY_TIMEOUT);
+  void     _busyWith(uint8_t waitType, uint32_t expected);
+  void     _forgetChipState(void);
+  void     _wakeUp(void);
+  uint32_t _idle(uint32_t us);
+  uint32_t _typicalTime(uint32_t maxTime, uint16_t multiplier, uint32_t datasheetTime);
+  uint32_t _worstTime(uint32_t maxTime, uint32_t datasheetTime);
+  uint32_t _maxBusyTime(void);
   bool     _notPrevWritten(uint32_t _addr, uint32_t size = 1);
+  bool     _verifyWanted(uint32_t _addr, uint32_t size);
+  bool     _verify(uint32_t _addr, const uint8_t *data_buffer, uint32_t size);
+  bool     _knownErased(uint32_t _addr, uint32_t size);
+  uint32_t _findFree(uint32_t _addr, uint32_t size, uint32_t _end);
+  void     _findFreeFrom(void);
+  void     _markPages(uint32_t _addr, uint32_t size, bool erased);
+  void     _checkErasedPages(const uint8_t *data_buffer, uint32_t size);
+  int16_t  _cacheFind(uint32_t _line);
+  uint8_t  _cacheFill(bool fastRead, uint32_t _line);
+  void     _readCached(bool fastRead, uint8_t *data_buffer, uint32_t size);
+  void     _dropCached(uint32_t _addr, uint32_t size);
+  uint8_t  _readOpcode(bool fastRead, uint8_t &dummyBytes);
+  void     _beginRead(bool fastRead);
+  void     _readNext(uint8_t *data_buffer, uint32_t size);
+  void     _endRead(void);
   bool     _writeEnable(bool _troubleshootEnable = true);
   bool     _writeDisable(void);
   bool     _getJedecId(void);
   bool     _getManId(uint8_t *b1, uint8_t *b2);
+  void     _defaultChipParams(void);
   bool     _chipID(uint32_t flashChipSize = 0);
+  bool     _useChip(uint8_t manufacturerID, uint8_t memoryTypeID, uint8_t capacityID, uint32_t capacity);
   bool     _transferAddress(void);
   bool     _addressCheck(uint32_t _addr, uint32_t size = 1);
   bool     _enable4ByteAddressing(void);
   bool     _disable4ByteAddressing(void);
+  bool     _enableQuad(void);
+  bool     _ioModeSupported(uint8_t ioMode);
   uint8_t  _nextByte(char IOType, uint8_t data = NULLBYTE);
   uint16_t _nextInt(uint16_t = NULLINT);
   void     _nextBuf(uint8_t opcode, uint8_t *data_buffer, uint32_t size);
+  void     _readData(bool fastRead, uint8_t *data_buffer, uint32_t size);
+  void     _readChip(bool fastRead, uint8_t *data_buffer, uint32_t size);
+  bool     _programPage(const uint8_t *data_buffer, uint32_t size, bool writeEnable);
+  bool     _programPages(const uint8_t *data_buffer, uint32_t size);
+  bool     _programVec(const iovec *vec, uint8_t count, uint32_t size);
+  static const uint8_t *_gatherVec(const iovec *vec, uint8_t count, uint8_t &index, uint32_t &offset, uint32_t len, uint8_t *page);
+  static uint32_t _vecSize(const iovec *vec, uint8_t count);
+  bool     _readv(uint32_t _addr, const iovec *vec, uint8_t count, bool fastRead, bool cached);
+  bool     _readStrSize(uint32_t _addr, uint32_t &size, bool fastRead);
   uint8_t  _readStat1(void);
   uint8_t  _readStat2(void);
   uint8_t  _readStat3(void);
-  bool     _getSFDPTable(uint32_t _tableAddress, uint8_t *data_buffer, uint8_t numberOfDWords);
-  bool     _getSFDPData(uint32_t _address, uint8_t *data_buffer, uint8_t numberOfBytes);
-  uint32_t _getSFDPdword(uint32_t _tableAddress, uint8_t dWordNumber);
-  uint16_t _getSFDPint(uint32_t _tableAddress, uint8_t dWordNumber, uint8_t startByte);
-  uint8_t  _getSFDPbyte(uint32_t _tableAddress, uint8_t dWordNumber, uint8_t byteNumber);
-  bool     _getSFDPbit(uint32_t _tableAddress, uint8_t dWordNumber, uint8_t bitNumber);
-  uint32_t _getSFDPTableAddr(uint32_t paramHeaderNum);
+  bool     _getSFDPData(uint32_t _address, uint8_t *data_buffer, uint16_t numberOfBytes);
   uint32_t _calcSFDPEraseTimeUnits(uint8_t _unitBits);
-  bool     _checkForSFDP(void);
-  void     _getSFDPEraseParam(void);
-  void     _getSFDPProgramTimeParam(void);
+  uint8_t  _getSFDPSectorMap(uint32_t _tableAddr, uint8_t noOfDwords);
+  void     _getSFDPEraseParam(const uint8_t *bfpt, uint8_t eraseTypes);
+  void     _getSFDPProgramTimeParam(const uint8_t *bfpt);
+  void     _getSFDPIOModes(const uint8_t *bfpt);
   bool     _getSFDPFlashParam(void);
   template <class T> bool _write(uint32_t _addr, const T& value, uint32_t _sz, bool errorCheck, uint8_t _dataType);
   template <class T> bool _read(uint32_t _addr, T& value, uint32_t _sz, bool fastRead = false, uint8_t _dataType = 0x00);
@@ -165,6 +311,12 @@ private:
   //If multiple SPI ports are available this variable is used to choose between them (SPI, SPI1, SPI2 etc.)
   SPIClass *_spi;
 
+  #if defined (SPIMEMORY_TRANSPORT)
+  //The transport the chip is reached through. Points to _defaultBus unless a transport is passed to the constructor
+  SPIMemoryArduinoTransport _defaultBus;
+  SPIMemoryTransport *_bus;
+  #endif
+
   #if !defined (BOARD_RTL8195A)
   uint8_t     csPin;
   #else
@@ -189,6 +341,45 @@ private:
   bool        chipPoweredDown = false;
   bool        address4ByteEnabled = false;
   bool        _loopedOver = false;
+  bool        _freeFromKnown = false;      // _freeFrom has been found since begin() (see getAddress())
+  uint32_t    _freeFrom = 0;               // Where the data on the chip ends - all above it was blank when last looked at
+  bool        _programPending = false;     // A page started by programPageAsync() may still be programming
+  bool        _erasePending = false;       // An erase started by erase*Async() may still be running, on the range below
+  uint32_t    _eraseAddr = 0;
+  uint32_t    _eraseSize = 0;
+  uint32_t    _sectionNext = 0;            // What is left of the range handed to eraseSectionAsync(), after the pending erase
+  uint32_t    _sectionLeft = 0;
+  bool        _eraseFailed = false;        // The last erase could not be started or timed out (see awaitErase())
+  bool        _suspendedForRead = false;   // ... and has been suspended by a read. The next wait resumes it
+  uint8_t     _suspends = 0;               // Times the pending erase has been suspended, out of _maxSuspends
+  uint8_t     _maxSuspends = 0;            // 0 --> reads wait for erases to finish
+  uint32_t    _minRunTime = SPIMEMORY_SUSPEND_MIN_RUN_US;
+  uint32_t    _resumedAt = 0;
+  bool        _knownIdle = false;          // BUSY is known to be clear - nothing has been started since it was last read
+  bool        _knownWEL = false;           // WEL is known to be set
+  uint8_t    *_erasedPages = NULL;         // One bit per page, set while the page is known to be all 0xFF (see trackErasedPages())
+  uint8_t    *_cacheData = NULL;           // _cacheLines lines of _cacheLineSize bytes (see setReadCache())
+  uint32_t   *_cacheTags = NULL;           // Address of the line held in each slot, SPIMEMORY_CACHE_EMPTY if none
+  uint32_t   *_cacheUsed = NULL;           // _cacheClock when each slot was last read - the oldest is replaced first
+  uint8_t     _cacheLines = 0;             // 0 --> reads go to the chip
+  uint16_t    _cacheLineSize = SPIMEMORY_CACHE_LINE;
+  uint8_t     _cacheReadAhead = 0;
+  uint32_t    _cacheClock = 0;
+  uint32_t    _cacheNext = SPIMEMORY_CACHE_EMPTY;  // Line after the last one read - a miss on it is read ahead of
+  cacheStats  _cacheStats = {};
+  uint32_t    _autoPowerDown = 0;          // ms without a command before powerDownIfIdle() powers the chip down. 0 --> never
+  uint32_t    _lastAccess = 0;             // millis() when the last command was sent
+  bool        _autoAsleep = false;         // Powered down by powerDownIfIdle() - the next command wakes the chip up first
+  uint32_t    _asleepSince = 0;
+  powerStats  _powerStats = {};
+  uint8_t     _busyOp = SPIMEMORY_WAIT_OTHER;    // Last operation started, and when and for how long it is expected to keep the chip busy
+  uint32_t    _busyStart = 0;
+  uint32_t    _busyExpected = 0;
+  waitStats   _waitStats[SPIMEMORY_WAIT_TYPES] = {};
+  uint8_t     _ioMode = SPIMEMORY_IO_SINGLE;
+  uint8_t     _verifyPolicy = SPIMEMORY_VERIFY_FULL;
+  uint16_t    _verifyInterval = 16;        // Pages per verified page with SPIMEMORY_VERIFY_SAMPLED
+  uint8_t     _policy = SPIMEMORY_POLICY_DEFAULT;
   uint8_t     cs_mask, errorcode, stat1, stat2, stat3, _SPCR, _SPSR, _a0, _a1, _a2;
   char READ = 'R';
   char WRITE = 'W';
@@ -209,22 +400,40 @@ private:
               uint8_t opcode;
               uint32_t time;
             } kb4Erase, kb32Erase, kb64Erase, kb256Erase, chipErase;
-  uint8_t     _noOfParamHeaders, _noOfBasicParamDwords;
+  uint8_t     _noOfBasicParamDwords;
+  uint8_t     _sfdpIOModes = 0;            // SFDP_IO_* - the multi-line reads the SFDP tables list
   uint16_t    _eraseTimeMultiplier, _prgmTimeMultiplier, _pageSize;
-  uint32_t    currentAddress, _currentAddress = 0;
+  uint32_t    currentAddress = 0, _currentAddress = 0;
   uint32_t    _addressOverflow = false;
-  uint32_t    _BasicParamTableAddr, _SectorMapParamTableAddr, _byteFirstPrgmTime, _byteAddnlPrgmTime, _pagePrgmTime;
+  uint32_t    _byteFirstPrgmTime, _byteAddnlPrgmTime, _pagePrgmTime;
   uint8_t     _uniqueID[8];
-  const uint8_t _capID[18]   =
-  {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x41, 0x42, 0x43, 0x4B, 0x00, 0x01, 0x13, 0x37};
+  static const uint8_t  _capID[18];          // See SPIFlash.cpp
+  static const uint32_t _memSize[18];
+  static const uint8_t  _supportedManID[9];
+  static const uint8_t  _altChipEraseReq[3];
 
-  const uint32_t _memSize[18]  =
-  {KB(64), KB(128), KB(256), KB(512), MB(1), MB(2), MB(4), MB(8), MB(16), MB(32), MB(2), MB(4), MB(8), MB(8), KB(256), KB(512), MB(4), KB(512)};
-  // To understand the _memSize definitions check defines.h
+  template <class Chip> friend class SPIFlashT;
+  friend class SPIFlashVolume;     // Reads around the read cache (see SPIFlashVolume::readStream())
+};
 
-  const uint8_t _supportedManID[9] = {WINBOND_MANID, MICROCHIP_MANID, CYPRESS_MANID, ADESTO_MANID, MICRON_MANID, ON_MANID, GIGA_MANID, AMIC_MANID, MACRONIX_MANID};
+// Applies a policy to one SPIFlash for as long as it is in scope, then puts back the one it had. For a fast path in
+// code that knows more than the library does, i.e. a writer that has erased its sectors itself -
+//    {
+//      SPIFlashPolicy fast(flash, flash.getPolicy() | SPIMEMORY_POLICY_HIGHSPEED);
+//      flash.writeByteArray(_addr, data_buffer, bufferSize);
+//    }
+class SPIFlashPolicy {
+public:
+  SPIFlashPolicy(SPIFlash &flash, uint8_t policy) : _flash(flash), _previous(flash.getPolicy()) {
+    _flash.setPolicy(policy);
+  }
+  ~SPIFlashPolicy(void) {
+    _flash.setPolicy(_previous);
+  }
 
-  const uint8_t _altChipEraseReq[3] = {A25L512, M25P40, SST26};
+private:
+  SPIFlash &_flash;
+  uint8_t   _previous;
 };
 
 //--------------------------------- Public Templates ------------------------------------//
@@ -252,39 +461,10 @@ template <class T> bool SPIFlash::readAnything(uint32_t _addr, T& data, bool fas
 //---------------------------------- Private Templates ----------------------------------//
 
 template <class T> bool SPIFlash::_writeErrorCheck(uint32_t _addr, const T& value, uint32_t _sz, uint8_t _dataType) {
-  if (_isChipPoweredDown() || !_addressCheck(_addr, _sz) || !_notBusy()) {
+  if (_isChipPoweredDown()) {
     return false;
   }
-  const uint8_t* p = (const uint8_t*)(const void*)&value;
-  /*if (_dataType == _STRUCT_) {
-    uint8_t _inByte[_sz];
-    _beginSPI(READDATA);
-    _nextBuf(READDATA, &(*_inByte), _sz);
-    _endSPI();
-    for (uint16_t i = 0; i < _sz; i++) {
-      if (*p++ != _inByte[i]) {
-        _troubleshoot(0x0A); //0x0A is ERRORCHKFAIL
-        return false;
-      }
-      else {
-        return true;
-      }
-    }
-  }
-  else {*/
-    CHIP_SELECT
-    _nextByte(WRITE, READDATA);
-    _transferAddress();
-    for (uint16_t i = 0; i < _sz; i++) {
-      if (*p++ != _nextByte(READ)) {
-        _troubleshoot(0x0A); //0x0A is ERRORCHKFAIL
-        _endSPI();
-        return false;
-      }
-    }
-    _endSPI();
-  //}
-  return true;
+  return _verify(_addr, (const uint8_t*)(const void*)&value, _sz);
 }
 
 // Writes any type of data to a specific location in the flash memory.
@@ -318,31 +498,23 @@ template <class T> bool SPIFlash::_write(uint32_t _addr, const T& value, uint32_
   if (!SPIBusState) {
     _startSPIBus();
   }
-  CHIP_SELECT
-  _nextByte(WRITE, PAGEPROG);
-  _transferAddress();
 
   if (maxBytes > length) {
-    for (uint16_t i = 0; i < length; ++i) {
-      _nextByte(WRITE, *p++);
+    if (!_programPage(p, length, false)) {   // Write enable has been sent by _prep()
+      return false;
     }
-    CHIP_DESELECT
   }
   else {
     uint32_t writeBufSz;
-    uint16_t data_offset = 0;
+    uint32_t data_offset = 0;
 
     do {
       writeBufSz = (length<=maxBytes) ? length : maxBytes;
-      if(_currentAddress % SPI_PAGESIZE==0){
-        CHIP_SELECT
-        _nextByte(WRITE, PAGEPROG);
-        _transferAddress();
-	    }
-      for (uint16_t i = 0; i < writeBufSz; ++i) {
-        _nextByte(WRITE, *p++);
+      // The first page has been write enabled by _prep(). Every following page sends its write enable along with the data
+      if (!_programPage(p, writeBufSz, data_offset != 0)) {
+        return false;
       }
-      CHIP_DESELECT
+      p += writeBufSz;
       if (!_addressOverflow) {
         _currentAddress += writeBufSz;
       }
@@ -355,13 +527,13 @@ template <class T> bool SPIFlash::_write(uint32_t _addr, const T& value, uint32_
       data_offset += writeBufSz;
       length -= writeBufSz;
       maxBytes = SPI_PAGESIZE;   // Now we can do up to 256 bytes per loop
-      if(!_notBusy() || !_writeEnable()) {
+      if(!_notBusy()) {
         return false;
       }
     } while (length > 0);
   }
 
-  if (!errorCheck) {
+  if (!errorCheck || !_verifyWanted(_addr, _sz)) {
     _endSPI();
     #ifdef RUNDIAGNOSTIC
       _spifuncruntime = micros() - _spifuncruntime;
@@ -398,24 +570,14 @@ template <class T> bool SPIFlash::_read(uint32_t _addr, T& value, uint32_t _sz,
     if (_dataType == _STRING_) {
       _sz++;
       char _inChar[_sz];
-      _beginSPI(READDATA);
-      _nextBuf(READDATA, (uint8_t*) &(*_inChar), _sz);
+      _readData(false, (uint8_t*) _inChar, _sz);
       _endSPI();
-      for (uint16_t i = 0; i < _sz; i++) {
+      for (uint32_t i = 0; i < _sz; i++) {
         *p++ = _inChar[i];
       }
     }
     else {
-      CHIP_SELECT
-      if (fastRead) {
-        _beginSPI(FASTREAD);
-      }
-      else {
-        _beginSPI(READDATA);
-      }
-      for (uint16_t i = 0; i < _sz; i++) {
-        *p++ =_nextByte(READ);
-      }
+      _readData(fastRead, p, _sz);
       _endSPI();
     }
   }
@@ -425,4 +587,8 @@ template <class T> bool SPIFlash::_read(uint32_t _addr, T& value, uint32_t _sz,
   return true;
 }
 
+#include "SPIFlashT.h"
+#include "SPIFlashWriteBuffer.h"
+#include "SPIFlashVolume.h"
+
 #endif // _SPIFLASH_H_
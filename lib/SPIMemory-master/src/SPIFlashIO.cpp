@@ -54,19 +54,23 @@
    //Serial.print(F("_chip.capacity: "));
    //Serial.println(_chip.capacity, HEX);
 
-   if (_submittedAddress + size >= _chip.capacity) {
+   if (size > _chip.capacity) {      // Would wrap around onto itself
+     _troubleshoot(OUTOFBOUNDS);
+     return false;
+   }
+
+   if (_submittedAddress + size > _chip.capacity) {
      //Serial.print(F("_submittedAddress + size: "));
      //Serial.println(_submittedAddress + size, HEX);
-   #ifdef DISABLEOVERFLOW
-     _troubleshoot(OUTOFBOUNDS);
-     return false;					// At end of memory - (!pageOverflow)
-   #else
+     if (_policy & SPIMEMORY_POLICY_NOOVERFLOW) {
+       _troubleshoot(OUTOFBOUNDS);
+       return false;					// At end of memory - (!pageOverflow)
+     }
      _addressOverflow = ((_submittedAddress + size) - _chip.capacity);
      _currentAddress = _addr;
      //Serial.print(F("_addressOverflow: "));
      //Serial.println(_addressOverflow, HEX);
      return true;					// At end of memory - (pageOverflow)
-   #endif
    }
    else {
      _addressOverflow = false;
@@ -77,21 +81,218 @@
    //Serial.println(_currentAddress, HEX);
  }
 
- // Checks to see if the block of memory has been previously written to
+ // Checks to see if the block of memory has been previously written to. Pages known to be erased are not read back
  bool SPIFlash::_notPrevWritten(uint32_t _addr, uint32_t size) {
-   //uint8_t _dat;
+   if (_knownErased(_addr, size)) {
+     return true;
+   }
+   // Read in bulk chunks - a large write would otherwise pay the per-byte call overhead for every byte it checks
+   uint8_t _chunk[SPIMEMORY_VERIFY_CHUNK];
    _beginSPI(READDATA);
-   for (uint32_t i = 0; i < size; i++) {
-     if (_nextByte(READ) != 0xFF) {
-       CHIP_DESELECT;
-       _troubleshoot(PREVWRITTEN);
-       return false;
+   for (uint32_t _offset = 0; _offset < size; _offset += SPIMEMORY_VERIFY_CHUNK) {
+     uint32_t _len = (size - _offset < SPIMEMORY_VERIFY_CHUNK) ? (size - _offset) : SPIMEMORY_VERIFY_CHUNK;
+     _nextBuf(READDATA, _chunk, _len);
+     for (uint32_t i = 0; i < _len; i++) {
+       if (_chunk[i] != 0xFF) {
+         CHIP_DESELECT;
+         _troubleshoot(PREVWRITTEN);
+         return false;
+       }
      }
    }
    CHIP_DESELECT
    return true;
  }
 
+ // Returns true if every page the range touches is marked erased in the map kept by trackErasedPages()
+ bool SPIFlash::_knownErased(uint32_t _addr, uint32_t size) {
+   if (!_erasedPages || !size || _addr + size > _chip.capacity) {
+     return false;
+   }
+   for (uint32_t _page = _addr / SPI_PAGESIZE; _page <= (_addr + size - 1) / SPI_PAGESIZE; _page++) {
+     if (!(_erasedPages[_page / 8] & (1 << (_page % 8)))) {
+       return false;
+     }
+   }
+   return true;
+ }
+
+ // Returns the first of _addr, _addr + size, _addr + 2 * size ... whose size bytes are all 0xFF and fit below _end, or
+ // _end if there is none. The range is read with one read command, a chunk at a time, and the run of 0xFF bytes is
+ // followed as it goes - so the cost is one command however many slots are passed over
+ uint32_t SPIFlash::_findFree(uint32_t _addr, uint32_t size, uint32_t _end) {
+   if (_end > _chip.capacity || _addr >= _end || _end - _addr < size) {
+     return _end;
+   }
+   if (_knownErased(_addr, size)) {
+     return _addr;
+   }
+   if (!_prep(READDATA, _addr, _end - _addr)) {
+     return _end;
+   }
+   uint8_t _chunk[SPIMEMORY_VERIFY_CHUNK];
+   uint32_t _slot = _addr;       // First slot at or after the start of the run of 0xFF bytes read so far
+   uint32_t _found = _end;
+   _beginRead(false);
+   for (uint32_t _pos = _addr; _pos < _end && _found == _end; _pos += SPIMEMORY_VERIFY_CHUNK) {
+     uint32_t _len = (_end - _pos < SPIMEMORY_VERIFY_CHUNK) ? (_end - _pos) : SPIMEMORY_VERIFY_CHUNK;
+     _readNext(_chunk, _len);
+     for (uint32_t i = 0; i < _len; i++) {
+       if (_chunk[i] != 0xFF) {
+         _slot = _addr + ((_pos + i + 1 - _addr + size - 1) / size) * size;
+       }
+       else if (_pos + i + 1 == _slot + size) {
+         _found = _slot;
+         break;
+       }
+     }
+   }
+   _endRead();
+   _endSPI();
+   return _found;
+ }
+
+ // Finds where the data on the chip ends, for getAddress(). Data is taken to have been written from the bottom of the
+ // chip up, so the first blank page is found by a binary search - one page read per step, ~log2(pages) in all - and
+ // _freeFrom is set to just past the last byte written in the page before it
+ void SPIFlash::_findFreeFrom(void) {
+   uint8_t _page[SPI_PAGESIZE];
+   uint32_t _low = 0;
+   uint32_t _high = _chip.capacity / SPI_PAGESIZE;
+   while (_low < _high) {
+     uint32_t _mid = _low + (_high - _low) / 2;
+     bool _blank = _knownErased(_mid * SPI_PAGESIZE, SPI_PAGESIZE);
+     if (!_blank && readByteArray(_mid * SPI_PAGESIZE, _page, SPI_PAGESIZE)) {
+       uint16_t i = 0;
+       while (i < SPI_PAGESIZE && _page[i] == 0xFF) {
+         i++;
+       }
+       _blank = (i == SPI_PAGESIZE);
+     }
+     if (_blank) {
+       _high = _mid;
+     }
+     else {
+       _low = _mid + 1;
+     }
+   }
+   _freeFrom = _low * SPI_PAGESIZE;
+   if (_low && readByteArray((_low - 1) * SPI_PAGESIZE, _page, SPI_PAGESIZE)) {
+     uint16_t i = SPI_PAGESIZE;
+     while (i && _page[i - 1] == 0xFF) {
+       i--;
+     }
+     _freeFrom = (_low - 1) * SPI_PAGESIZE + i;
+   }
+   _freeFromKnown = true;
+ }
+
+ // Marks every page the range touches as erased or not erased. Does nothing unless trackErasedPages() has been called
+ void SPIFlash::_markPages(uint32_t _addr, uint32_t size, bool erased) {
+   if (!_erasedPages || !size) {
+     return;
+   }
+   uint32_t _lastPage = (_addr + size - 1) / SPI_PAGESIZE;
+   if (_lastPage >= _chip.capacity / SPI_PAGESIZE) {
+     _lastPage = (_chip.capacity / SPI_PAGESIZE) - 1;
+   }
+   for (uint32_t _page = _addr / SPI_PAGESIZE; _page <= _lastPage; _page++) {
+     if (erased) {
+       _erasedPages[_page / 8] |= (1 << (_page % 8));
+     }
+     else {
+       _erasedPages[_page / 8] &= ~(1 << (_page % 8));
+     }
+   }
+ }
+
+ // Updates the erased page map from data just read at _currentAddress - every whole page in the buffer is marked as
+ // erased or not, depending on whether it is all 0xFF
+ void SPIFlash::_checkErasedPages(const uint8_t *data_buffer, uint32_t size) {
+   if (!_erasedPages || _addressOverflow) {
+     return;
+   }
+   uint32_t _offset = (SPI_PAGESIZE - (_currentAddress % SPI_PAGESIZE)) % SPI_PAGESIZE;
+   for (; _offset + SPI_PAGESIZE <= size; _offset += SPI_PAGESIZE) {
+     bool _blank = true;
+     for (uint16_t i = 0; i < SPI_PAGESIZE; i++) {
+       if (data_buffer[_offset + i] != 0xFF) {
+         _blank = false;
+         break;
+       }
+     }
+     _markPages(_currentAddress + _offset, SPI_PAGESIZE, _blank);
+   }
+ }
+
+ // Returns true if the verify policy reads back any part of the range
+ bool SPIFlash::_verifyWanted(uint32_t _addr, uint32_t size) {
+   if (_verifyPolicy == SPIMEMORY_VERIFY_OFF) {
+     return false;
+   }
+   if (_verifyPolicy != SPIMEMORY_VERIFY_SAMPLED) {
+     return true;
+   }
+   for (uint32_t _page = _addr / SPI_PAGESIZE; _page <= (_addr + size - 1) / SPI_PAGESIZE; _page++) {
+     if ((_page % (_chip.capacity / SPI_PAGESIZE)) % _verifyInterval == 0) {
+       return true;
+     }
+   }
+   return false;
+ }
+
+ // Reads back a range that has just been written and checks it against data_buffer, as the verify policy says.
+ // The range is read in SPIMEMORY_VERIFY_CHUNK byte bulk reads rather than one byte at a time
+ bool SPIFlash::_verify(uint32_t _addr, const uint8_t *data_buffer, uint32_t size) {
+   if (!_notBusy()) {
+     return false;
+   }
+   uint8_t _chunk[SPIMEMORY_VERIFY_CHUNK];
+   uint32_t _offset = 0;
+   while (_offset < size) {
+     uint32_t _chunkAddr = (_addr + _offset) % _chip.capacity;     // Writes wrap to 0 at the end of the chip
+     uint32_t _len = size - _offset;
+     if (_len > SPIMEMORY_VERIFY_CHUNK) {
+       _len = SPIMEMORY_VERIFY_CHUNK;
+     }
+     if (_len > _chip.capacity - _chunkAddr) {
+       _len = _chip.capacity - _chunkAddr;
+     }
+     if (_verifyPolicy == SPIMEMORY_VERIFY_SAMPLED) {
+       if (_len > SPI_PAGESIZE - (_chunkAddr % SPI_PAGESIZE)) {
+         _len = SPI_PAGESIZE - (_chunkAddr % SPI_PAGESIZE);      // One page at a time, so skipped pages are not read
+       }
+       if ((_chunkAddr / SPI_PAGESIZE) % _verifyInterval != 0) {
+         _offset += _len;
+         continue;
+       }
+     }
+     _currentAddress = _chunkAddr;
+     _addressOverflow = false;
+     _readData(false, _chunk, _len);
+     if (memcmp(_chunk, &data_buffer[_offset], _len) != 0) {
+       _endSPI();
+       _troubleshoot(ERRORCHKFAIL);
+       return false;
+     }
+     _offset += _len;
+   }
+   _endSPI();
+   return true;
+ }
+
+ // Continues a CRC-32 (IEEE 802.3, as zlib's crc32()) over size more bytes. Start with crc = 0
+ uint32_t SPIFlash::crc32(uint32_t crc, const uint8_t *data_buffer, uint32_t size) {
+   crc = ~crc;
+   for (uint32_t i = 0; i < size; i++) {
+     crc ^= data_buffer[i];
+     for (uint8_t j = 0; j < 8; j++) {
+       crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+     }
+   }
+   return ~crc;
+ }
+
  //Double checks all parameters before calling a read or write. Comes in two variants
  //Takes address and returns the address if true, else returns false. Throws an error if there is a problem.
  bool SPIFlash::_prep(uint8_t opcode, uint32_t _addr, uint32_t size) {
@@ -105,15 +306,11 @@
      case PAGEPROG:
      //Serial.print(F("Address being prepped: "));
      //Serial.println(_addr);
-     #ifndef HIGHSPEED
-       if(_isChipPoweredDown() || !_addressCheck(_addr, size) || !_notPrevWritten(_addr, size) || !_notBusy() || !_writeEnable()) {
-         return false;
-       }
-     #else
-       if (_isChipPoweredDown() || !_addressCheck(_addr, size) || !_notBusy() || !_writeEnable()) {
-         return false;
-       }
-     #endif
+     // The chip has to be idle before the range is checked - reads are ignored while a program or erase is running
+     if(_isChipPoweredDown() || !_addressCheck(_addr, size) || !_notBusy() ||
+        (!(_policy & SPIMEMORY_POLICY_HIGHSPEED) && !_notPrevWritten(_addr, size)) || !_writeEnable()) {
+       return false;
+     }
      return true;
      break;
 
@@ -125,7 +322,7 @@
      break;
 
      default:
-       if (_isChipPoweredDown() || !_addressCheck(_addr, size) || !_notBusy()) {
+       if (_isChipPoweredDown() || !_addressCheck(_addr, size) || !_readyToRead(_addr, size)) {
          return false;
        }
      #ifdef ENABLEZERODMA
@@ -148,13 +345,15 @@
  }
 
  bool SPIFlash::_startSPIBus(void) {
-   #ifndef SPI_HAS_TRANSACTION
+   #if !defined (SPI_HAS_TRANSACTION) && !defined (SPIMEMORY_TRANSPORT)
        noInterrupts();
    #endif
 
-   #if defined (ARDUINO_ARCH_SAM)
+   #if defined (SPIMEMORY_TRANSPORT)
+     _bus->beginTransaction();
+   #elif defined (ARDUINO_ARCH_SAM)
      due.SPIInit(DUE_SPI_CLK);
-   #elif defined (ARDUINO_ARCH_SAMD)
+   #elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
      #ifdef SPI_HAS_TRANSACTION
        _spi->beginTransaction(_settings);
      #else
@@ -185,6 +384,12 @@
 
  //Initiates SPI operation - but data is not transferred yet. Always call _prep() before this function (especially when it involves writing or reading to/from an address)
  bool SPIFlash::_beginSPI(uint8_t opcode) {
+   if (_autoAsleep && opcode != RELEASE) {
+     _wakeUp();
+   }
+   if (_autoPowerDown) {
+     _lastAccess = millis();
+   }
    if (!SPIBusState) {
      _startSPIBus();
    }
@@ -198,6 +403,9 @@
      case PAGEPROG:
      _nextByte(WRITE, opcode);
      _transferAddress();
+     _markPages(_currentAddress, 1, false);    // The page wraps, so whatever is sent stays in this page
+     _dropCached(_currentAddress & ~(SPI_PAGESIZE - 1), SPI_PAGESIZE);
+     _busyWith(SPIMEMORY_WAIT_PROGRAM, _typicalTime(TIME_TO_PROGRAM(1), _prgmTimeMultiplier, SPIMEMORY_TYP_BYTEPROG_US));   // At least one byte
      break;
 
      case FASTREAD:
@@ -250,7 +458,9 @@
 
  //Reads/Writes next int. Call 'n' times to read/write 'n' number of integers. Should be called after _beginSPI()
  uint16_t SPIFlash::_nextInt(uint16_t data) {
- #if defined (ARDUINO_ARCH_SAMD)
+ #if defined (SPIMEMORY_TRANSPORT)
+   return _bus->transfer16(data);
+ #elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
    return _spi->transfer16(data);
  #else
    return SPI.transfer16(data);
@@ -258,16 +468,15 @@
  }
 
  //Reads/Writes next data buffer. Should be called after _beginSPI()
+ //On the PAGEPROG path the contents of data_buffer are left untouched, so the same buffer can be used for a later error check
  void SPIFlash::_nextBuf(uint8_t opcode, uint8_t *data_buffer, uint32_t size) {
-   #if !defined(ARDUINO_ARCH_SAM) && !defined(ARDUINO_ARCH_SAMD) && !defined(ARDUINO_ARCH_AVR)
-   uint8_t *_dataAddr = &(*data_buffer);
-   #endif
-
    switch (opcode) {
      case READDATA:
-     #if defined (ARDUINO_ARCH_SAM)
+     #if defined (SPIMEMORY_TRANSPORT)
+       _bus->readBuf(data_buffer, size);
+     #elif defined (ARDUINO_ARCH_SAM)
        due.SPIRecByte(&(*data_buffer), size);
-     #elif defined (ARDUINO_ARCH_SAMD)
+     #elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
        #ifdef ENABLEZERODMA
          spi_read(&(*data_buffer), size);
        #else
@@ -276,34 +485,344 @@
      #elif defined (ARDUINO_ARCH_AVR)
        SPI.transfer(&(*data_buffer), size);
      #else
-       for (uint16_t i = 0; i < size; i++) {
-         *_dataAddr = xfer(NULLBYTE);
-         _dataAddr++;
+       for (uint32_t i = 0; i < size; i++) {
+         data_buffer[i] = xfer(NULLBYTE);
        }
      #endif
      break;
 
      case PAGEPROG:
-     #if defined (ARDUINO_ARCH_SAM)
+     #if defined (SPIMEMORY_TRANSPORT)
+       _bus->writeBuf(data_buffer, size);
+     #elif defined (ARDUINO_ARCH_SAM)
        due.SPISendByte(&(*data_buffer), size);
-     #elif defined (ARDUINO_ARCH_SAMD)
-       #ifdef ENABLEZERODMA
-         spi_write(&(*data_buffer), size);
-       #else
-         _spi->transfer(&data_buffer[0], size);
-       #endif
-     #elif defined (ARDUINO_ARCH_AVR)
-       SPI.transfer(&(*data_buffer), size);
+     #elif defined (ARDUINO_ARCH_SAMD) && defined (ENABLEZERODMA)
+       spi_write(&(*data_buffer), size);
      #else
-       for (uint16_t i = 0; i < size; i++) {
-         xfer(*_dataAddr);
-         _dataAddr++;
+       // SPI.transfer(buf, size) overwrites the buffer with the received bytes, so write byte-by-byte here
+       for (uint32_t i = 0; i < size; i++) {
+         xfer(data_buffer[i]);
        }
      #endif
      break;
    }
  }
 
+ //Picks the read command for the I/O mode and sets dummyBytes to the number of dummy bytes it needs
+ uint8_t SPIFlash::_readOpcode(bool fastRead, uint8_t &dummyBytes) {
+   switch (_ioMode) {
+     case SPIMEMORY_IO_QUADIO:     // The mode byte and 4 dummy clocks on four lines
+     dummyBytes = 3;
+     return FASTREAD_QUADIO;
+
+     case SPIMEMORY_IO_QUAD:
+     dummyBytes = 1;
+     return FASTREAD_QUAD;
+
+     case SPIMEMORY_IO_DUAL:
+     dummyBytes = 1;
+     return FASTREAD_DUAL;
+
+     default:
+     dummyBytes = fastRead ? 1 : 0;
+     return fastRead ? FASTREAD : READDATA;
+   }
+ }
+
+ //Reads size bytes from _currentAddress into data_buffer, through the read cache if there is one. Always call _prep()
+ //before this function. The chip is selected and deselected here - call _endSPI() once done with the bus
+ void SPIFlash::_readData(bool fastRead, uint8_t *data_buffer, uint32_t size) {
+   // Reads that wrap around the end of the chip or would push out half the cache go straight to the chip
+   if (_cacheLines && !_addressOverflow && size <= ((uint32_t)_cacheLines * _cacheLineSize) / 2) {
+     _readCached(fastRead, data_buffer, size);
+   }
+   else {
+     _readChip(fastRead, data_buffer, size);
+   }
+ }
+
+ //Reads size bytes from _currentAddress into data_buffer with one read command
+ void SPIFlash::_readChip(bool fastRead, uint8_t *data_buffer, uint32_t size) {
+ #if defined (SPIMEMORY_TRANSPORT)
+   if (!SPIBusState) {
+     _startSPIBus();
+   }
+   uint8_t _dummyBytes;
+   uint8_t _opcode = _readOpcode(fastRead, _dummyBytes);
+   _bus->readData(_opcode, _currentAddress, address4ByteEnabled ? 4 : 3, _dummyBytes, data_buffer, size, _ioMode);
+ #else
+   _beginSPI(fastRead ? FASTREAD : READDATA);
+   _nextBuf(READDATA, data_buffer, size);
+   CHIP_DESELECT
+ #endif
+   _checkErasedPages(data_buffer, size);
+ }
+
+ //Returns the slot that holds the cache line starting at _line, or -1 if it is not cached
+ int16_t SPIFlash::_cacheFind(uint32_t _line) {
+   for (uint8_t i = 0; i < _cacheLines; i++) {
+     if (_cacheTags[i] == _line) {
+       return i;
+     }
+   }
+   return -1;
+ }
+
+ //Reads the cache line starting at _line from the chip, and returns the slot it went into. If the line carries on from
+ //the last one read, up to _cacheReadAhead lines after it are read with the same command. Read-ahead stops at the end
+ //of the chip, at a line that is already cached and at the range of a suspended erase. Each line replaces the least
+ //recently read one
+ uint8_t SPIFlash::_cacheFill(bool fastRead, uint32_t _line) {
+   uint8_t _count = 1;
+   if (_line == _cacheNext) {
+     while (_count <= _cacheReadAhead) {
+       uint32_t _next = _line + ((uint32_t)_count * _cacheLineSize);
+       if (_next >= _chip.capacity || _cacheFind(_next) >= 0 ||
+           (_erasePending && _next < _eraseAddr + _eraseSize && _next + _cacheLineSize > _eraseAddr)) {
+         break;
+       }
+       _count++;
+     }
+   }
+   uint8_t _slots[SPIMEMORY_CACHE_MAX_READAHEAD + 1];
+   uint32_t _addr = _currentAddress;
+   _currentAddress = _line;
+   _beginRead(fastRead);
+   for (uint8_t n = 0; n < _count; n++) {
+     uint8_t _slot = 0;
+     for (uint8_t i = 1; i < _cacheLines; i++) {
+       if (_cacheUsed[i] < _cacheUsed[_slot]) {
+         _slot = i;
+       }
+     }
+     _readNext(&_cacheData[(uint32_t)_slot * _cacheLineSize], _cacheLineSize);
+     _cacheTags[_slot] = _line + ((uint32_t)n * _cacheLineSize);
+     _cacheUsed[_slot] = ++_cacheClock;
+     _slots[n] = _slot;
+   }
+   _endRead();
+   for (uint8_t n = 0; n < _count; n++) {
+     _currentAddress = _cacheTags[_slots[n]];
+     _checkErasedPages(&_cacheData[(uint32_t)_slots[n] * _cacheLineSize], _cacheLineSize);
+   }
+   _currentAddress = _addr;
+   _cacheStats.misses++;
+   _cacheStats.readAheads += _count - 1;
+   return _slots[0];
+ }
+
+ //Reads size bytes from _currentAddress into data_buffer, a cache line at a time. The range must not wrap around the
+ //end of the chip
+ void SPIFlash::_readCached(bool fastRead, uint8_t *data_buffer, uint32_t size) {
+   uint32_t _offset = 0;
+   while (_offset < size) {
+     uint32_t _addr = _currentAddress + _offset;
+     uint32_t _line = _addr & ~((uint32_t)_cacheLineSize - 1);
+     int16_t _slot = _cacheFind(_line);
+     if (_slot < 0) {
+       _slot = _cacheFill(fastRead, _line);
+     }
+     else {
+       _cacheStats.hits++;
+       _cacheUsed[_slot] = ++_cacheClock;
+     }
+     uint32_t _len = _cacheLineSize - (_addr - _line);
+     if (_len > size - _offset) {
+       _len = size - _offset;
+     }
+     memcpy(&data_buffer[_offset], &_cacheData[((uint32_t)_slot * _cacheLineSize) + (_addr - _line)], _len);
+     _offset += _len;
+     _cacheNext = _line + _cacheLineSize;
+   }
+ }
+
+ //Drops every cache line that overlaps the range. Called when a program or erase is started on it, so that a read can
+ //only fill the line again once the chip is done with it
+ void SPIFlash::_dropCached(uint32_t _addr, uint32_t size) {
+   for (uint8_t i = 0; i < _cacheLines; i++) {
+     if (_cacheTags[i] != SPIMEMORY_CACHE_EMPTY && _cacheTags[i] < _addr + size && _cacheTags[i] + _cacheLineSize > _addr) {
+       _cacheTags[i] = SPIMEMORY_CACHE_EMPTY;
+       _cacheUsed[i] = 0;
+     }
+   }
+ }
+
+ //Opens a read at _currentAddress that is then consumed with _readNext() and closed with _endRead(). Always call _prep() before this function
+ void SPIFlash::_beginRead(bool fastRead) {
+ #if defined (SPIMEMORY_TRANSPORT)
+   if (!SPIBusState) {
+     _startSPIBus();
+   }
+   uint8_t _dummyBytes;
+   uint8_t _opcode = _readOpcode(fastRead, _dummyBytes);
+   _bus->beginRead(_opcode, _currentAddress, address4ByteEnabled ? 4 : 3, _dummyBytes, _ioMode);
+ #else
+   _beginSPI(fastRead ? FASTREAD : READDATA);
+ #endif
+ }
+
+ //Reads the next size bytes of the read opened by _beginRead()
+ void SPIFlash::_readNext(uint8_t *data_buffer, uint32_t size) {
+ #if defined (SPIMEMORY_TRANSPORT)
+   _bus->readNext(data_buffer, size);
+ #else
+   _nextBuf(READDATA, data_buffer, size);
+ #endif
+ }
+
+ //Deselects the chip at the end of a read opened by _beginRead(). Call _endSPI() once done with the bus
+ void SPIFlash::_endRead(void) {
+ #if defined (SPIMEMORY_TRANSPORT)
+   _bus->endRead();
+ #else
+   CHIP_DESELECT
+ #endif
+ }
+
+ //Programs size bytes from data_buffer at _currentAddress, one page at a time. Always call _prep() (or otherwise send the
+ //write enable) before this function. Waits for every page but the last - call _notBusy() or _verify() after it
+ bool SPIFlash::_programPages(const uint8_t *data_buffer, uint32_t size) {
+   uint32_t maxBytes = SPI_PAGESIZE-(_currentAddress % SPI_PAGESIZE);  // Force the first set of bytes to stay within the first page
+   uint32_t data_offset = 0;
+
+   while (true) {
+     uint32_t writeBufSz = (size <= maxBytes) ? size : maxBytes;
+
+     // The first page has been write enabled by _prep(). Every following page sends its write enable along with the data
+     if (!_programPage(&data_buffer[data_offset], writeBufSz, data_offset != 0)) {
+       return false;
+     }
+     size -= writeBufSz;
+     if (!size) {
+       return true;
+     }
+     _currentAddress = (_currentAddress + writeBufSz) % _chip.capacity;   // The chip wraps to 0 - so do the cache and the page map
+     data_offset += writeBufSz;
+     maxBytes = SPI_PAGESIZE;   // Now we can do up to 256 bytes per loop
+
+     if(!_notBusy()){
+       return false;
+     }
+   }
+ }
+
+ //As _programPages(), for the buffers in vec taken one after the other. A page that comes from one buffer is programmed
+ //straight from it. A page that spans buffers is gathered into a page buffer first - the transports take one buffer
+ //per command
+ bool SPIFlash::_programVec(const iovec *vec, uint8_t count, uint32_t size) {
+   uint8_t _page[SPI_PAGESIZE];
+   uint8_t _index = 0;       // Buffer the next byte comes from, and its offset in it
+   uint32_t _offset = 0;
+   bool _first = true;
+
+   while (size) {
+     uint32_t _len = SPI_PAGESIZE - (_currentAddress % SPI_PAGESIZE);
+     if (_len > size) {
+       _len = size;
+     }
+     const uint8_t *_data = _gatherVec(vec, count, _index, _offset, _len, _page);
+     if (!_data) {
+       _troubleshoot(UNKNOWNERROR);
+       return false;
+     }
+
+     // The first page has been write enabled by _prep(). Every following page waits for the one before it and sends
+     // its write enable along with the data
+     if ((!_first && !_notBusy()) || !_programPage(_data, _len, !_first)) {
+       return false;
+     }
+     _first = false;
+     _currentAddress = (_currentAddress + _len) % _chip.capacity;
+     size -= _len;
+   }
+   return true;
+ }
+
+ //Takes the next len bytes of the buffers in vec, from buffer index at offset, and moves index and offset past them.
+ //Returns them straight from their buffer if they are all in one, or gathered into page (at least len bytes) if they
+ //span several. Empty buffers are skipped. NULL if vec runs out first. For the vec writes of SPIFlash and SPIFlashVolume
+ const uint8_t *SPIFlash::_gatherVec(const iovec *vec, uint8_t count, uint8_t &index, uint32_t &offset, uint32_t len, uint8_t *page) {
+   for (uint32_t _copied = 0; _copied < len;) {
+     while (offset == vec[index].iov_len) {
+       if (++index == count) {
+         return NULL;
+       }
+       offset = 0;
+     }
+     uint32_t _part = vec[index].iov_len - offset;
+     if (!_copied && _part >= len) {
+       offset += len;
+       return (const uint8_t*) vec[index].iov_base + offset - len;
+     }
+     if (_part > len - _copied) {
+       _part = len - _copied;
+     }
+     memcpy(&page[_copied], (const uint8_t*) vec[index].iov_base + offset, _part);
+     _copied += _part;
+     offset += _part;
+   }
+   return page;
+ }
+
+ //Returns the total size of the buffers in vec - 0 if there is no vec
+ uint32_t SPIFlash::_vecSize(const iovec *vec, uint8_t count) {
+   uint32_t _size = 0;
+   for (uint8_t i = 0; vec && i < count; i++) {
+     _size += vec[i].iov_len;
+   }
+   return _size;
+ }
+
+ //Reads the size of the string writeStr() wrote at _addr - its length and the null terminator - and gets the chip ready
+ //to read the characters from _currentAddress. Returns false if there is no string there, e.g. on erased flash
+ bool SPIFlash::_readStrSize(uint32_t _addr, uint32_t &size, bool fastRead) {
+   uint8_t _header[sizeof(size)];
+   size = 0;
+   if (!_prep(READDATA, _addr, sizeof(_header))) {
+     return false;
+   }
+   _readData(fastRead, _header, sizeof(_header));
+   _endSPI();
+   for (uint8_t i = 0; i < sizeof(size); i++) {
+     size |= ((uint32_t)_header[i] << (8*i));
+   }
+   if (!size) {
+     _troubleshoot(OUTOFBOUNDS);
+     return false;
+   }
+   return _addressCheck(_addr + sizeof(size), size) && _readyToRead(_addr + sizeof(size), size);
+ }
+
+ //Programs size bytes from data_buffer at _currentAddress. The data must not cross a page boundary
+ //If writeEnable is true, the write enable command is sent first - otherwise it must already have been sent (i.e. by _prep())
+ bool SPIFlash::_programPage(const uint8_t *data_buffer, uint32_t size, bool writeEnable) {
+   uint32_t _datasheet = SPIMEMORY_TYP_BYTEPROG_US + ((SPIMEMORY_TYP_PAGEPROG_US - SPIMEMORY_TYP_BYTEPROG_US) * size) / SPI_PAGESIZE;
+   uint32_t _expected = _typicalTime((TIME_TO_PROGRAM(size) < _pagePrgmTime) ? TIME_TO_PROGRAM(size) : _pagePrgmTime, _prgmTimeMultiplier, _datasheet);
+   _markPages(_currentAddress, size, false);
+   _dropCached(_currentAddress, size);
+ #if defined (SPIMEMORY_TRANSPORT)
+   if (!SPIBusState) {
+     _startSPIBus();
+   }
+   _busyWith(SPIMEMORY_WAIT_PROGRAM, _expected);
+   if (_ioMode == SPIMEMORY_IO_QUAD || _ioMode == SPIMEMORY_IO_QUADIO) {
+     return _bus->programPage(PAGEPROG_QUAD, _currentAddress, address4ByteEnabled ? 4 : 3, data_buffer, size, writeEnable, SPIMEMORY_IO_QUAD);
+   }
+   return _bus->programPage(PAGEPROG, _currentAddress, address4ByteEnabled ? 4 : 3, data_buffer, size, writeEnable);
+ #else
+   if (writeEnable && !_writeEnable()) {
+     return false;
+   }
+   _busyWith(SPIMEMORY_WAIT_PROGRAM, _expected);     // After the write enable - reading WEL back also reads BUSY
+   CHIP_SELECT
+   _nextByte(WRITE, PAGEPROG);
+   _transferAddress();
+   _nextBuf(PAGEPROG, (uint8_t*) data_buffer, size);
+   CHIP_DESELECT
+   return true;
+ #endif
+ }
+
  //Stops all operations. Should be called after all the required data is read/written from repeated _nextByte() calls
  void SPIFlash::_endSPI(void) {
    CHIP_DESELECT
@@ -311,9 +830,15 @@
    if (address4ByteEnabled) {          // If the previous operation enabled 4-byte addressing, disable it
      _disable4ByteAddressing();
    }
+   _stopSPIBus();
+ }
 
- #ifdef SPI_HAS_TRANSACTION
-   #if defined (ARDUINO_ARCH_SAMD)
+ //Lets go of the SPI bus - the counterpart of _startSPIBus(). The next _beginSPI() takes it again
+ void SPIFlash::_stopSPIBus(void) {
+ #if defined (SPIMEMORY_TRANSPORT)
+   _bus->endTransaction();
+ #elif defined (SPI_HAS_TRANSACTION)
+   #if defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
      _spi->endTransaction();
    #else
      SPI.endTransaction();
@@ -329,10 +854,13 @@
  }
 
  // Checks if status register 1 can be accessed - used to check chip status, during powerdown and power up and for debugging
+ //Every read of status register 1 refreshes what is known about BUSY and WEL
  uint8_t SPIFlash::_readStat1(void) {
    _beginSPI(READSTAT1);
    stat1 = _nextByte(READ);
    CHIP_DESELECT
+   _knownIdle = !(stat1 & BUSY);
+   _knownWEL = stat1 & WRTEN;
    return stat1;
  }
 
@@ -356,7 +884,11 @@
 
  // Checks to see if 4-byte addressing is already enabled and if not, enables it
  bool SPIFlash::_enable4ByteAddressing(void) {
+   if (address4ByteEnabled) {
+     return true;
+   }
    if (_readStat3() & ADS) {
+     address4ByteEnabled = true;
      return true;
    }
    _beginSPI(ADDR4BYTE_EN);
@@ -371,9 +903,57 @@
    }
  }
 
+ // Sets the Quad Enable bit in status register 2 if it is not set already. QE is non-volatile, so this only writes
+ // the register once in the life of the chip (the IQ parts leave the factory with it set)
+ bool SPIFlash::_enableQuad(void) {
+   if (_readStat2() & QE) {
+     return true;
+   }
+   if (!_notBusy() || !_writeEnable()) {
+     return false;
+   }
+   _beginSPI(WRITESTAT2);
+   _nextByte(WRITE, (stat2 | QE) & ~SUS);
+   CHIP_DESELECT
+   _busyWith(SPIMEMORY_WAIT_OTHER, 0);
+   if (!_notBusy() || !(_readStat2() & QE)) {
+     return false;
+   }
+   return true;
+ }
+
+ // Checks if both the chip and the transport can be driven in ioMode. The quad modes are enabled on the chip here
+ // Winbond chips have all of them. Other chips need SFDP tables that list the mode with the same instruction and wait
+ // clocks as the Winbond one - and, for the quad modes, a Quad Enable bit that is set the same way
+ bool SPIFlash::_ioModeSupported(uint8_t ioMode) {
+   if (ioMode == SPIMEMORY_IO_SINGLE) {
+     return true;
+   }
+ #if defined (SPIMEMORY_TRANSPORT)
+   if (_chip.manufacturerID != WINBOND_MANID) {
+     uint8_t _needed = (ioMode == SPIMEMORY_IO_DUAL) ? SFDP_IO_DUAL :
+                       (ioMode == SPIMEMORY_IO_QUAD) ? (SFDP_IO_QUAD | SFDP_IO_QE) : (SFDP_IO_QUADIO | SFDP_IO_QE);
+     if ((_sfdpIOModes & _needed) != _needed) {
+       return false;
+     }
+   }
+   if (!_bus->supportsIOMode(ioMode)) {
+     return false;
+   }
+   if (DATALINES(ioMode) == 4) {
+     bool _retVal = _enableQuad();
+     _endSPI();
+     return _retVal;
+   }
+   return true;
+ #else
+   return false;
+ #endif
+ }
+
  // Checks to see if 4-byte addressing is already disabled and if not, disables it
  bool SPIFlash::_disable4ByteAddressing(void) {
-   if (!(_readStat3() & ADS)) {      // If 4 byte addressing is disabled (default state)
+   if (!address4ByteEnabled) {      // Only _enable4ByteAddressing() switches the chip to 4-byte mode
      return true;
    }
    _beginSPI(ADDR4BYTE_DIS);
@@ -408,7 +988,14 @@
  }
 
  // Checks to see if chip is powered down. If it is, retrns true. If not, returns false.
+ // A chip powered down by powerDownIfIdle() is woken up instead - it only counts as powered down after powerDown()
  bool SPIFlash::_isChipPoweredDown(void) {
+   if (_autoAsleep) {
+     _wakeUp();
+   }
+   if (_autoPowerDown) {
+     _lastAccess = millis();
+   }
    if (chipPoweredDown) {
      _troubleshoot(CHIPISPOWEREDDOWN);
      return true;
@@ -418,30 +1005,316 @@
    }
  }
 
- // Polls the status register 1 until busy flag is cleared or timeout
+ // Waits until the busy flag in status register 1 is cleared, or timeout (in microseconds) runs out. A timeout of
+ // BUSY_TIMEOUT - the default - is cut down to the worst case time of the operation that was started last (_maxBusyTime())
+ // The chip is polled once. If it is busy, the wait lets go of the SPI bus and sleeps for whatever is left of the typical
+ // time of the operation that was started last (see _busyWith()), then polls with a doubling interval. Sleeps of a
+ // millisecond or more go through delay(), which hands the CPU to other tasks on RTOS based cores
  bool SPIFlash::_notBusy(uint32_t timeout) {
+   if (_suspendedForRead) {
+     _resumeErase();
+   }
+   if (_knownIdle) {
+     return true;
+   }
    _delay_us(WINBOND_WRITE_DELAY);
    uint32_t _time = micros();
+   _readStat1();
+   if (!(stat1 & BUSY)) {
+     _operationDone();
+     return true;
+   }
 
-   do {
+   if (timeout == BUSY_TIMEOUT) {
+     timeout = _maxBusyTime();
+   }
+   waitStats &_stats = _waitStats[_busyOp];
+   uint32_t _polls = 1;
+   uint32_t _yielded = 0;
+   uint32_t _interval = SPIMEMORY_POLL_MIN_US;
+   uint32_t _sinceStart = _time - _busyStart;
+   uint32_t _sleep = (_busyExpected > _sinceStart) ? (_busyExpected - _sinceStart) : _interval;
+   bool _retVal = true;
+
+   while (true) {
+     uint32_t _elapsed = micros() - _time;
+     if (_elapsed >= timeout) {
+       _troubleshoot(CHIPBUSY);
+       _retVal = false;
+       break;
+     }
+     _stopSPIBus();
+     _yielded += _idle((_sleep < timeout - _elapsed) ? _sleep : (timeout - _elapsed));
      _readStat1();
-     if (!(stat1 & BUSY))
-     {
-       return true;
+     _polls++;
+     if (!(stat1 & BUSY)) {
+       break;
      }
+     _sleep = _interval;
+     _interval = (_interval < SPIMEMORY_POLL_MAX_US / 2) ? (_interval * 2) : SPIMEMORY_POLL_MAX_US;
+   }
+
+   uint32_t _waited = micros() - _time;
+   _stats.waits++;
+   _stats.polls += _polls;
+   _stats.waitTime += _waited;
+   _stats.yieldTime += _yielded;
+   if (_waited > _stats.maxWaitTime) {
+     _stats.maxWaitTime = _waited;
+   }
+   if (_retVal) {
+     _operationDone();
+   }
+   return _retVal;
+ }
+
+ // Clears what is kept about the program or erase that has just finished. A finished erase marks its pages as blank
+ void SPIFlash::_operationDone(void) {
+   _programPending = false;
+   _busyOp = SPIMEMORY_WAIT_OTHER;
+   _busyExpected = 0;
+   if (_erasePending) {
+     _erasePending = false;
+     _markPages(_eraseAddr, _eraseSize, true);
+     if (_eraseAddr < _freeFrom && _eraseAddr + _eraseSize >= _freeFrom) {
+       _freeFrom = _eraseAddr;     // The erase reached the blank space above the data, so it now starts lower down
+     }
+   }
+ }
+
+ // Records the operation that has just been started, so that _notBusy() knows how long it should take
+ //  Takes two arguments -
+ //    1. waitType --> SPIMEMORY_WAIT_PROGRAM, SPIMEMORY_WAIT_ERASE4K, ... - the statistics the wait is counted under
+ //    2. expected --> Typical time the chip stays busy (us). 0 if unknown
+ void SPIFlash::_busyWith(uint8_t waitType, uint32_t expected) {
+   _busyOp = waitType;
+   _busyExpected = expected;
+   _busyStart = micros();
+   _knownIdle = _knownWEL = false;     // Program, erase and status register writes all clear WEL when they finish
+ }
+
+ // Drops what is known about BUSY and WEL, so the next _notBusy() / _writeEnable() ask the chip again. For commands that
+ // change the chip state in ways that are not tracked, i.e. suspend, resume, power-down and release from power-down
+ void SPIFlash::_forgetChipState(void) {
+   _knownIdle = _knownWEL = false;
+ }
+
+ // Wakes up a chip powered down by powerDownIfIdle(): Release Power-down, then tRES1 before it takes the next command
+ void SPIFlash::_wakeUp(void) {
+   uint32_t _start = micros();
+   _autoAsleep = false;
+   _beginSPI(RELEASE);
+   _endSPI();
+   _forgetChipState();
+   _delay_us(SPIMEMORY_TRES1_US);
+   chipPoweredDown = false;
+   uint32_t _time = micros() - _start;
+   _powerStats.wakeUps++;
+   _powerStats.wakeTime += _time;
+   if (_time > _powerStats.maxWakeTime) {
+     _powerStats.maxWakeTime = _time;
+   }
+   _powerStats.timeAsleep += millis() - _asleepSince;
+ }
+
+ // Sends the erase instruction for the 4KB sector / 32KB block / 64KB block containing _addr, or for the whole chip, and
+ // returns without waiting
+ //  Takes two arguments -
+ //    1. _addr --> Any address in the sector / block. 0 for the chip
+ //    2. waitType --> SPIMEMORY_WAIT_ERASE4K, SPIMEMORY_WAIT_ERASE32K, SPIMEMORY_WAIT_ERASE64K or SPIMEMORY_WAIT_CHIPERASE
+ bool SPIFlash::_startErase(uint32_t _addr, uint8_t waitType) {
+   eraseParam *_erase;
+   uint32_t _size, _datasheetTime;
+   switch (waitType) {
+     case SPIMEMORY_WAIT_ERASE4K:
+     _erase = &kb4Erase;
+     _size = KB(4);
+     _datasheetTime = SPIMEMORY_TYP_ERASE4K_US;
+     break;
+
+     case SPIMEMORY_WAIT_ERASE32K:
+     _erase = &kb32Erase;
+     _size = KB(32);
+     _datasheetTime = SPIMEMORY_TYP_ERASE32K_US;
+     break;
+
+     case SPIMEMORY_WAIT_CHIPERASE:
+     _erase = &chipErase;
+     _size = _chip.capacity;
+     _datasheetTime = SPIMEMORY_TYP_CHIPERASE_US;
+     break;
+
+     default:
+     _erase = &kb64Erase;
+     _size = KB(64);
+     _datasheetTime = SPIMEMORY_TYP_ERASE64K_US;
+     break;
+   }
+   _eraseFailed = true;
+   if (!_erase->supported) {
+     _troubleshoot(UNSUPPORTEDFUNC);
+     return false;
+   }
+   if (!_prep(ERASEFUNC, _addr, _size)) {
+     return false;
+   }
+   _dropCached(_addr & ~(_size - 1), _size);
+   _beginSPI(_erase->opcode);   //The address is transferred as a part of this function
+   _endSPI();
+   _busyWith(waitType, _typicalTime(_erase->time, _eraseTimeMultiplier, _datasheetTime));
+   _eraseAddr = _addr & ~(_size - 1);
+   _eraseSize = _size;
+   _erasePending = true;
+   _eraseFailed = false;
+   _suspends = 0;
+   _resumedAt = _busyStart;
+   return true;
+ }
+
+ // Picks the largest erase that starts at _addr and does not go past _remaining bytes from it: a 64KB or 32KB block where
+ // _addr is aligned to one and the range covers all of it, and a 4KB sector everywhere else
+ //  Takes three arguments -
+ //    1. _addr --> Start of the rest of the range. Has to be 4KB aligned
+ //    2. _remaining --> Bytes left in the range. A multiple of 4KB
+ //    3. size --> Set to the bytes the erase covers
+ //  Returns SPIMEMORY_WAIT_ERASE64K, SPIMEMORY_WAIT_ERASE32K or SPIMEMORY_WAIT_ERASE4K
+ uint8_t SPIFlash::_planStep(uint32_t _addr, uint32_t _remaining, uint32_t &size) {
+   if (kb64Erase.supported && !(_addr & (KB(64) - 1)) && _remaining >= KB(64)) {
+     size = KB(64);
+     return SPIMEMORY_WAIT_ERASE64K;
+   }
+   if (kb32Erase.supported && !(_addr & (KB(32) - 1)) && _remaining >= KB(32)) {
+     size = KB(32);
+     return SPIMEMORY_WAIT_ERASE32K;
+   }
+   size = KB(4);
+   return SPIMEMORY_WAIT_ERASE4K;
+ }
+
+ // Starts the next erase of the range handed to eraseSectionAsync(). Past the end of the chip the range goes on from
+ // address 0 - blocks never straddle the end, as the capacity is a multiple of 64KB
+ bool SPIFlash::_continueSection(void) {
+   uint32_t _size;
+   uint32_t _addr = _sectionNext % _chip.capacity;
+   uint8_t _waitType = _planStep(_addr, _sectionLeft, _size);
+   _sectionNext += _size;
+   _sectionLeft -= _size;
+   if (!_startErase(_addr, _waitType)) {
+     _sectionLeft = 0;
+     return false;
+   }
+   return true;
+ }
 
-   } while ((micros() - _time) < timeout);
-   if (timeout <= (micros() - _time)) {
-     _troubleshoot(CHIPBUSY);
+ // Gets the chip ready for a read of size bytes from _addr - suspends a running erase when it can (see setReadSuspend())
+ // and waits for it to finish when it cannot
+ bool SPIFlash::_readyToRead(uint32_t _addr, uint32_t size) {
+   return _suspendForRead(_addr, size) || _notBusy();
+ }
+
+ // Suspends the running erase so that size bytes from _addr can be read. Returns false - and leaves it to _notBusy() -
+ // when no erase is running, the chip is not a Winbond, the read overlaps the range being erased, the erase has been
+ // suspended maxSuspends times already, or it finishes before it can be suspended
+ bool SPIFlash::_suspendForRead(uint32_t _addr, uint32_t size) {
+   if (!_erasePending || _chip.manufacturerID != WINBOND_MANID ||
+       (_addr < _eraseAddr + _eraseSize && _addr + size > _eraseAddr)) {
+     return false;
+   }
+   if (_suspendedForRead) {
+     return true;
+   }
+   if (_suspends >= _maxSuspends) {
+     return false;
+   }
+   uint32_t _ran = micros() - _resumedAt;
+   if (_ran < _minRunTime) {
+     _stopSPIBus();
+     _idle(_minRunTime - _ran);     // Every suspend costs the erase some progress - let it make some between them
+   }
+   _beginSPI(SUSPEND);
+   _endSPI();
+   _forgetChipState();
+   _suspendedForRead = true;
+   uint32_t _time = micros();
+   while (_readStat1() & BUSY) {      // BUSY clears within tSUS
+     if (micros() - _time >= SPIMEMORY_SUSPEND_TIMEOUT_US) {
+       return false;                  // _notBusy() resumes the erase and waits for it
+     }
+   }
+   if (!(_readStat2() & SUS)) {       // The erase finished before the suspend instruction came
+     _suspendedForRead = false;
+     _operationDone();
      return false;
    }
+   _suspends++;
    return true;
  }
 
+ // Resumes the erase suspended by _suspendForRead()
+ void SPIFlash::_resumeErase(void) {
+   _beginSPI(RESUME);
+   CHIP_DESELECT
+   _suspendedForRead = false;
+   _resumedAt = micros();
+   _forgetChipState();
+ }
+
+ // Sleeps for about us microseconds and returns how much of it was spent in delay()
+ uint32_t SPIFlash::_idle(uint32_t us) {
+   uint32_t _yielded = 0;
+   if (us >= 1000) {
+     uint32_t _time = micros();
+     delay(us / 1000);
+     _yielded = micros() - _time;
+     us %= 1000;
+   }
+   if (us) {
+     delayMicroseconds(us);      // Not _delay_us() - the AVR version only takes constants
+   }
+   return _yielded;
+ }
+
+ // Turns a maximum time from SFDP back into the typical time it was derived from (JESD216: max = typical * multiplier)
+ // Without SFDP timings, Winbond chips get the datasheet time and anything else gets 0 (poll from the start)
+ uint32_t SPIFlash::_typicalTime(uint32_t maxTime, uint16_t multiplier, uint32_t datasheetTime) {
+   if (!_chip.sfdpAvailable || !multiplier || maxTime >= BUSY_TIMEOUT) {
+     return (_chip.manufacturerID == WINBOND_MANID) ? datasheetTime : 0;
+   }
+   return maxTime / multiplier;
+ }
+
+ // The maximum time from SFDP or the SPIFlashT<> chip descriptor, or the datasheet one of the Winbond chips without either
+ uint32_t SPIFlash::_worstTime(uint32_t maxTime, uint32_t datasheetTime) {
+   return (maxTime < BUSY_TIMEOUT) ? maxTime : datasheetTime;
+ }
+
+ // The longest the operation that was started last (see _busyWith()) can keep the chip busy, from the maximum times of
+ // SFDP, saved chipParams or the SPIFlashT<> chip descriptor. BUSY_TIMEOUT if the operation or its time is not known
+ uint32_t SPIFlash::_maxBusyTime(void) {
+   uint32_t _maxTime;
+   switch (_busyOp) {
+     case SPIMEMORY_WAIT_PROGRAM:   _maxTime = _pagePrgmTime;   break;
+     case SPIMEMORY_WAIT_ERASE4K:   _maxTime = kb4Erase.time;   break;
+     case SPIMEMORY_WAIT_ERASE32K:  _maxTime = kb32Erase.time;  break;
+     case SPIMEMORY_WAIT_ERASE64K:  _maxTime = kb64Erase.time;  break;
+     case SPIMEMORY_WAIT_CHIPERASE: _maxTime = chipErase.time;  break;
+     default:                       _maxTime = BUSY_TIMEOUT;    break;
+   }
+   return (_maxTime < BUSY_TIMEOUT) ? _maxTime : BUSY_TIMEOUT;
+ }
+
  //Enables writing to chip by setting the WRITEENABLE bit
+ //WEL is read back only when the chip state is not known - while the chip is idle and powered up, WREN always sets it
  bool SPIFlash::_writeEnable(bool _troubleshootEnable) {
+   if (_knownWEL) {
+     return true;
+   }
    _beginSPI(WRITEENABLE);
    CHIP_DESELECT
+   if (_knownIdle && !chipPoweredDown) {
+     _knownWEL = true;
+     return true;
+   }
    if (!(_readStat1() & WRTEN)) {
      if (_troubleshootEnable) {
        _troubleshoot(CANTENWRITE);
@@ -459,6 +1332,7 @@
  bool SPIFlash::_writeDisable(void) {
  	_beginSPI(WRITEDISABLE);
    CHIP_DESELECT
+   _knownWEL = false;
  	return true;
  }
 
@@ -505,6 +1379,7 @@
      _beginSPI(WRITESTAT1);
      _nextByte(WRITE, _tempStat1);
      CHIP_DESELECT
+     _busyWith(SPIMEMORY_WAIT_OTHER, 0);
    }
    else if (_chip.memoryTypeID == SST26) {
      if(!_notBusy()) {
@@ -514,6 +1389,7 @@
      _delay_us(10);
      _beginSPI(ULBPR);
      CHIP_DESELECT
+     _busyWith(SPIMEMORY_WAIT_OTHER, 0);
      _delay_us(50);
      _writeDisable();
    }
@@ -521,8 +1397,8 @@
  }
 
  //Identifies the chip
- bool SPIFlash::_chipID(uint32_t flashChipSize) {
-   //set some default values
+ //Sets the erase parameters and page size that every chip starts with, before SFDP or the ID tables refine them
+ void SPIFlash::_defaultChipParams(void) {
    kb4Erase.supported = kb32Erase.supported = kb64Erase.supported = chipErase.supported = true;
    kb4Erase.opcode = SECTORERASE;
    kb32Erase.opcode = BLOCK32ERASE;
@@ -534,6 +1410,27 @@
    chipErase.opcode = CHIPERASE;
    chipErase.time = kb64Erase.time * 100L;
    _pageSize = SPI_PAGESIZE;
+   _pagePrgmTime = _byteFirstPrgmTime = _byteAddnlPrgmTime = BUSY_TIMEOUT;   // Not known until SFDP provides them
+   _eraseTimeMultiplier = _prgmTimeMultiplier = 0;   // No typical times until SFDP provides them
+   _sfdpIOModes = 0;
+ }
+
+ //Takes the chip whose JEDEC ID has just been read to be the one given, with the given capacity - for SPIFlashT<>, which
+ //knows its chip at build time. Fails with UNKNOWNCHIP if the ID is not the expected one
+ bool SPIFlash::_useChip(uint8_t manufacturerID, uint8_t memoryTypeID, uint8_t capacityID, uint32_t capacity) {
+   if (_chip.manufacturerID != manufacturerID || _chip.memoryTypeID != memoryTypeID || _chip.capacityID != capacityID) {
+     _troubleshoot(UNKNOWNCHIP);
+     return false;
+   }
+   _chip.supported = _chip.supportedMan = true;
+   _chip.sfdpAvailable = false;
+   _chip.capacity = capacity;
+   return true;
+ }
+
+ bool SPIFlash::_chipID(uint32_t flashChipSize) {
+   //set some default values
+   _defaultChipParams();
 
    _getJedecId();
 
@@ -554,9 +1451,7 @@
 
      //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ Begin SFDP ID section ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
     #ifdef USES_SFDP
-     if (_checkForSFDP()) {
-       _getSFDPFlashParam();
-     }
+     _getSFDPFlashParam();
     #endif
      //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ End SFDP ID section ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 
@@ -27,25 +27,24 @@
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 //     Private Functions that retrieve date from the SFDP tables      //
 //              - if the flash chip supports SFDP                     //
+//    The headers and each table are read in one burst and parsed     //
+//                            from RAM                                //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 
-// This function returns the SFDP table requested as an array of 32 bit integers
-bool SPIFlash::_getSFDPTable(uint32_t _address, uint8_t *data_buffer, uint8_t numberOfDWords) {
-  if(!_notBusy()) {
-   return false;
-  }
-  _beginSPI(READSFDP);
-  _nextByte(WRITE, Higher(_address));
-  _nextByte(WRITE, Hi(_address));
-  _nextByte(WRITE, Lo(_address));
-  _nextByte(WRITE, DUMMYBYTE);
-  _nextBuf(READDATA, &(*data_buffer), numberOfDWords*4); //*4 to convert from dWords to bytes
-  CHIP_DESELECT
-  return true;
+// Returns DWORD dWordNumber (1 based, as in JESD216) of an SFDP table that has been read into table
+static uint32_t _SFDPdword(const uint8_t *table, uint16_t dWordNumber) {
+  const uint8_t *_dword = &table[(dWordNumber - 1) * 4];
+  return (uint32_t)_dword[0] | ((uint32_t)_dword[1] << 8) | ((uint32_t)_dword[2] << 16) | ((uint32_t)_dword[3] << 24);
+}
+
+// Checks a 16-bit fast read field of the BFPT (opcode in the top byte, mode clocks in bits 7:5, dummy clocks in bits 4:0)
+// against the instruction and the number of wait clocks the library sends for that mode
+static bool _SFDPreadMatches(uint16_t field, uint8_t opcode, uint8_t waitClocks) {
+  return (field >> 8) == opcode && ((field & 0x1F) + ((field >> 5) & 0x07)) == waitClocks;
 }
 
-// This function returns a custom length of data from the SFDP table requested as an array of 8 bit integers (bytes)
-bool SPIFlash::_getSFDPData(uint32_t _address, uint8_t *data_buffer, uint8_t numberOfBytes) {
+// Reads numberOfBytes of the SFDP area into data_buffer, from _address on, with one READSFDP command
+bool SPIFlash::_getSFDPData(uint32_t _address, uint8_t *data_buffer, uint16_t numberOfBytes) {
   if(!_notBusy()) {
    return false;
   }
@@ -54,74 +53,11 @@ bool SPIFlash::_getSFDPData(uint32_t _address, uint8_t *data_buffer, uint8_t num
   _nextByte(WRITE, Hi(_address));
   _nextByte(WRITE, Lo(_address));
   _nextByte(WRITE, DUMMYBYTE);
-  _nextBuf(READDATA, &(*data_buffer), numberOfBytes); //*4 to convert from dWords to bytes
+  _nextBuf(READDATA, &(*data_buffer), numberOfBytes);
   CHIP_DESELECT
   return true;
 }
 
-//dWordNumber can be between 1 to 256
-uint32_t SPIFlash::_getSFDPdword(uint32_t _tableAddress, uint8_t dWordNumber) {
-  if(!_notBusy()) {
-   return false;
-  }
-  union {
-    uint32_t dWord;
-    uint8_t byteArray[4];
-  } SFDPdata;
-  uint32_t _address = ADDRESSOFSFDPDWORD(_tableAddress, dWordNumber);
-  _getSFDPData(_address, &(*SFDPdata.byteArray), sizeof(uint32_t));
-  return SFDPdata.dWord;
-}
-
-//startByte is the byte from which the 16-bit integer starts and can be between 1 to 256
-uint16_t SPIFlash::_getSFDPint(uint32_t _tableAddress, uint8_t dWordNumber, uint8_t startByte) {
-  if(!_notBusy()) {
-   return false;
-  }
-  union {
-    uint16_t word;
-    uint8_t byteArray[2];
-  } SFDPdata;
-  uint32_t _address = ADDRESSOFSFDPBYTE(_tableAddress, dWordNumber, startByte);
-  _getSFDPData(_address, &(*SFDPdata.byteArray), sizeof(uint16_t));
-  return SFDPdata.word;
-}
-
-//byteNumber can be between 1 to 256
-uint8_t SPIFlash::_getSFDPbyte(uint32_t _tableAddress, uint8_t dWordNumber, uint8_t byteNumber) {
-  if(!_notBusy()) {
-   return false;
-  }
-  uint8_t SFDPdataByte;
-  uint32_t _address = ADDRESSOFSFDPBYTE(_tableAddress, dWordNumber, byteNumber);
-  _getSFDPData(_address, &SFDPdataByte, sizeof(uint8_t));
-  return SFDPdataByte;
-}
-
-//bitNumber can be between 0 to 31
-bool SPIFlash::_getSFDPbit(uint32_t _tableAddress, uint8_t dWordNumber, uint8_t bitNumber) {
-  return(_getSFDPdword(_tableAddress, dWordNumber) & (0x01 << bitNumber));
-}
-
-uint32_t SPIFlash::_getSFDPTableAddr(uint32_t paramHeaderNum) {
-  uint32_t _tableAddr = _getSFDPdword(paramHeaderNum * 8, 0x02); // Each parameter header table is 8 bytes long
-  Highest(_tableAddr) = 0x00; // Top byte in the dWord containing the table address is always 0xFF.
-  return _tableAddr;
-}
-
-bool SPIFlash::_checkForSFDP(void) {
-  if (_getSFDPdword(SFDP_HEADER_ADDR, SFDP_SIGNATURE_DWORD) == SFDPSIGNATURE) {
-    _chip.sfdpAvailable = true;
-    #ifdef RUNDIAGNOSTIC
-    Serial.println(F("SFDP available"));
-    #endif
-  }
-  else {
-    _troubleshoot(NOSFDP);
-    _chip.sfdpAvailable = false;
-  }
-  return _chip.sfdpAvailable;
-}
 uint32_t SPIFlash::_calcSFDPEraseTimeUnits(uint8_t _unitBits) {
   switch (_unitBits) {
     case MS1:
@@ -142,171 +78,127 @@ uint32_t SPIFlash::_calcSFDPEraseTimeUnits(uint8_t _unitBits) {
   return false;
 }
 
-void SPIFlash::_getSFDPEraseParam(void) {
-  // Get sector erase details if available on SFDP Tables
-  if (_noOfBasicParamDwords >= SFDP_ERASE1_INSTRUCTION_DWORD) {
-    uint32_t _eraseInfoAddress;
-    uint8_t _eraseInfo[8];
-    uint8_t _eraseExists = 0;
-    uint8_t _count;
-    uint32_t _units;
-    union {
-      uint32_t dword;
-      uint8_t byte[4];
-    } _eraseTime;
-    _eraseInfoAddress = ADDRESSOFSFDPDWORD(_BasicParamTableAddr, SFDP_ERASE1_INSTRUCTION_DWORD);
-    _getSFDPData(_eraseInfoAddress, &(*_eraseInfo), 8);
-
-    for (uint8_t i = 0; i < 8; i++) {
-      _eraseExists += _eraseInfo[i];
-      if (!_eraseExists) { // If faulty SFDP read, then revert to defaults
-          kb4Erase.supported = kb32Erase.supported = kb64Erase.supported = chipErase.supported = true;
-          kb4Erase.opcode = SECTORERASE;
-          kb32Erase.opcode = BLOCK32ERASE;
-          kb64Erase.opcode = BLOCK64ERASE;
-          kb4Erase.time = BUSY_TIMEOUT;
-          kb32Erase.time = kb4Erase.time * 8;
-          kb64Erase.time = kb32Erase.time * 4;
-          kb256Erase.supported = false;
-          chipErase.opcode = CHIPERASE;
-          chipErase.time = kb64Erase.time * 100L;
-        _troubleshoot(NOSFDPERASEPARAM);
+// Works out which of the erase types 1 - 4 of the BFPT can be used anywhere in the chip, from the Sector Map Parameter
+// Table at _tableAddr, and returns them as bits 0 - 3. The library does not run the configuration detection commands of
+// the table, so a type is only kept if every region of every map supports it
+uint8_t SPIFlash::_getSFDPSectorMap(uint32_t _tableAddr, uint8_t noOfDwords) {
+  uint8_t _map[SFDP_SECTOR_MAP_MAX_DWORDS * 4];
+  uint8_t _eraseTypes = SFDP_ALL_ERASE_TYPES;
+  if (noOfDwords > SFDP_SECTOR_MAP_MAX_DWORDS) {
+    // The regions that are not read can't be checked - only the smallest erase type is sure to work everywhere
+    noOfDwords = SFDP_SECTOR_MAP_MAX_DWORDS;
+    _eraseTypes = 0x01;
+  }
+  if (!_getSFDPData(_tableAddr, _map, noOfDwords * 4)) {
+    return _eraseTypes;
+  }
+  uint16_t i = 1;
+  while (i <= noOfDwords) {
+    uint32_t _descriptor = _SFDPdword(_map, i);
+    if (_descriptor & SFDP_MAP_DESCRIPTOR) {
+      uint16_t _regions = ((_descriptor >> 16) & 0xFF) + 1;
+      for (uint16_t j = i + 1; j <= i + _regions && j <= noOfDwords; j++) {
+        _eraseTypes &= _SFDPdword(_map, j);
       }
+      i += _regions + 1;
     }
-    for (uint8_t i = 0; i < 8; i++) {
-      if ((i % 2) == 0) {
-        switch ((_eraseInfo[i])) {
-          case KB4ERASE_TYPE:
-          kb4Erase.supported = true;
-          kb4Erase.opcode = _eraseInfo[i+1];
-          break;
-
-          case KB32ERASE_TYPE:
-          kb32Erase.supported = true;
-          kb32Erase.opcode = _eraseInfo[i+1];
-          break;
-
-          case KB64ERASE_TYPE:
-          kb64Erase.supported = true;
-          kb64Erase.opcode = _eraseInfo[i+1];
-          break;
-
-          case KB256ERASE_TYPE:
-          kb256Erase.supported = true;
-          kb256Erase.opcode = _eraseInfo[i+1];
-          break;
-        }
-      }
+    else {
+      i += 2;   // Configuration detection command descriptors are two DWORDs long
     }
-    // Some flash memory chips have information about sector erase times in DWORD 10 of SFDP Basic param table.
-    if (_noOfBasicParamDwords >= SFDP_SECTOR_ERASE_TIME_DWORD) {
-      _eraseTime.dword = _getSFDPdword(_BasicParamTableAddr, SFDP_SECTOR_ERASE_TIME_DWORD);
-      _eraseTimeMultiplier = _eraseTime.byte[0];
-      setUpperNibble(_eraseTimeMultiplier, 0b0000);
-      _eraseTimeMultiplier = 2 * (_eraseTimeMultiplier + 1);  // Refer JESD216B Page 21
-
-      for (uint8_t i = 0; i < 8; i++) {
-        if ((i % 2) == 0) {
-          switch ((_eraseInfo[i])) {
-            case KB4ERASE_TYPE:
-            _count = ( ( ( (_eraseTime.byte[1] & _createMask(0, 0)) << 5) | ( (_eraseTime.byte[0] & _createMask(4, 7)) ) >> 4) + 1);
-            _units = _calcSFDPEraseTimeUnits((_eraseTime.byte[1] & _createMask(1, 2)) >> 1);
-            kb4Erase.time = (_count * _units * _eraseTimeMultiplier);
-            break;
-
-            case KB32ERASE_TYPE:
-            _count = (((_eraseTime.byte[1] & _createMask(3, 7)) >> 3) + 1);
-            _units = _calcSFDPEraseTimeUnits(_eraseTime.byte[2] & _createMask(0, 1));
-            kb32Erase.time = (_count * _units * _eraseTimeMultiplier);
-            break;
-
-            case KB64ERASE_TYPE:
-            _count = (((_eraseTime.byte[2] & _createMask(2, 6)) >> 2) + 1);
-            _units = _calcSFDPEraseTimeUnits(((_eraseTime.byte[2] & _createMask(7, 7)) >> 7) | (_eraseTime.byte[3] & _createMask(0,0)) << 1);
-            kb64Erase.time = (_count * _units * _eraseTimeMultiplier);
-            break;
-
-            case KB256ERASE_TYPE:
-            _count = (((_eraseTime.byte[3] & _createMask(1, 5)) >> 1) + 1);
-            _units = _calcSFDPEraseTimeUnits((_eraseTime.byte[3] & _createMask(6, 7)) >> 6);
-            kb64Erase.time = (_count * _units) * _eraseTimeMultiplier;
-            break;
-          }
-        }
-      }
+    if (_descriptor & SFDP_LAST_DESCRIPTOR) {
+      break;
+    }
+  }
+  return _eraseTypes & SFDP_ALL_ERASE_TYPES;
+}
 
-      // Some flash memory chips have information about chip erase times in DWORD 11 of SFDP Basic param table.
-      if (_noOfBasicParamDwords >= SFDP_CHIP_ERASE_TIME_DWORD) {
-        // Get chip erase details
-        _eraseInfoAddress = ADDRESSOFSFDPDWORD(_BasicParamTableAddr, DWORD(11));
-        _getSFDPData(_eraseInfoAddress, &(*_eraseInfo), 8);
-        chipErase.supported = true; // chipErase.opcode is set in _chipID().
-        _count = (((_eraseTime.byte[3] & _createMask(0, 4))) + 1);
-        _units = _calcSFDPEraseTimeUnits((_eraseTime.byte[3] & _createMask(5, 6)) >> 5);
-        chipErase.time = (_count * _units) * _eraseTimeMultiplier;
-      }
+// Takes the erase types (DWORDs 8 - 9) and their maximum times (DWORDs 10 - 11) from the BFPT in bfpt. Only the types set
+// in eraseTypes (bits 0 - 3, see _getSFDPSectorMap()) are used
+void SPIFlash::_getSFDPEraseParam(const uint8_t *bfpt, uint8_t eraseTypes) {
+  if (_noOfBasicParamDwords < SFDP_ERASE2_INSTRUCTION_DWORD) {
+    _troubleshoot(NOSFDPERASEPARAM);
+    return;     // The defaults set by _defaultChipParams() stay
+  }
+  uint32_t _eraseTime = 0;
+  if (_noOfBasicParamDwords >= SFDP_SECTOR_ERASE_TIME_DWORD) {
+    _eraseTime = _SFDPdword(bfpt, SFDP_SECTOR_ERASE_TIME_DWORD);
+    _eraseTimeMultiplier = 2 * ((_eraseTime & 0x0F) + 1);  // Refer JESD216B Page 21
+  }
+  else {
+    _troubleshoot(NOSFDPERASETIME);   // The erase times set by _defaultChipParams() stay
+  }
 
+  bool _eraseExists = false;
+  kb4Erase.supported = kb32Erase.supported = kb64Erase.supported = kb256Erase.supported = false;
+  for (uint8_t i = 0; i < 4; i++) {
+    const uint8_t *_eraseInfo = &bfpt[((SFDP_ERASE1_INSTRUCTION_DWORD - 1) * 4) + (i * 2)];   // Size (2^N bytes), opcode
+    eraseParam *_erase;
+    switch (_eraseInfo[0]) {
+      case KB4ERASE_TYPE:
+      _erase = &kb4Erase;
+      break;
+
+      case KB32ERASE_TYPE:
+      _erase = &kb32Erase;
+      break;
+
+      case KB64ERASE_TYPE:
+      _erase = &kb64Erase;
+      break;
+
+      case KB256ERASE_TYPE:
+      _erase = &kb256Erase;
+      break;
+
+      default:
+      continue;
     }
-    else { //If flash memory does not have any sfdp information about sector erase times
-      _troubleshoot(NOSFDPERASETIME);
-      kb4Erase.time = BUSY_TIMEOUT;
-      kb32Erase.time = kb4Erase.time * 8;
-      kb64Erase.time = kb32Erase.time * 4;
-      kb256Erase.supported = false;
-      chipErase.opcode = CHIPERASE;
-      chipErase.time = kb64Erase.time * 100L;
+    if (!(eraseTypes & (0x01 << i))) {
+      continue;
+    }
+    _erase->supported = true;
+    _erase->opcode = _eraseInfo[1];
+    _eraseExists = true;
+    if (_eraseTime) {
+      // Erase type n has a 5-bit count at bit 4 + 7 * (n - 1) and 2 bits of units above it
+      uint8_t _shift = 4 + (7 * i);
+      uint32_t _count = ((_eraseTime >> _shift) & 0x1F) + 1;
+      _erase->time = _count * _calcSFDPEraseTimeUnits((_eraseTime >> (_shift + 5)) & 0x03) * _eraseTimeMultiplier;
     }
-
   }
-  else {
+  if (!_eraseExists) { // If faulty SFDP read, then revert to defaults
+    kb4Erase.supported = kb32Erase.supported = kb64Erase.supported = true;
     _troubleshoot(NOSFDPERASEPARAM);
   }
+
+  // Chip erase time is in DWORD 11, with units of 16 ms, 256 ms, 4 s or 64 s
+  if (_eraseTime && _noOfBasicParamDwords >= SFDP_CHIP_ERASE_TIME_DWORD) {
+    const uint32_t _units[4] = {16L*1000L, 256L*1000L, 4000L*1000L, 64000L*1000L};
+    uint32_t _sfdp = _SFDPdword(bfpt, SFDP_CHIP_ERASE_TIME_DWORD);
+    chipErase.supported = true; // chipErase.opcode is set in _chipID().
+    chipErase.time = (((_sfdp >> 24) & 0x1F) + 1) * _units[(_sfdp >> 29) & 0x03] * _eraseTimeMultiplier;
+  }
 }
 
-// Gets IO timing information from SFDP tables - if available.
-void SPIFlash::_getSFDPProgramTimeParam(void) {
+// Gets the page size and the page and byte program times from DWORD 11 of the BFPT in bfpt - if available.
+void SPIFlash::_getSFDPProgramTimeParam(const uint8_t *bfpt) {
   if (_noOfBasicParamDwords >= SFDP_PROGRAM_TIME_DWORD) {
-    union {
-      uint32_t dword;
-      uint8_t byte[4];
-    } _sfdp;
-    uint8_t _count;
-    uint32_t _units;
-
-    _sfdp.dword= _getSFDPdword(_BasicParamTableAddr, SFDP_PROGRAM_TIME_DWORD);
+    uint32_t _sfdp = _SFDPdword(bfpt, SFDP_PROGRAM_TIME_DWORD);
 
     //Calculate Program time multiplier
-    _prgmTimeMultiplier = (2 * ((_sfdp.byte[1] >> 4) + 1));
-    //Serial.print("_prgmTimeMultiplier: ");
-    //Serial.println(_prgmTimeMultiplier);
-
-    // Get pageSize
-    //setUpperNibble(_eraseTimeMultiplier, 0b0000);
-    _pageSize = setUpperNibble(_sfdp.byte[1], 0b0000);
-    _pageSize *= 2;
-    //Serial.print("_pageSize: ");
-    //Serial.println(_pageSize);
-
-    //Calculate Page Program time
-    _count = (((_sfdp.byte[1] & _createMask(0, 4))) + 1);
-    ((_sfdp.byte[1] & _createMask(7, 7)) >> 7) ? (_units = 64) : (_units = 8);
-    _pagePrgmTime = (_count * _units) * _prgmTimeMultiplier;
-    //Serial.print("_pagePrgmTime: ");
-    //Serial.println(_pagePrgmTime);
-
-    //Calculate First Byte Program time
-    _count = ( (((_sfdp.byte[1] & _createMask(6, 7)) >> 4) | (((_sfdp.byte[2] & _createMask(6, 7))) >> 6)) + 1);
-    ((_sfdp.byte[2] & _createMask(5, 5)) >> 5) ? (_units = 8) : (_units = 1);
-    _byteFirstPrgmTime = (_count * _units) * _prgmTimeMultiplier;
-    //Serial.print("_byteFirstPrgmTime :");
-    //Serial.println(_byteFirstPrgmTime);
-
-    //Calculate Additional Byte Program time
-    _count = ( ((_sfdp.byte[2] & _createMask(4, 1)) >> 1) + 1);
-    (_sfdp.byte[2] & _createMask(0, 0)) ? (_units = 8) : (_units = 1);
-    _byteAddnlPrgmTime = (_count * _units) * _prgmTimeMultiplier;
-    //Serial.print("_byteAddnlPrgmTime :");
-    //Serial.println(_byteAddnlPrgmTime);
+    _prgmTimeMultiplier = 2 * ((_sfdp & 0x0F) + 1);
+
+    // Get pageSize (2^N bytes)
+    _pageSize = 0x01 << ((_sfdp >> 4) & 0x0F);
+
+    //Calculate Page Program time - count in bits 12:8, units of 8 or 64 us
+    _pagePrgmTime = (((_sfdp >> 8) & 0x1F) + 1) * ((_sfdp & (0x01UL << 13)) ? 64 : 8) * _prgmTimeMultiplier;
+
+    //Calculate First Byte Program time - count in bits 17:14, units of 1 or 8 us
+    _byteFirstPrgmTime = (((_sfdp >> 14) & 0x0F) + 1) * ((_sfdp & (0x01UL << 18)) ? 8 : 1) * _prgmTimeMultiplier;
+
+    //Calculate Additional Byte Program time - count in bits 22:19, units of 1 or 8 us
+    _byteAddnlPrgmTime = (((_sfdp >> 19) & 0x0F) + 1) * ((_sfdp & (0x01UL << 23)) ? 8 : 1) * _prgmTimeMultiplier;
   }
   else {
     _pageSize = SPI_PAGESIZE;
@@ -317,35 +209,111 @@ void SPIFlash::_getSFDPProgramTimeParam(void) {
   }
 }
 
-// Reads and stores any required values from the Basic Flash Parameter table
+// Finds which of the multi-line reads of setIOMode() the chip has, with the opcode and wait clocks the library uses
+// (DWORDs 1, 3 and 4), and whether its Quad Enable bit is set the way _enableQuad() does it (DWORD 15)
+void SPIFlash::_getSFDPIOModes(const uint8_t *bfpt) {
+  _sfdpIOModes = 0;
+  if (_noOfBasicParamDwords < SFDP_FASTREAD_DUAL_DWORD) {
+    return;
+  }
+  uint32_t _modes = _SFDPdword(bfpt, SFDP_FASTREAD_MODES_DWORD);
+  uint32_t _quad = _SFDPdword(bfpt, SFDP_FASTREAD_QUAD_DWORD);
+  uint32_t _dual = _SFDPdword(bfpt, SFDP_FASTREAD_DUAL_DWORD);
+  if ((_modes & SFDP_SUPPORTS_112) && _SFDPreadMatches(_dual & 0xFFFF, FASTREAD_DUAL, 8)) {
+    _sfdpIOModes |= SFDP_IO_DUAL;
+  }
+  if ((_modes & SFDP_SUPPORTS_114) && _SFDPreadMatches(_quad >> 16, FASTREAD_QUAD, 8)) {
+    _sfdpIOModes |= SFDP_IO_QUAD;
+  }
+  if ((_modes & SFDP_SUPPORTS_144) && _SFDPreadMatches(_quad & 0xFFFF, FASTREAD_QUADIO, 6)) {
+    _sfdpIOModes |= SFDP_IO_QUADIO;
+  }
+  if (_noOfBasicParamDwords >= SFDP_QE_DWORD && ((_SFDPdword(bfpt, SFDP_QE_DWORD) >> 20) & 0x07) == SFDP_QE_SR2_WRITESTAT2) {
+    _sfdpIOModes |= SFDP_IO_QE;
+  }
+}
+
+// Reads the SFDP header and parameter headers, the Basic Flash Parameter Table (BFPT) and - if there is one - the Sector
+// Map Parameter Table, each in a single burst, and takes the capacity, erase types and times, program times and fast
+// read modes of the chip from them. Returns false if the chip has no SFDP
 bool SPIFlash::_getSFDPFlashParam(void) {
-    _noOfParamHeaders = _getSFDPbyte(SFDP_HEADER_ADDR, SFDP_NPH_DWORD, SFDP_NPH_BYTE) + 1; // Number of parameter headers is 0 based - i.e. 0x00 means there is 1 header.
-    if (_noOfParamHeaders > 1) {
-      _SectorMapParamTableAddr = _getSFDPTableAddr(SFDP_SECTOR_MAP_PARAM_TABLE_NO);
+  uint8_t _header[SFDP_HEADER_LENGTH * (SFDP_MAX_PARAM_HEADERS + 1)];
+  if (!_getSFDPData(SFDP_HEADER_ADDR, _header, sizeof(_header)) || _SFDPdword(_header, SFDP_SIGNATURE_DWORD) != SFDPSIGNATURE) {
+    _troubleshoot(NOSFDP);
+    _chip.sfdpAvailable = false;
+    return false;
+  }
+
+  // Find the tables. A later BFPT header is a newer revision of the table, and is used if it is at least as long
+  uint8_t _noOfParamHeaders = _header[SFDP_NPH_OFFSET] + 1; // Number of parameter headers is 0 based - i.e. 0x00 means there is 1 header.
+  if (_noOfParamHeaders > SFDP_MAX_PARAM_HEADERS) {
+    _noOfParamHeaders = SFDP_MAX_PARAM_HEADERS;
+  }
+  uint32_t _BasicParamTableAddr = 0, _SectorMapParamTableAddr = 0;
+  uint8_t _noOfSectorMapDwords = 0;
+  _noOfBasicParamDwords = 0;
+  for (uint8_t i = 1; i <= _noOfParamHeaders; i++) {
+    const uint8_t *_paramHeader = &_header[i * SFDP_HEADER_LENGTH];
+    uint16_t _id = ((uint16_t)_paramHeader[SFDP_PARAM_ID_MSB_OFFSET] << 8) | _paramHeader[SFDP_PARAM_ID_LSB_OFFSET];
+    uint8_t _length = _paramHeader[SFDP_PARAM_LENGTH_OFFSET];
+    uint32_t _tableAddr = (uint32_t)_paramHeader[SFDP_PARAM_POINTER_OFFSET] | ((uint32_t)_paramHeader[SFDP_PARAM_POINTER_OFFSET + 1] << 8) |
+                          ((uint32_t)_paramHeader[SFDP_PARAM_POINTER_OFFSET + 2] << 16);
+    if (_id == SFDP_BASIC_PARAM_TABLE_ID && _length >= _noOfBasicParamDwords) {
+      _BasicParamTableAddr = _tableAddr;
+      _noOfBasicParamDwords = _length;
+    }
+    else if (_id == SFDP_SECTOR_MAP_PARAM_TABLE_ID) {
+      _SectorMapParamTableAddr = _tableAddr;
+      _noOfSectorMapDwords = _length;
     }
-    _noOfBasicParamDwords = _getSFDPbyte(SFDP_BASIC_PARAM_TABLE_HDR_ADDR, SFDP_PARAM_TABLE_LENGTH_DWORD, SFDP_PARAM_TABLE_LENGTH_BYTE);
-    _BasicParamTableAddr = _getSFDPTableAddr(SFDP_BASIC_PARAM_TABLE_NO);
+  }
+  if (_noOfBasicParamDwords < SFDP_MEMORY_DENSITY_DWORD) {
+    _troubleshoot(NOSFDP);
+    _chip.sfdpAvailable = false;
+    return false;
+  }
 
-    // Calculate chip capacity
+  // Before the BFPT is read, so that both tables are not on the stack at once
+  uint8_t _eraseTypes = SFDP_ALL_ERASE_TYPES;
+  if (_noOfSectorMapDwords) {
+    _eraseTypes = _getSFDPSectorMap(_SectorMapParamTableAddr, _noOfSectorMapDwords);
+  }
 
-    _chip.capacity = _getSFDPdword(_BasicParamTableAddr, SFDP_MEMORY_DENSITY_DWORD);
-    if (bitIsSet(Highest(_chip.capacity), 7)) {     // If bit 31 (bit 7 of byte 3) is set, then the density is double the value read in bits from 30:0 (Refer to Page 16 of JESD216B)
-      clearBit(Highest(_chip.capacity), 7); // Clear bit 31
-      _chip.capacity*=2;
-    }
-    // Else _chip.capacity is the value as read in bits.
+  uint8_t _bfpt[SFDP_BASIC_PARAM_TABLE_MAX_DWORDS * 4];
+  if (_noOfBasicParamDwords > SFDP_BASIC_PARAM_TABLE_MAX_DWORDS) {
+    _noOfBasicParamDwords = SFDP_BASIC_PARAM_TABLE_MAX_DWORDS;   // The library does not use the later DWORDs
+  }
+  if (!_getSFDPData(_BasicParamTableAddr, _bfpt, _noOfBasicParamDwords * 4)) {
+    _troubleshoot(NOSFDP);
+    _chip.sfdpAvailable = false;
+    _defaultChipParams();      // Nothing of the tables is used - the chip is identified as one without SFDP
+    return false;
+  }
+  _chip.sfdpAvailable = true;
+  #ifdef RUNDIAGNOSTIC
+    Serial.println(F("SFDP available"));
+  #endif
 
-    _chip.capacity = (_chip.capacity/8) + 1; // Since the value read in is in bits, convert it to bytes here (1 is added because the number of bits is zero based - i.e. if there are 8 bytes, then they are numbered 0 -> 7)
+  // Calculate chip capacity
+  uint32_t _density = _SFDPdword(_bfpt, SFDP_MEMORY_DENSITY_DWORD);
+  if (_density & 0x80000000) {     // If bit 31 is set, then the density is 2^N bits, N being bits 30:0 (Refer to Page 16 of JESD216B)
+    _density &= 0x7FFFFFFF;
+    _chip.capacity = (_density >= 3 && _density < 35) ? (0x01UL << (_density - 3)) : 0;
+  }
+  else {
+    // Else it is the value in bits, zero based - i.e. if there are 8 bytes, then the bits are numbered 0 -> 63
+    _chip.capacity = (_density >> 3) + 1;
+  }
 
   // Get Erase Parameters if available
-  _getSFDPEraseParam();
+  _getSFDPEraseParam(_bfpt, _eraseTypes);
 
   //Get Program time Parameters
-  _getSFDPProgramTimeParam();
-// TODO Update the use of Program time parameters across the library
+  _getSFDPProgramTimeParam(_bfpt);
+
+  //Get the multi-line read modes
+  _getSFDPIOModes(_bfpt);
 
-  //Serial.print("dWord 9: 0x");
-  //Serial.println(_getSFDPdword(_BasicParamTableAddr, DWORD(9)), HEX);
   #ifdef RUNDIAGNOSTIC
     Serial.println("Chip identified using sfdp. Most of this chip's functions are supported by the library.");
   #endif
@@ -0,0 +1,87 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPIFLASHT_H
+#define SPIFLASHT_H
+
+#include "SPIFlash.h"
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                          Chip descriptors                          //
+//     Everything SPIFlashT<> needs to know about a chip, at build    //
+//   time. To add a chip, copy one and change the IDs and geometry    //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+struct W25Q32JV {
+  static constexpr uint8_t  manufacturerID = WINBOND_MANID;
+  static constexpr uint8_t  memoryTypeID   = 0x40;
+  static constexpr uint8_t  capacityID     = 0x16;
+  static constexpr uint32_t capacity       = MB(4);
+  static constexpr uint16_t pageSize       = SPI_PAGESIZE;
+  static constexpr uint8_t  addressBytes   = 3;
+  // Worst case busy times from the datasheet (us) - tPP, tSE, tBE1, tBE2 and tCE
+  static constexpr uint32_t maxPageProgram = 3000;
+  static constexpr uint32_t maxErase4K     = 400000L;
+  static constexpr uint32_t maxErase32K    = 1600000L;
+  static constexpr uint32_t maxErase64K    = 2000000L;
+  static constexpr uint32_t maxChipErase   = 50000000L;
+};
+
+// An SPIFlash for one known chip. begin() checks the chip against its JEDEC ID rather than looking it up in the ID
+// tables and reading its SFDP tables, and takes its worst case busy times from the descriptor - so every wait, whichever
+// SPIFlash function or SPIFlashVolume it comes from, gives up after the chip's own time for the operation rather than
+// BUSY_TIMEOUT, and planErase() has the chip's worst case times. Everything else is SPIFlash -
+//    SPIFlashT<W25Q32JV> flash(cs);
+template <class Chip> class SPIFlashT : public SPIFlash {
+  static_assert(Chip::addressBytes == 3 && Chip::capacity <= MB(16), "SPIFlashT only drives chips with 3-byte addresses");
+  static_assert(Chip::pageSize == SPI_PAGESIZE, "SPIFlashT only drives chips with SPI_PAGESIZE pages");
+
+public:
+  using SPIFlash::SPIFlash;
+
+  bool     begin(void);
+};
+
+// Starts the bus and checks that the chip is the one described by Chip. Fails with UNKNOWNCHIP if it is not
+template <class Chip> bool SPIFlashT<Chip>::begin(void) {
+  _beginBus();
+  _defaultChipParams();
+  bool _retVal = _getJedecId();
+  _endSPI();
+  if (!_retVal) {
+    return false;
+  }
+  if (!_useChip(Chip::manufacturerID, Chip::memoryTypeID, Chip::capacityID, Chip::capacity)) {
+    return false;
+  }
+  _pagePrgmTime = Chip::maxPageProgram;
+  kb4Erase.time = Chip::maxErase4K;
+  kb32Erase.time = Chip::maxErase32K;
+  kb64Erase.time = Chip::maxErase64K;
+  chipErase.time = Chip::maxChipErase;
+  chipPoweredDown = false;
+  _disableGlobalBlockProtect();
+  return true;
+}
+
+#endif // SPIFLASHT_H
@@ -0,0 +1,465 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "SPIMemory.h"
+
+// Takes two arguments -
+//  1. chips --> The chips, in the order their pages are striped in. Only the pointers are copied
+//  2. count --> Number of chips, up to SPIMEMORY_VOLUME_MAX_CHIPS
+SPIFlashVolume::SPIFlashVolume(SPIFlash **chips, uint8_t count) {
+  _count = (count <= SPIMEMORY_VOLUME_MAX_CHIPS) ? count : 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    _chips[i] = chips[i];
+  }
+}
+
+// Checks that every chip has been identified by its own begin(), and that they are all the same size
+bool SPIFlashVolume::begin(void) {
+  _chipCapacity = 0;
+  if (!_count) {
+    diagnostics.troubleshoot(UNSUPPORTEDFUNC);
+    return false;
+  }
+  for (uint8_t i = 0; i < _count; i++) {
+    if (!_chips[i]->getCapacity()) {
+      diagnostics.troubleshoot(CALLBEGIN);
+      return false;
+    }
+    if (_chips[i]->getCapacity() != _chips[0]->getCapacity()) {
+      diagnostics.troubleshoot(UNSUPPORTEDFUNC);
+      return false;
+    }
+  }
+  _chipCapacity = _chips[0]->getCapacity();
+  return true;
+}
+
+// Error codes are kept for all the chips together (see SPIFlash::error())
+uint8_t SPIFlashVolume::error(bool verbosity) {
+  return _count ? _chips[0]->error(verbosity) : diagnostics.errorcode;
+}
+
+uint32_t SPIFlashVolume::getCapacity(void) {
+  return _chipCapacity * _count;
+}
+
+uint32_t SPIFlashVolume::getMaxPage(void) {
+  return getCapacity() / SPI_PAGESIZE;
+}
+
+// Size of the smallest range that can be erased - a 4 KB sector on every chip
+uint32_t SPIFlashVolume::getSectorSize(void) {
+  return KB(4) * _count;
+}
+
+uint8_t SPIFlashVolume::getChipCount(void) {
+  return _count;
+}
+
+SPIFlash *SPIFlashVolume::getChip(uint8_t index) {
+  return (index < _count) ? _chips[index] : NULL;
+}
+
+// Sets the runtime policy (see SPIFlash::setPolicy) of every chip
+void SPIFlashVolume::setPolicy(uint8_t policy) {
+  for (uint8_t i = 0; i < _count; i++) {
+    _chips[i]->setPolicy(policy);
+  }
+}
+
+uint8_t SPIFlashVolume::getPolicy(void) {
+  return _count ? _chips[0]->getPolicy() : 0;
+}
+
+// Writes an array of bytes. Takes four arguments -
+//  1. _addr --> Any address from 0 to getCapacity()
+//  2. data_buffer --> The bytes to be written
+//  3. bufferSize --> Size of the array - in number of bytes
+//  4. errorCheck --> Turned on by default. Reads the pages back once they have all been programmed, as the verify policy
+//                    of their chip says (see SPIFlash::setVerifyPolicy())
+bool SPIFlashVolume::writeByteArray(uint32_t _addr, const uint8_t *data_buffer, size_t bufferSize, bool errorCheck) {
+  SPIFlash::iovec _vec = {(void*) data_buffer, bufferSize};
+  return writev(_addr, &_vec, 1, errorCheck);
+}
+
+// Reads an array of bytes. Every chip reads its pages of the range into the places they go in data_buffer, with one
+// read command per SPIMEMORY_VOLUME_VEC pages (see SPIFlash::readv()).
+//  Takes four arguments -
+//    1. _addr --> Any address from 0 to getCapacity()
+//    2. data_buffer --> The array of bytes to be read into
+//    3. bufferSize --> The size of the buffer - in number of bytes
+//    4. fastRead --> defaults to false - executes _beginFastRead() if set to true
+bool SPIFlashVolume::readByteArray(uint32_t _addr, uint8_t *data_buffer, size_t bufferSize, bool fastRead) {
+  if (!data_buffer || !bufferSize || !_inRange(_addr, bufferSize)) {
+    return false;
+  }
+  if (_count == 1) {
+    return _chips[0]->readByteArray(_addr, data_buffer, bufferSize, fastRead);
+  }
+  return _readChips(_addr, data_buffer, bufferSize, fastRead, true);
+}
+
+// Reads a range that is inside the volume from every chip that holds part of it, as readByteArray() does. If cached is
+// false, the chips read their share straight from the array, without going through their read cache
+bool SPIFlashVolume::_readChips(uint32_t _addr, uint8_t *data_buffer, uint32_t size, bool fastRead, bool cached) {
+  uint32_t _end = _addr + size;
+  for (uint8_t c = 0; c < _count; c++) {
+    SPIFlash::iovec _vec[SPIMEMORY_VOLUME_VEC];
+    uint8_t _n = 0;
+    uint32_t _chipAddr = 0;
+    uint32_t _page = _addr / SPI_PAGESIZE;
+    _page += (c + _count - (_page % _count)) % _count;     // First page of the range on chip c
+    for (; _page * SPI_PAGESIZE < _end; _page += _count) {
+      uint32_t _from = (_page * SPI_PAGESIZE > _addr) ? _page * SPI_PAGESIZE : _addr;
+      uint32_t _to = ((_page + 1) * SPI_PAGESIZE < _end) ? (_page + 1) * SPI_PAGESIZE : _end;
+      if (!_n) {
+        _chipAddr = _chipAddress(_from);
+      }
+      _vec[_n].iov_base = data_buffer + (_from - _addr);
+      _vec[_n].iov_len = _to - _from;
+      if (++_n == SPIMEMORY_VOLUME_VEC) {
+        if (!_chips[c]->_readv(_chipAddr, _vec, _n, fastRead, cached)) {
+          return false;
+        }
+        _n = 0;
+      }
+    }
+    if (_n && !_chips[c]->_readv(_chipAddr, _vec, _n, fastRead, cached)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes several buffers one after the other, as one range (see SPIFlash::writev()). Every page is started with
+// SPIFlash::programPageAsync() on its chip, which only waits if that chip is still programming the page before - by
+// then the other chips have been sent theirs.
+//  Takes four arguments -
+//    1. _addr --> Any address from 0 to getCapacity()
+//    2. vec --> The buffers, in the order they are written. Empty ones are skipped
+//    3. count --> Number of buffers in vec
+//    4. errorCheck --> Turned on by default. Reads the pages back once they have all been programmed, as the verify
+//                      policy of their chip says (see SPIFlash::setVerifyPolicy())
+bool SPIFlashVolume::writev(uint32_t _addr, const SPIFlash::iovec *vec, uint8_t count, bool errorCheck) {
+  uint32_t _sz = SPIFlash::_vecSize(vec, count);
+  if (!_sz || !_inRange(_addr, _sz)) {
+    return false;
+  }
+  if (_count == 1) {
+    return _chips[0]->writev(_addr, vec, count, errorCheck);
+  }
+  return _program(_addr, vec, count, _sz) && (!errorCheck || _verify(_addr, vec, count, _sz));
+}
+
+// Reads a range in chunks of chunkSize bytes and hands each one to callback, as SPIFlash::readStream() does. One chip
+// reads the whole range with a single read command. Striped over several, every chip reads its pages of each chunk
+// with one read command - a chip can only keep a read open while it is the one selected. Neither goes through the read
+// caches, which a long range would only flush
+bool SPIFlashVolume::readStream(uint32_t _addr, uint32_t size, uint8_t *chunk_buffer, uint32_t chunkSize, SPIFlash::streamCallback callback, void *context, bool fastRead) {
+  if (!chunk_buffer || !chunkSize || !callback) {
+    diagnostics.troubleshoot(UNKNOWNERROR);
+    return false;
+  }
+  if (!_inRange(_addr, size)) {
+    return false;
+  }
+  if (_count == 1) {
+    return _chips[0]->readStream(_addr, size, chunk_buffer, chunkSize, callback, context, fastRead);
+  }
+  while (size) {
+    uint32_t _len = (size < chunkSize) ? size : chunkSize;
+    if (!_readChips(_addr, chunk_buffer, _len, fastRead, false) || !callback(_addr, chunk_buffer, _len, context)) {
+      return false;
+    }
+    _addr += _len;
+    size -= _len;
+  }
+  return true;
+}
+
+// Writes length characters in the layout of SPIFlash::writeStr() - size with the terminator as a 32-bit number, the
+// characters and the terminator
+bool SPIFlashVolume::writeStr(uint32_t _addr, const char *data, uint32_t length, bool errorCheck) {
+  uint32_t _sz = length + 1;
+  uint8_t _header[sizeof(_sz)];
+  for (uint8_t i = 0; i < sizeof(_sz); i++) {
+    _header[i] = _sz >> (8*i);
+  }
+  char _terminator = '\0';
+  SPIFlash::iovec _vec[3] = {{_header, sizeof(_header)}, {(void*) data, length}, {&_terminator, sizeof(_terminator)}};
+  return writev(_addr, _vec, 3, errorCheck);
+}
+
+// Reads a string written by writeStr() into a String, SPIMEMORY_STR_CHUNK bytes at a time
+bool SPIFlashVolume::readStr(uint32_t _addr, String &data, bool fastRead) {
+  uint32_t _sz;
+  if (!_readStrSize(_addr, _sz, fastRead)) {
+    return false;
+  }
+  data = "";
+  if (!data.reserve(_sz)) {
+    diagnostics.troubleshoot(LOWRAM);
+    return false;
+  }
+  char _chunk[SPIMEMORY_STR_CHUNK + 1];
+  _addr += sizeof(_sz);
+  for (uint32_t _offset = 0; _offset < _sz;) {
+    uint32_t _len = (_sz - _offset < SPIMEMORY_STR_CHUNK) ? (_sz - _offset) : SPIMEMORY_STR_CHUNK;
+    if (!readByteArray(_addr + _offset, (uint8_t*) _chunk, _len, fastRead)) {
+      return false;
+    }
+    _chunk[_len] = '\0';
+    data += _chunk;
+    if (strlen(_chunk) < _len) {     // Up to the terminator
+      break;
+    }
+    _offset += _len;
+  }
+  return true;
+}
+
+// Reads a string written by writeStr() into a buffer, as SPIFlash::readStr() does - length is set to the length of the
+// string also when it does not fit
+bool SPIFlashVolume::readStr(uint32_t _addr, char *data_buffer, uint32_t bufferSize, uint32_t *length, bool fastRead) {
+  uint32_t _sz;
+  bool _found = _readStrSize(_addr, _sz, fastRead);
+  if (length) {
+    *length = _found ? _sz - 1 : 0;
+  }
+  if (!_found) {
+    return false;
+  }
+  if (!data_buffer || _sz > bufferSize) {
+    diagnostics.troubleshoot(OUTOFBOUNDS);
+    return false;
+  }
+  if (!readByteArray(_addr + sizeof(_sz), (uint8_t*) data_buffer, _sz, fastRead)) {
+    return false;
+  }
+  data_buffer[_sz - 1] = '\0';
+  return true;
+}
+
+// Waits for the last page sent to every chip to be programmed
+bool SPIFlashVolume::awaitProgram(uint32_t timeout) {
+  bool _retVal = true;
+  for (uint8_t i = 0; i < _count; i++) {
+    _retVal &= _chips[i]->awaitProgram(timeout);
+  }
+  return _retVal;
+}
+
+// Works out how eraseSection() would erase a range - rounded out to whole volume sectors, each of which is the same
+// sector on every chip. The erases are added up over the chips; the estimate and maxTime are one chip's, as they run
+// side by side
+bool SPIFlashVolume::planErase(uint32_t _addr, uint32_t _sz, SPIFlash::erasePlan &plan) {
+  uint32_t _first, _sectors;
+  if (!this->_sectors(_addr, _sz, _first, _sectors) || !_chips[0]->planErase(_first * KB(4), _sectors * KB(4), plan)) {
+    return false;
+  }
+  plan.addr = _first * getSectorSize();
+  plan.size *= _count;
+  plan.sectors *= _count;
+  plan.blocks32K *= _count;
+  plan.blocks64K *= _count;
+  return true;
+}
+
+// Erases the volume sector that holds _addr - the same 4 KB sector on every chip, at the same time
+bool SPIFlashVolume::eraseSector(uint32_t _addr) {
+  return eraseSectorAsync(_addr) && awaitErase();
+}
+
+// Starts erasing the volume sector that holds _addr on every chip and returns without waiting (see
+// SPIFlash::eraseSectorAsync())
+bool SPIFlashVolume::eraseSectorAsync(uint32_t _addr) {
+  if (!_inRange(_addr, 1)) {
+    return false;
+  }
+  bool _retVal = true;
+  for (uint8_t i = 0; i < _count; i++) {
+    _retVal &= _chips[i]->eraseSectorAsync((_addr / getSectorSize()) * KB(4));
+  }
+  return _retVal;
+}
+
+// Erases every volume sector the range touches
+bool SPIFlashVolume::eraseSection(uint32_t _addr, uint32_t _sz) {
+  return eraseSectionAsync(_addr, _sz) && awaitErase();
+}
+
+// Starts erasing every volume sector the range touches - the same run of sectors on every chip, each chip with the
+// fewest erases that cover it (see SPIFlash::eraseSectionAsync()). eraseBusy() moves all of them on
+bool SPIFlashVolume::eraseSectionAsync(uint32_t _addr, uint32_t _sz) {
+  uint32_t _first, _sectors;
+  if (!this->_sectors(_addr, _sz, _first, _sectors)) {
+    return false;
+  }
+  bool _retVal = true;
+  for (uint8_t i = 0; i < _count; i++) {
+    _retVal &= _chips[i]->eraseSectionAsync(_first * KB(4), _sectors * KB(4));
+  }
+  return _retVal;
+}
+
+// Erases every chip with its chip erase, side by side
+bool SPIFlashVolume::eraseChip(void) {
+  if (!_chipCapacity) {
+    diagnostics.troubleshoot(CALLBEGIN);
+    return false;
+  }
+  bool _retVal = true;
+  for (uint8_t i = 0; i < _count; i++) {
+    _retVal &= _chips[i]->eraseChipAsync();
+  }
+  return awaitErase() && _retVal;
+}
+
+// Returns true while any chip is still erasing. Polls every one of them, so that each moves on to the next erase of
+// its section as soon as it is done with the last
+bool SPIFlashVolume::eraseBusy(void) {
+  bool _busy = false;
+  for (uint8_t i = 0; i < _count; i++) {
+    _busy |= _chips[i]->eraseBusy();
+  }
+  return _busy;
+}
+
+// Waits for every chip to finish its erases. Returns false if they take longer than timeout (in microseconds) all
+// together, or one of them could not be started. Each chip is left whatever is left of timeout
+bool SPIFlashVolume::awaitErase(uint32_t timeout) {
+  uint32_t _start = micros();
+  while (eraseBusy() && micros() - _start < timeout) {
+    delay(1);
+  }
+  bool _retVal = true;
+  for (uint8_t i = 0; i < _count; i++) {
+    uint32_t _elapsed = micros() - _start;
+    _retVal &= _chips[i]->awaitErase((_elapsed < timeout) ? (timeout - _elapsed) : 0);
+  }
+  return _retVal;
+}
+
+// Checks that size bytes from _addr are inside the volume, and that begin() has been called
+bool SPIFlashVolume::_inRange(uint32_t _addr, uint32_t size) {
+  if (!_chipCapacity) {
+    diagnostics.troubleshoot(CALLBEGIN);
+    return false;
+  }
+  if (size > getCapacity() || _addr > getCapacity() - size) {
+    diagnostics.troubleshoot(OUTOFBOUNDS);
+    return false;
+  }
+  return true;
+}
+
+// Sets first and count to the volume sectors a range touches
+bool SPIFlashVolume::_sectors(uint32_t _addr, uint32_t _sz, uint32_t &first, uint32_t &count) {
+  if (!_sz || !_inRange(_addr, _sz)) {
+    return false;
+  }
+  first = _addr / getSectorSize();
+  count = (_addr + _sz - 1) / getSectorSize() - first + 1;
+  return true;
+}
+
+// Address on its chip of a volume address
+uint32_t SPIFlashVolume::_chipAddress(uint32_t _addr) {
+  return (_addr / SPI_PAGESIZE / _count) * SPI_PAGESIZE + (_addr % SPI_PAGESIZE);
+}
+
+SPIFlash *SPIFlashVolume::_chipOf(uint32_t _addr) {
+  return _chips[(_addr / SPI_PAGESIZE) % _count];
+}
+
+// Sends the range page by page, each to its chip. A page that comes from one buffer is programmed straight from it; a
+// page that spans buffers is gathered into a page buffer first
+bool SPIFlashVolume::_program(uint32_t _addr, const SPIFlash::iovec *vec, uint8_t count, uint32_t size) {
+  uint8_t _page[SPI_PAGESIZE];
+  uint8_t _index = 0;       // Buffer the next byte comes from, and its offset in it
+  uint32_t _offset = 0;
+
+  while (size) {
+    uint32_t _len = SPI_PAGESIZE - (_addr % SPI_PAGESIZE);
+    if (_len > size) {
+      _len = size;
+    }
+    const uint8_t *_data = SPIFlash::_gatherVec(vec, count, _index, _offset, _len, _page);
+    if (!_data) {
+      diagnostics.troubleshoot(UNKNOWNERROR);
+      return false;
+    }
+    if (!_chipOf(_addr)->programPageAsync(_chipAddress(_addr), _data, _len)) {
+      return false;
+    }
+    _addr += _len;
+    size -= _len;
+  }
+  return true;
+}
+
+// Reads back the pages of the range that the verify policy of their chip picks - straight from the chip, not its read
+// cache - and compares them with the buffers they were written from
+bool SPIFlashVolume::_verify(uint32_t _addr, const SPIFlash::iovec *vec, uint8_t count, uint32_t size) {
+  uint8_t _page[SPI_PAGESIZE];
+  uint8_t _index = 0;
+  uint32_t _offset = 0;
+
+  while (size) {
+    uint32_t _len = SPI_PAGESIZE - (_addr % SPI_PAGESIZE);
+    if (_len > size) {
+      _len = size;
+    }
+    const uint8_t *_data = SPIFlash::_gatherVec(vec, count, _index, _offset, _len, _page);
+    if (!_data) {
+      diagnostics.troubleshoot(UNKNOWNERROR);
+      return false;
+    }
+    SPIFlash *_chip = _chipOf(_addr);
+    uint32_t _chipAddr = _chipAddress(_addr);
+    if (_chip->_verifyWanted(_chipAddr, _len) && !_chip->_verify(_chipAddr, _data, _len)) {
+      return false;
+    }
+    _addr += _len;
+    size -= _len;
+  }
+  return true;
+}
+
+// Reads the size in front of a string written by writeStr(). False if there is none, or it runs past the volume
+bool SPIFlashVolume::_readStrSize(uint32_t _addr, uint32_t &size, bool fastRead) {
+  uint8_t _header[sizeof(size)];
+  size = 0;
+  if (!readByteArray(_addr, _header, sizeof(_header), fastRead)) {
+    return false;
+  }
+  for (uint8_t i = 0; i < sizeof(size); i++) {
+    size |= ((uint32_t)_header[i] << (8*i));
+  }
+  if (!size) {
+    diagnostics.troubleshoot(OUTOFBOUNDS);
+    return false;
+  }
+  return _inRange(_addr + sizeof(size), size);
+}
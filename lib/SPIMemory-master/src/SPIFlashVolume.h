@@ -0,0 +1,104 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPIFLASHVOLUME_H
+#define SPIFLASHVOLUME_H
+
+#include "SPIFlash.h"
+
+template <class Chip> class SPIFlashT;
+
+// One address space over several chips of the same size, each driven by an SPIFlash of its own (its own chip select).
+// Pages are striped across the chips - page 0 on the first chip, page 1 on the second and so on - so a write that runs
+// over several pages sends the next page to the next chip while the last one is still programming (tPP), and reads
+// fetch every chip's share of the range with one command per SPIMEMORY_VOLUME_VEC pages.
+//
+// The erase unit is getSectorSize(): one 4 KB sector on every chip, erased at the same time. Addresses run from 0 to
+// getCapacity() - 1 and do not wrap. A write returns once its last page has been sent, as SPIFlash writes do - the
+// chips wait for it before anything else. begin() has to have been called on every chip before begin() here; per-chip
+// settings (I/O mode, read cache, erased page map ...) are made on the chips themselves.
+//
+// The chips are driven through SPIFlash. An SPIFlashT array can be passed in as well - its begin(), called on each
+// chip, checks the device ID and sets the worst case busy times that the waits made from here are bounded by.
+//
+//      SPIFlash *chips[] = {&flash0, &flash1};
+//      SPIFlashVolume volume(chips, 2);
+//      volume.begin();
+//      volume.writeByteArray(_addr, data_buffer, bufferSize);
+class SPIFlashVolume {
+public:
+  SPIFlashVolume(SPIFlash **chips, uint8_t count);
+  template <class Chip> SPIFlashVolume(SPIFlashT<Chip> **chips, uint8_t count);
+  bool     begin(void);
+  uint8_t  error(bool verbosity = false);
+  uint32_t getCapacity(void);
+  uint32_t getMaxPage(void);
+  uint32_t getSectorSize(void);
+  uint8_t  getChipCount(void);
+  SPIFlash *getChip(uint8_t index);
+  void     setPolicy(uint8_t policy);
+  uint8_t  getPolicy(void);
+  //---------------------------------- Write / Read ---------------------------------------//
+  bool     writeByteArray(uint32_t _addr, const uint8_t *data_buffer, size_t bufferSize, bool errorCheck = true);
+  bool     readByteArray(uint32_t _addr, uint8_t *data_buffer, size_t bufferSize, bool fastRead = false);
+  bool     writev(uint32_t _addr, const SPIFlash::iovec *vec, uint8_t count, bool errorCheck = true);
+  bool     readStream(uint32_t _addr, uint32_t size, uint8_t *chunk_buffer, uint32_t chunkSize, SPIFlash::streamCallback callback, void *context = NULL, bool fastRead = false);
+  bool     writeStr(uint32_t _addr, const char *data, uint32_t length, bool errorCheck = true);
+  bool     readStr(uint32_t _addr, String &data, bool fastRead = false);
+  bool     readStr(uint32_t _addr, char *data_buffer, uint32_t bufferSize, uint32_t *length = NULL, bool fastRead = false);
+  bool     awaitProgram(uint32_t timeout = BUSY_TIMEOUT);
+  //-------------------------------------- Erase ------------------------------------------//
+  bool     planErase(uint32_t _addr, uint32_t _sz, SPIFlash::erasePlan &plan);
+  bool     eraseSector(uint32_t _addr);
+  bool     eraseSectorAsync(uint32_t _addr);
+  bool     eraseSection(uint32_t _addr, uint32_t _sz);
+  bool     eraseSectionAsync(uint32_t _addr, uint32_t _sz);
+  bool     eraseChip(void);
+  bool     eraseBusy(void);
+  bool     awaitErase(uint32_t timeout = BUSY_TIMEOUT);
+
+private:
+  bool     _inRange(uint32_t _addr, uint32_t size);
+  bool     _readChips(uint32_t _addr, uint8_t *data_buffer, uint32_t size, bool fastRead, bool cached);
+  bool     _sectors(uint32_t _addr, uint32_t _sz, uint32_t &first, uint32_t &count);
+  uint32_t _chipAddress(uint32_t _addr);
+  SPIFlash *_chipOf(uint32_t _addr);
+  bool     _program(uint32_t _addr, const SPIFlash::iovec *vec, uint8_t count, uint32_t size);
+  bool     _verify(uint32_t _addr, const SPIFlash::iovec *vec, uint8_t count, uint32_t size);
+  bool     _readStrSize(uint32_t _addr, uint32_t &size, bool fastRead);
+
+  SPIFlash *_chips[SPIMEMORY_VOLUME_MAX_CHIPS];
+  uint8_t   _count;
+  uint32_t  _chipCapacity = 0;              // 0 until begin() has checked the chips
+};
+
+// Takes the chips as SPIFlash, as the constructor above does
+template <class Chip> SPIFlashVolume::SPIFlashVolume(SPIFlashT<Chip> **chips, uint8_t count) {
+  _count = (count <= SPIMEMORY_VOLUME_MAX_CHIPS) ? count : 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    _chips[i] = chips[i];
+  }
+}
+
+#endif // SPIFLASHVOLUME_H
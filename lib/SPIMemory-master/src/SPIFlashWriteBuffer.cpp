@@ -0,0 +1,182 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "SPIMemory.h"
+
+// Takes three arguments -
+//  1. flash --> The SPIFlash the writes go to. begin() does not have to have been called yet
+//  2. flushTimeout --> Time (in milliseconds) a page may stay staged before poll() or the next write flushes it.
+//                      0 --> only when the page is full, another page is written or flush() is called
+//  3. errorCheck --> As for SPIFlash::writeByteArray(). Applies to every flush
+SPIFlashWriteBuffer::SPIFlashWriteBuffer(SPIFlash &flash, uint32_t flushTimeout, bool errorCheck) : _flash(flash) {
+  _flushTimeout = flushTimeout;
+  _errorCheck = errorCheck;
+  memset(_page, 0xFF, sizeof(_page));
+  memset(_dirty, 0, sizeof(_dirty));
+}
+
+SPIFlashWriteBuffer::~SPIFlashWriteBuffer(void) {
+  flush();
+}
+
+bool SPIFlashWriteBuffer::writeByte(uint32_t _addr, uint8_t data) {
+  return _stage(_addr, &data, sizeof(data));
+}
+
+bool SPIFlashWriteBuffer::writeChar(uint32_t _addr, int8_t data) {
+  return writeAnything(_addr, data);
+}
+
+bool SPIFlashWriteBuffer::writeShort(uint32_t _addr, int16_t data) {
+  return writeAnything(_addr, data);
+}
+
+bool SPIFlashWriteBuffer::writeWord(uint32_t _addr, uint16_t data) {
+  return writeAnything(_addr, data);
+}
+
+bool SPIFlashWriteBuffer::writeLong(uint32_t _addr, int32_t data) {
+  return writeAnything(_addr, data);
+}
+
+bool SPIFlashWriteBuffer::writeULong(uint32_t _addr, uint32_t data) {
+  return writeAnything(_addr, data);
+}
+
+bool SPIFlashWriteBuffer::writeFloat(uint32_t _addr, float data) {
+  return writeAnything(_addr, data);
+}
+
+// Stages a String in the layout SPIFlash::writeStr() uses - its size, null terminator included, as a 32-bit number,
+// followed by the characters and the terminator - so that SPIFlash::readStr() reads it back once it has been flushed
+bool SPIFlashWriteBuffer::writeStr(uint32_t _addr, const String &data) {
+  return writeStr(_addr, data.c_str(), data.length());
+}
+
+// As above, for length characters that need not be null terminated
+bool SPIFlashWriteBuffer::writeStr(uint32_t _addr, const char *data, uint32_t length) {
+  uint32_t _sz = length + 1;
+  uint8_t _terminator = '\0';
+  return writeAnything(_addr, _sz) && _stage(_addr + sizeof(_sz), (const uint8_t *)data, length) &&
+         _stage(_addr + sizeof(_sz) + length, &_terminator, sizeof(_terminator));
+}
+
+bool SPIFlashWriteBuffer::writeByteArray(uint32_t _addr, const uint8_t *data_buffer, size_t bufferSize) {
+  return _stage(_addr, data_buffer, bufferSize);
+}
+
+// Programs every run of staged bytes and empties the buffer. Returns false if a program fails - the buffer is emptied
+// all the same, and SPIFlash::error() tells what went wrong
+bool SPIFlashWriteBuffer::flush(void) {
+  if (!_staged) {
+    return true;
+  }
+  bool _retVal = true;
+  uint16_t i = 0;
+  while (i < SPI_PAGESIZE) {
+    if (!(_dirty[i / 8] & (1 << (i % 8)))) {
+      i++;
+      continue;
+    }
+    uint16_t _start = i;
+    while (i < SPI_PAGESIZE && (_dirty[i / 8] & (1 << (i % 8)))) {
+      i++;
+    }
+    _pagePrograms++;
+    if (!_flash.writeByteArray(_pageAddr + _start, &_page[_start], i - _start, _errorCheck)) {
+      _retVal = false;
+    }
+  }
+  memset(_page, 0xFF, sizeof(_page));
+  memset(_dirty, 0, sizeof(_dirty));
+  _staged = false;
+  return _retVal;
+}
+
+// Flushes the buffer if the page has been staged for longer than the flush timeout. Call it regularly - e.g. from
+// loop() - for staged data to reach the chip when no more writes come
+bool SPIFlashWriteBuffer::poll(void) {
+  if (_staged && _flushTimeout && (millis() - _stagedAt >= _flushTimeout)) {
+    return flush();
+  }
+  return true;
+}
+
+// Returns true while there is staged data that has not been programmed
+bool SPIFlashWriteBuffer::pending(void) {
+  return _staged;
+}
+
+void SPIFlashWriteBuffer::setFlushTimeout(uint32_t flushTimeout) {
+  _flushTimeout = flushTimeout;
+}
+
+// Returns the number of program operations sent to the chip since the buffer was created or resetPagePrograms()
+uint32_t SPIFlashWriteBuffer::pagePrograms(void) {
+  return _pagePrograms;
+}
+
+void SPIFlashWriteBuffer::resetPagePrograms(void) {
+  _pagePrograms = 0;
+}
+
+// Copies size bytes into the page images they fall in, one page at a time. Moving on to another page flushes the one
+// before, and so does filling a page up to its last byte
+bool SPIFlashWriteBuffer::_stage(uint32_t _addr, const uint8_t *data_buffer, uint32_t size) {
+  if (!poll()) {
+    return false;
+  }
+  if (_addr + size > _flash.getCapacity()) {
+    if (!flush()) {
+      return false;
+    }
+    _pagePrograms += (size + (_addr % SPI_PAGESIZE) + SPI_PAGESIZE - 1) / SPI_PAGESIZE;
+    return _flash.writeByteArray(_addr, (uint8_t *)data_buffer, size, _errorCheck);
+  }
+
+  while (size) {
+    uint32_t _pageStart = _addr & ~(uint32_t)(SPI_PAGESIZE - 1);
+    uint16_t _offset = _addr - _pageStart;
+    uint16_t _length = (size < (uint32_t)(SPI_PAGESIZE - _offset)) ? size : (SPI_PAGESIZE - _offset);
+
+    if (_staged && _pageStart != _pageAddr && !flush()) {
+      return false;
+    }
+    if (!_staged) {
+      _pageAddr = _pageStart;
+      _stagedAt = millis();
+      _staged = true;
+    }
+    for (uint16_t i = _offset; i < _offset + _length; i++) {
+      _page[i] &= *data_buffer++;
+      _dirty[i / 8] |= (1 << (i % 8));
+    }
+    if (_offset + _length == SPI_PAGESIZE && !flush()) {
+      return false;
+    }
+    _addr += _length;
+    size -= _length;
+  }
+  return true;
+}
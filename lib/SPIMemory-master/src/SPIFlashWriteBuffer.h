@@ -0,0 +1,93 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPIFLASHWRITEBUFFER_H
+#define SPIFLASHWRITEBUFFER_H
+
+#include "SPIFlash.h"
+
+// Combines small writes into whole page programs. Every write to SPIFlash is a program operation of its own (write
+// enable, page program, tPP), however few bytes it carries - logging a float at a time costs one for every 4 bytes.
+// SPIFlashWriteBuffer copies the writes into a RAM image of the page they fall in, and programs the page once.
+//
+// Durability: a write that returns true has only been copied to RAM. It reaches the chip when the buffer is flushed -
+//  - the page is full up to its last byte, or a write goes to another page
+//  - flush() is called, or the buffer is destroyed
+//  - poll() - or the next write - finds the page staged for longer than the flush timeout
+// Staged data is lost if the board resets or loses power before that, and reads through SPIFlash do not see it.
+// Call flush() before reading back or powering down, and after anything that has to survive a reset.
+//
+// As on the chip, writing a staged byte again clears the bits that are 0 in either value. Runs of bytes that were not
+// written are left out of the program, so the rest of the page is never touched. Writes that run past the end of the
+// chip are not staged, but written straight through once the buffer has been flushed.
+//
+//      SPIFlashWriteBuffer log(flash);
+//      log.writeFloat(_addr, value);        // Staged
+//      log.flush();                          // Programmed
+class SPIFlashWriteBuffer {
+public:
+  SPIFlashWriteBuffer(SPIFlash &flash, uint32_t flushTimeout = SPIMEMORY_WRITEBUFFER_TIMEOUT_MS, bool errorCheck = true);
+  ~SPIFlashWriteBuffer(void);
+  //------------------------------------ Write functions ----------------------------------//
+  bool     writeByte(uint32_t _addr, uint8_t data);
+  bool     writeChar(uint32_t _addr, int8_t data);
+  bool     writeShort(uint32_t _addr, int16_t data);
+  bool     writeWord(uint32_t _addr, uint16_t data);
+  bool     writeLong(uint32_t _addr, int32_t data);
+  bool     writeULong(uint32_t _addr, uint32_t data);
+  bool     writeFloat(uint32_t _addr, float data);
+  bool     writeStr(uint32_t _addr, const String &data);
+  bool     writeStr(uint32_t _addr, const char *data, uint32_t length);
+  bool     writeByteArray(uint32_t _addr, const uint8_t *data_buffer, size_t bufferSize);
+  template <class T> bool writeAnything(uint32_t _addr, const T& data);
+  //------------------------------------- Flushing ----------------------------------------//
+  bool     flush(void);
+  bool     poll(void);
+  bool     pending(void);
+  void     setFlushTimeout(uint32_t flushTimeout);
+  uint32_t pagePrograms(void);
+  void     resetPagePrograms(void);
+
+private:
+  bool     _stage(uint32_t _addr, const uint8_t *data_buffer, uint32_t size);
+
+  SPIFlash &_flash;
+  uint8_t   _page[SPI_PAGESIZE];            // Image of the staged page. Bytes that were not written stay 0xFF
+  uint8_t   _dirty[SPI_PAGESIZE / 8];       // One bit per byte of _page that has been written
+  uint32_t  _pageAddr = 0;
+  bool      _staged = false;
+  uint32_t  _stagedAt = 0;                  // millis() when the first byte of the page was staged
+  uint32_t  _flushTimeout;
+  bool      _errorCheck;
+  uint32_t  _pagePrograms = 0;              // Program operations sent by flush() and the write-through path
+};
+
+// Stages any type of data. Takes two arguments -
+//  1. _addr --> Any address from 0 to maxAddress
+//  2. T& value --> Variable to write
+template <class T> bool SPIFlashWriteBuffer::writeAnything(uint32_t _addr, const T& data) {
+  return _stage(_addr, (const uint8_t*)(const void*)&data, sizeof(data));
+}
+
+#endif // SPIFLASHWRITEBUFFER_H
@@ -35,6 +35,20 @@ SPIFram::SPIFram(uint8_t cs) {
   pinMode(csPin, OUTPUT);
   CHIP_DESELECT
 }
+#elif defined (SPIMEMORY_TRANSPORT)
+// The chip select pin is set up by the transport when begin() is called
+SPIFram::SPIFram(uint8_t cs, SPIClass *spiinterface) : _defaultBus(cs, spiinterface) {
+  _spi = spiinterface;  //Sets SPI interface - if no user selection is made, this defaults to SPI
+  _bus = &_defaultBus;
+  csPin = cs;
+}
+
+//Lets the user choose how the chip is reached. The transport has to outlive the SPIFram object
+SPIFram::SPIFram(SPIMemoryTransport &transport) {
+  _spi = &SPI;
+  _bus = &transport;
+  csPin = CS;
+}
 #elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
 SPIFram::SPIFram(uint8_t cs, SPIClass *spiinterface) {
   _spi = spiinterface;  //Sets SPI interface - if no user selection is made, this defaults to SPI
@@ -88,6 +102,9 @@ bool SPIFram::begin(uint32_t flashChipSize) {
 #ifdef SPI_HAS_TRANSACTION
 void SPIFram::setClock(uint32_t clockSpeed) {
   _settings = SPISettings(clockSpeed, MSBFIRST, SPI_MODE0);
+#if defined (SPIMEMORY_TRANSPORT)
+  _bus->setClock(clockSpeed);
+#endif
 }
 #endif
 
@@ -33,7 +33,10 @@ class SPIFram {
 public:
   //------------------------------------ Constructor ------------------------------------//
   //New Constructor to Accept the PinNames as a Chip select Parameter - @boseji <salearj@hotmail.com> 02.03.17
-  #if defined (ARDUINO_ARCH_SAMD) || defined(ARCH_STM32)
+  #if defined (SPIMEMORY_TRANSPORT)
+  SPIFram(uint8_t cs = CS, SPIClass *spiinterface=&SPI);
+  SPIFram(SPIMemoryTransport &transport);
+  #elif defined (ARDUINO_ARCH_SAMD) || defined(ARCH_STM32)
   SPIFram(uint8_t cs = CS, SPIClass *spiinterface=&SPI);
   #elif defined (BOARD_RTL8195A)
   SPIFram(PinName cs = CS);
@@ -130,6 +133,11 @@ private:
   #endif
   //If multiple SPI ports are available this variable is used to choose between them (SPI, SPI1, SPI2 etc.)
   SPIClass *_spi;
+  #if defined (SPIMEMORY_TRANSPORT)
+  //The transport the chip is reached through. Points to _defaultBus unless a transport is passed to the constructor
+  SPIMemoryArduinoTransport _defaultBus;
+  SPIMemoryTransport *_bus;
+  #endif
   #if !defined (BOARD_RTL8195A)
   uint8_t     csPin;
   #else
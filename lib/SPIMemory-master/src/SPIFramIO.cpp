@@ -107,13 +107,15 @@
  }
 
  bool SPIFram::_startSPIBus(void) {
-   #ifndef SPI_HAS_TRANSACTION
+   #if !defined (SPI_HAS_TRANSACTION) && !defined (SPIMEMORY_TRANSPORT)
        noInterrupts();
    #endif
 
-   #if defined (ARDUINO_ARCH_SAM)
+   #if defined (SPIMEMORY_TRANSPORT)
+     _bus->beginTransaction();
+   #elif defined (ARDUINO_ARCH_SAM)
      due.SPIInit(DUE_SPI_CLK);
-   #elif defined (ARDUINO_ARCH_SAMD)
+   #elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
      #ifdef SPI_HAS_TRANSACTION
        _spi->beginTransaction(_settings);
      #else
@@ -194,7 +196,9 @@
 
  //Reads/Writes next int. Call 'n' times to read/write 'n' number of integers. Should be called after _beginSPI()
  uint16_t SPIFram::_nextInt(uint16_t data) {
- #if defined (ARDUINO_ARCH_SAMD)
+ #if defined (SPIMEMORY_TRANSPORT)
+   return _bus->transfer16(data);
+ #elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
    return _spi->transfer16(data);
  #else
    return SPI.transfer16(data);
@@ -206,9 +210,11 @@
    uint8_t *_dataAddr = &(*data_buffer);
    switch (opcode) {
      case READDATA:
-     #if defined (ARDUINO_ARCH_SAM)
+     #if defined (SPIMEMORY_TRANSPORT)
+       _bus->readBuf(data_buffer, size);
+     #elif defined (ARDUINO_ARCH_SAM)
        due.SPIRecByte(&(*data_buffer), size);
-     #elif defined (ARDUINO_ARCH_SAMD)
+     #elif defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
        #ifdef ENABLEZERODMA
          spi_read(&(*data_buffer), size);
        #else
@@ -225,7 +231,9 @@
      break;
 
      case PAGEPROG:
-     #if defined (ARDUINO_ARCH_SAM)
+     #if defined (SPIMEMORY_TRANSPORT)
+       _bus->writeBuf(data_buffer, size);
+     #elif defined (ARDUINO_ARCH_SAM)
        due.SPISendByte(&(*data_buffer), size);
      #elif defined (ARDUINO_ARCH_SAMD)
        #ifdef ENABLEZERODMA
@@ -249,8 +257,10 @@
  void SPIFram::_endSPI(void) {
    CHIP_DESELECT
 
- #ifdef SPI_HAS_TRANSACTION
-   #if defined (ARDUINO_ARCH_SAMD)
+ #if defined (SPIMEMORY_TRANSPORT)
+   _bus->endTransaction();
+ #elif defined (SPI_HAS_TRANSACTION)
+   #if defined (ARDUINO_ARCH_SAMD) || defined (ARCH_STM32)
      _spi->endTransaction();
    #else
      SPI.endTransaction();
@@ -47,6 +47,8 @@
 //                  by disabling _notPrevWritten()                    //
 //                                                                    //
 // Make sure the sectors being written to have been erased beforehand //
+//  Sets the default policy of every SPIFlash - use setPolicy() with  //
+//   SPIMEMORY_POLICY_HIGHSPEED to do this for one instance instead   //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 //#define HIGHSPEED                                                   //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
@@ -55,6 +57,8 @@
 //   Uncomment the code below to disable overflow and force data      //
 //   to only be written to the last address of the flash memory       //
 //    and not rollover to address 0x00 when the end is reached        //
+//  Sets the default policy of every SPIFlash - use setPolicy() with  //
+//  SPIMEMORY_POLICY_NOOVERFLOW to do this for one instance instead   //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 //#define DISABLEOVERFLOW                                             //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
@@ -69,9 +73,19 @@
 //#define ZERO_SPISERCOM SERCOM4                                      //
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//  On these platforms the chip is reached through an                //
+//  SPIMemoryTransport - see SPIMemoryTransport.h                     //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#if defined (ARDUINO_ARCH_ESP32) || defined (ARDUINO_ARCH_NATIVE)
+  #define SPIMEMORY_TRANSPORT
+#endif
+
   #include <Arduino.h>
   #include <SPI.h>
   #include "defines.h"
+  #include "SPIMemoryTransport.h"
+  #include "SPIMemoryIDFTransport.h"
   #include "SPIFlash.h"
   #include "SPIFram.h"
   #include "diagnostics.h"
@@ -107,7 +121,7 @@
     #define ARCH_STM32
   #endif
 #endif
-#if defined (ARDUINO_ARCH_SAM) || defined (ARDUINO_ARCH_SAMD) || defined (ARDUINO_ARCH_ESP8266) || defined (SIMBLEE) || defined (ARDUINO_ARCH_ESP32) || defined (BOARD_RTL8195A) || defined(ARCH_STM32) || defined(ESP32) || defined(NRF52)
+#if defined (ARDUINO_ARCH_SAM) || defined (ARDUINO_ARCH_SAMD) || defined (ARDUINO_ARCH_ESP8266) || defined (SIMBLEE) || defined (ARDUINO_ARCH_ESP32) || defined (BOARD_RTL8195A) || defined(ARCH_STM32) || defined(ESP32) || defined(NRF52) || defined (ARDUINO_ARCH_NATIVE)
 // RTL8195A included - @boseji <salearj@hotmail.com> 02.03.17
   #define _delay_us(us) delayMicroseconds(us)
 #else
@@ -0,0 +1,380 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "SPIMemory.h"
+
+#if defined (ARDUINO_ARCH_ESP32)
+
+#define SPIMEMORY_IDF_VARIABLE_PHASES (SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY)
+
+// Constructor
+//  Takes six arguments -
+//    1. host --> SPI2_HOST (HSPI) or SPI3_HOST (VSPI)
+//    2. sck, miso, mosi --> Bus pins. The bus is only set up by begin()
+//    3. cs --> Chip select pin
+//    4. maxTransferSize --> Largest single DMA transaction in bytes
+SPIMemoryIDFTransport::SPIMemoryIDFTransport(spi_host_device_t host, int8_t sck, int8_t miso, int8_t mosi, int8_t cs, uint32_t maxTransferSize) {
+  _host = host;
+  _sck = sck;
+  _miso = miso;
+  _mosi = mosi;
+  _csPin = (gpio_num_t)cs;
+  _maxTransferSize = maxTransferSize;
+
+  _csFrame = {_csPin, true, true};
+  _csOpen  = {_csPin, true, false};
+  _csHold  = {_csPin, false, false};
+  _csClose = {_csPin, false, true};
+
+  memset(&_wrenTrans, 0, sizeof(_wrenTrans));
+  _wrenTrans.base.flags = SPIMEMORY_IDF_VARIABLE_PHASES;
+  _wrenTrans.base.cmd = WRITEENABLE;
+  _wrenTrans.base.user = &_csFrame;
+  _wrenTrans.command_bits = 8;
+
+  memset(&_cmdTrans, 0, sizeof(_cmdTrans));
+  _cmdTrans.base.flags = SPIMEMORY_IDF_VARIABLE_PHASES;
+  _cmdTrans.command_bits = 8;
+}
+
+SPIMemoryIDFTransport::~SPIMemoryIDFTransport(void) {
+  _removeDevice();
+  if (_busOwner) {
+    spi_bus_free(_host);
+  }
+}
+
+// IO2 and IO3 of the chip, for the quad modes. Has to be called before begin()
+void SPIMemoryIDFTransport::setQuadPins(int8_t wp, int8_t hd) {
+  _wp = wp;
+  _hd = hd;
+}
+
+bool SPIMemoryIDFTransport::begin(void) {
+  if (_device) {
+    return true;
+  }
+  spi_bus_config_t _busConfig;
+  memset(&_busConfig, 0, sizeof(_busConfig));
+  _busConfig.sclk_io_num = _sck;
+  _busConfig.miso_io_num = _miso;
+  _busConfig.mosi_io_num = _mosi;
+  _busConfig.quadwp_io_num = _wp;
+  _busConfig.quadhd_io_num = _hd;
+  _busConfig.max_transfer_sz = _maxTransferSize;
+
+  esp_err_t _err = spi_bus_initialize(_host, &_busConfig, SPI_DMA_CH_AUTO);
+  if (_err != ESP_OK && _err != ESP_ERR_INVALID_STATE) {    // ESP_ERR_INVALID_STATE --> the bus has already been set up for another device
+    return false;
+  }
+  _busOwner = (_err == ESP_OK);
+
+  gpio_reset_pin(_csPin);
+  gpio_set_direction(_csPin, GPIO_MODE_OUTPUT);
+  deselect();
+  return _addDevice();
+}
+
+// The clock speed is fixed when a device is added to the bus, so the device is added again with the new speed
+void SPIMemoryIDFTransport::setClock(uint32_t clockSpeed) {
+  _clockSpeed = clockSpeed;
+  if (_device) {
+    _removeDevice();
+    _addDevice();
+  }
+}
+
+bool SPIMemoryIDFTransport::_addDevice(void) {
+  spi_device_interface_config_t _devConfig;
+  memset(&_devConfig, 0, sizeof(_devConfig));
+  _devConfig.mode = 0;
+  _devConfig.clock_speed_hz = _clockSpeed;
+  _devConfig.spics_io_num = -1;               // Chip select is driven from _preTransfer()/_postTransfer() and select()/deselect()
+  _devConfig.queue_size = SPIMEMORY_IDF_QUEUE_SIZE;
+  _devConfig.pre_cb = _preTransfer;
+  _devConfig.post_cb = _postTransfer;
+  if (spi_bus_add_device(_host, &_devConfig, &_device) != ESP_OK) {
+    return false;
+  }
+  _devConfig.flags = SPI_DEVICE_HALFDUPLEX;
+  if (spi_bus_add_device(_host, &_devConfig, &_lineDevice) != ESP_OK) {
+    _lineDevice = NULL;                       // Single line commands still work
+  }
+  return true;
+}
+
+void SPIMemoryIDFTransport::_removeDevice(void) {
+  endTransaction();
+  if (_lineDevice) {
+    spi_bus_remove_device(_lineDevice);
+    _lineDevice = NULL;
+  }
+  if (_device) {
+    spi_bus_remove_device(_device);
+    _device = NULL;
+  }
+}
+
+// Keeps other devices on the host off the bus until endTransaction() is called
+void SPIMemoryIDFTransport::beginTransaction(void) {
+  if (_device && !_busHolder) {
+    if (spi_device_acquire_bus(_device, portMAX_DELAY) == ESP_OK) {
+      _busHolder = _device;
+    }
+  }
+}
+
+void SPIMemoryIDFTransport::endTransaction(void) {
+  if (_busHolder) {
+    spi_device_release_bus(_busHolder);
+    _busHolder = NULL;
+  }
+}
+
+// Returns the device that sends commands in ioMode. The driver blocks a device while another one holds the bus, so
+// inside a transaction the bus is handed over to it. It is only handed back when a single line command comes along
+spi_device_handle_t SPIMemoryIDFTransport::_useDevice(uint8_t ioMode) {
+  spi_device_handle_t _dev = (ioMode == SPIMEMORY_IO_SINGLE) ? _device : _lineDevice;
+  if (_busHolder && _busHolder != _dev) {
+    spi_device_release_bus(_busHolder);
+    _busHolder = (spi_device_acquire_bus(_dev, portMAX_DELAY) == ESP_OK) ? _dev : NULL;
+  }
+  return _dev;
+}
+
+bool SPIMemoryIDFTransport::supportsIOMode(uint8_t ioMode) {
+  switch (ioMode) {
+    case SPIMEMORY_IO_SINGLE:
+    return true;
+    case SPIMEMORY_IO_DUAL:
+    return (_lineDevice != NULL);
+    case SPIMEMORY_IO_QUAD:
+    case SPIMEMORY_IO_QUADIO:
+    return (_lineDevice != NULL && _wp >= 0 && _hd >= 0);
+    default:
+    return false;
+  }
+}
+
+void SPIMemoryIDFTransport::select(void) {
+  gpio_set_level(_csPin, 0);
+}
+
+void SPIMemoryIDFTransport::deselect(void) {
+  gpio_set_level(_csPin, 1);
+}
+
+// Called by the driver - from the SPI interrupt for queued transactions - right before/after each transaction
+void IRAM_ATTR SPIMemoryIDFTransport::_preTransfer(spi_transaction_t *trans) {
+  const _csControl *_cs = (const _csControl*)trans->user;
+  if (_cs && _cs->assert) {
+    gpio_set_level(_cs->pin, 0);
+  }
+}
+
+void IRAM_ATTR SPIMemoryIDFTransport::_postTransfer(spi_transaction_t *trans) {
+  const _csControl *_cs = (const _csControl*)trans->user;
+  if (_cs && _cs->release) {
+    gpio_set_level(_cs->pin, 1);
+  }
+}
+
+// Single bytes are polled with the data held in the transaction itself - no DMA descriptor is set up
+uint8_t SPIMemoryIDFTransport::transfer(uint8_t data) {
+  spi_transaction_t _t;
+  memset(&_t, 0, sizeof(_t));
+  _t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+  _t.length = 8;
+  _t.tx_data[0] = data;
+  spi_device_polling_transmit(_useDevice(SPIMEMORY_IO_SINGLE), &_t);
+  return _t.rx_data[0];
+}
+
+uint16_t SPIMemoryIDFTransport::transfer16(uint16_t data) {
+  spi_transaction_t _t;
+  memset(&_t, 0, sizeof(_t));
+  _t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+  _t.length = 16;
+  _t.tx_data[0] = data >> 8;
+  _t.tx_data[1] = data & 0xFF;
+  spi_device_polling_transmit(_useDevice(SPIMEMORY_IO_SINGLE), &_t);
+  return (_t.rx_data[0] << 8) | _t.rx_data[1];
+}
+
+void SPIMemoryIDFTransport::readBuf(uint8_t *data_buffer, uint32_t size) {
+  _transmit(_useDevice(SPIMEMORY_IO_SINGLE), NULL, NULL, data_buffer, size, false, 0);
+}
+
+void SPIMemoryIDFTransport::writeBuf(const uint8_t *data_buffer, uint32_t size) {
+  _transmit(_useDevice(SPIMEMORY_IO_SINGLE), NULL, data_buffer, NULL, size, false, 0);
+}
+
+void SPIMemoryIDFTransport::readData(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t *data_buffer, uint32_t size, uint8_t ioMode) {
+  _setCommand(opcode, address, addressBytes, dummyBytes, ioMode);
+  _transmit(_useDevice(ioMode), &_cmdTrans, NULL, data_buffer, size, false, _cmdTrans.base.flags & (SPI_TRANS_MODE_DIO | SPI_TRANS_MODE_QIO));
+}
+
+bool SPIMemoryIDFTransport::programPage(uint8_t opcode, uint32_t address, uint8_t addressBytes, const uint8_t *data_buffer, uint32_t size, bool writeEnable, uint8_t ioMode) {
+  _setCommand(opcode, address, addressBytes, 0, ioMode);
+  return _transmit(_useDevice(ioMode), &_cmdTrans, data_buffer, NULL, size, writeEnable, _cmdTrans.base.flags & (SPI_TRANS_MODE_DIO | SPI_TRANS_MODE_QIO));
+}
+
+// Sends the command phases on their own, with the chip select left asserted. The data follows in readNext() as raw
+// transactions on the same device
+void SPIMemoryIDFTransport::beginRead(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode) {
+  _setCommand(opcode, address, addressBytes, dummyBytes, ioMode);
+  _readDevice = _useDevice(ioMode);
+  _readFlags = _cmdTrans.base.flags & (SPI_TRANS_MODE_DIO | SPI_TRANS_MODE_QIO);
+  spi_transaction_ext_t _t = _cmdTrans;
+  _t.base.length = 0;
+  _t.base.rxlength = 0;
+  _t.base.tx_buffer = NULL;
+  _t.base.rx_buffer = NULL;
+  _t.base.user = &_csOpen;
+  spi_device_polling_transmit(_readDevice, &_t.base);
+}
+
+void SPIMemoryIDFTransport::readNext(uint8_t *data_buffer, uint32_t size) {
+  _transmit(_readDevice, NULL, NULL, data_buffer, size, false, _readFlags);
+}
+
+void SPIMemoryIDFTransport::endRead(void) {
+  deselect();
+}
+
+// Fills in the command phases of _cmdTrans. With the address on four lines (EBh) the mode byte - the first dummy byte -
+// goes out as 0xFF at the end of the address phase, and the dummy phase is left with the remaining clocks
+void SPIMemoryIDFTransport::_setCommand(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode) {
+  _cmdTrans.base.flags = SPIMEMORY_IDF_VARIABLE_PHASES;
+  if (DATALINES(ioMode) == 2) {
+    _cmdTrans.base.flags |= SPI_TRANS_MODE_DIO;
+  }
+  else if (DATALINES(ioMode) == 4) {
+    _cmdTrans.base.flags |= SPI_TRANS_MODE_QIO;
+  }
+  _cmdTrans.base.cmd = opcode;
+  if (ADDRESSLINES(ioMode) > 1 && dummyBytes) {
+    _cmdTrans.base.flags |= SPI_TRANS_MULTILINE_ADDR;
+    _cmdTrans.base.addr = ((uint64_t)address << 8) | 0xFF;
+    _cmdTrans.address_bits = (addressBytes + 1) * 8;
+    _cmdTrans.dummy_bits = (dummyBytes - 1) * 8 / ADDRESSLINES(ioMode);
+  }
+  else {
+    _cmdTrans.base.addr = address;
+    _cmdTrans.address_bits = addressBytes * 8;
+    _cmdTrans.dummy_bits = dummyBytes * 8 / ADDRESSLINES(ioMode);
+  }
+}
+
+// Sends one command as a list of transactions and waits for all of them to complete
+//  Takes seven arguments -
+//    1. device --> _device, or _lineDevice for a dual/quad command
+//    2. command --> Command phases to send ahead of the data. If NULL, the data is sent raw and the chip select is
+//                   left to select()/deselect()
+//    3. tx_buffer --> Data to be sent, or NULL
+//    4. rx_buffer --> Buffer for the received data, or NULL
+//    5. size --> Number of data bytes. Split into transactions of at most _maxTransferSize bytes
+//    6. writeEnable --> If true, a write enable command is queued ahead of the command
+//    7. lineFlags --> SPI_TRANS_MODE_DIO/QIO for the data phase of every transaction, or 0
+bool SPIMemoryIDFTransport::_transmit(spi_device_handle_t device, const spi_transaction_ext_t *command, const uint8_t *tx_buffer, uint8_t *rx_buffer, uint32_t size, bool writeEnable, uint32_t lineFlags) {
+  if (!command && !size) {
+    return true;
+  }
+  bool _poll = (size <= SPIMEMORY_IDF_POLLING_MAX);
+  bool _retVal = true;
+  uint8_t _queued = 0;
+  uint8_t _slot = 0;
+  uint32_t _offset = 0;
+
+  if (writeEnable) {
+    _retVal = _start(device, &_wrenTrans.base, _poll, _queued);
+  }
+  do {
+    uint32_t _chunk = size - _offset;
+    if (_chunk > _maxTransferSize) {
+      _chunk = _maxTransferSize;
+    }
+    bool _first = (_offset == 0);
+    bool _last = (_offset + _chunk == size);
+
+    // Results come back in order, so once fewer than SPIMEMORY_IDF_QUEUE_SIZE transactions are in flight, _trans[_slot] is free
+    if (_queued == SPIMEMORY_IDF_QUEUE_SIZE) {
+      _retVal &= _collect(device, _queued);
+    }
+    spi_transaction_ext_t *_t = &_trans[_slot];
+    _slot = (_slot + 1) % SPIMEMORY_IDF_QUEUE_SIZE;
+    if (command && _first) {
+      *_t = *command;
+    }
+    else {
+      memset(_t, 0, sizeof(*_t));
+      _t->base.flags = SPIMEMORY_IDF_VARIABLE_PHASES | lineFlags;   // No command, address or dummy phase
+    }
+    if (device == _lineDevice) {
+      // Half duplex - the data phase only goes one way
+      _t->base.length = tx_buffer ? _chunk * 8 : 0;
+      _t->base.rxlength = rx_buffer ? _chunk * 8 : 0;
+    }
+    else {
+      _t->base.length = _chunk * 8;
+    }
+    _t->base.tx_buffer = tx_buffer ? &tx_buffer[_offset] : NULL;
+    _t->base.rx_buffer = rx_buffer ? &rx_buffer[_offset] : NULL;
+    if (command) {
+      if (_first) {
+        _t->base.user = _last ? &_csFrame : &_csOpen;
+      }
+      else {
+        _t->base.user = _last ? &_csClose : &_csHold;
+      }
+    }
+    _retVal &= _start(device, &_t->base, _poll, _queued);
+    _offset += _chunk;
+  } while (_offset < size);
+
+  while (_queued) {
+    _retVal &= _collect(device, _queued);
+  }
+  return _retVal;
+}
+
+bool SPIMemoryIDFTransport::_start(spi_device_handle_t device, spi_transaction_t *trans, bool poll, uint8_t &queued) {
+  if (poll) {
+    return (spi_device_polling_transmit(device, trans) == ESP_OK);
+  }
+  if (spi_device_queue_trans(device, trans, portMAX_DELAY) != ESP_OK) {
+    return false;
+  }
+  queued++;
+  return true;
+}
+
+// Blocks - without using the CPU - until the oldest queued transaction is done
+bool SPIMemoryIDFTransport::_collect(spi_device_handle_t device, uint8_t &queued) {
+  spi_transaction_t *_done;
+  queued--;
+  return (spi_device_get_trans_result(device, &_done, portMAX_DELAY) == ESP_OK);
+}
+
+#endif
@@ -0,0 +1,111 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPIMEMORYIDFTRANSPORT_H
+#define SPIMEMORYIDFTRANSPORT_H
+
+#if defined (ARDUINO_ARCH_ESP32)
+
+#include "SPIMemoryTransport.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+
+#define SPIMEMORY_IDF_MAX_TRANSFER  4096    // Largest single DMA transaction. Longer transfers are split with the chip kept selected
+#define SPIMEMORY_IDF_QUEUE_SIZE    4       // Transactions in flight per command
+#define SPIMEMORY_IDF_POLLING_MAX   32      // Transfers up to this many bytes are polled - an interrupt costs more than it saves here
+
+// Backend built on the ESP-IDF spi_master driver. Reads and page programs are sent as queued DMA transactions with
+// the command, address and dummy bytes in the hardware phases of the first one, so the CPU only sets up the list
+// and sleeps until the last transaction completes. Write enable and page program go out as one list.
+//
+// The chip select is driven by the transport (not by the driver) so that one command may span several transactions.
+// The bus is owned by the driver - do not use an SPIClass on the same host. Other devices may share the host through
+// spi_bus_add_device(); in that case the bus is only initialised by whichever side comes first.
+//
+// Read buffers that are 4-byte aligned and a multiple of 4 bytes long are filled by DMA directly. Anything else goes
+// through a bounce buffer allocated by the driver.
+//
+// Dual reads work on the bus pins alone. Quad reads and programs need IO2 and IO3 (/WP and /HOLD on the chip) wired to
+// GPIOs, passed with setQuadPins() before begin(). Multi-line commands go through a second, half-duplex device on the
+// same host, since the driver only drives several data lines in half-duplex mode.
+class SPIMemoryIDFTransport : public SPIMemoryTransport {
+public:
+  SPIMemoryIDFTransport(spi_host_device_t host, int8_t sck, int8_t miso, int8_t mosi, int8_t cs, uint32_t maxTransferSize = SPIMEMORY_IDF_MAX_TRANSFER);
+  ~SPIMemoryIDFTransport(void);
+  void     setQuadPins(int8_t wp, int8_t hd);
+  bool     begin(void);
+  void     setClock(uint32_t clockSpeed);
+  void     beginTransaction(void);
+  void     endTransaction(void);
+  void     select(void);
+  void     deselect(void);
+  uint8_t  transfer(uint8_t data);
+  uint16_t transfer16(uint16_t data);
+  void     readBuf(uint8_t *data_buffer, uint32_t size);
+  void     writeBuf(const uint8_t *data_buffer, uint32_t size);
+  bool     supportsIOMode(uint8_t ioMode);
+  void     readData(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t *data_buffer, uint32_t size, uint8_t ioMode = SPIMEMORY_IO_SINGLE);
+  bool     programPage(uint8_t opcode, uint32_t address, uint8_t addressBytes, const uint8_t *data_buffer, uint32_t size, bool writeEnable, uint8_t ioMode = SPIMEMORY_IO_SINGLE);
+  void     beginRead(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode = SPIMEMORY_IO_SINGLE);
+  void     readNext(uint8_t *data_buffer, uint32_t size);
+  void     endRead(void);
+
+private:
+  // Passed to the driver callbacks through spi_transaction_t::user
+  struct   _csControl {
+             gpio_num_t pin;
+             bool assert;
+             bool release;
+           };
+  static void _preTransfer(spi_transaction_t *trans);
+  static void _postTransfer(spi_transaction_t *trans);
+  bool     _addDevice(void);
+  void     _removeDevice(void);
+  spi_device_handle_t _useDevice(uint8_t ioMode);
+  void     _setCommand(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode);
+  bool     _transmit(spi_device_handle_t device, const spi_transaction_ext_t *command, const uint8_t *tx_buffer, uint8_t *rx_buffer, uint32_t size, bool writeEnable, uint32_t lineFlags);
+  bool     _start(spi_device_handle_t device, spi_transaction_t *trans, bool poll, uint8_t &queued);
+  bool     _collect(spi_device_handle_t device, uint8_t &queued);
+
+  spi_device_handle_t _device = NULL;
+  spi_device_handle_t _lineDevice = NULL;     // Half-duplex twin of _device for dual/quad commands
+  spi_device_handle_t _busHolder = NULL;      // Device that holds the bus between beginTransaction() and endTransaction()
+  spi_device_handle_t _readDevice = NULL;     // Device and data line flags of the read opened by beginRead()
+  uint32_t _readFlags = 0;
+  spi_host_device_t _host;
+  int8_t   _sck, _miso, _mosi;
+  int8_t   _wp = -1, _hd = -1;
+  gpio_num_t _csPin;
+  uint32_t _clockSpeed = SPI_CLK;
+  uint32_t _maxTransferSize;
+  bool     _busOwner = false;
+  _csControl _csFrame, _csOpen, _csHold, _csClose;
+  // Pre-built transactions - only the opcode, address and buffers change from one command to the next
+  spi_transaction_ext_t _wrenTrans, _cmdTrans;
+  spi_transaction_ext_t _trans[SPIMEMORY_IDF_QUEUE_SIZE];
+};
+
+#endif
+
+#endif // _SPIMEMORYIDFTRANSPORT_H_
@@ -0,0 +1,189 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "SPIMemory.h"
+
+#if defined (SPIMEMORY_TRANSPORT)
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//            Default implementations for every transport             //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+// Sends the most significant byte first, as SPIClass::transfer16() does by default
+uint16_t SPIMemoryTransport::transfer16(uint16_t data) {
+  uint16_t _retVal = transfer(data >> 8) << 8;
+  _retVal |= transfer(data & 0xFF);
+  return _retVal;
+}
+
+void SPIMemoryTransport::readBuf(uint8_t *data_buffer, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++) {
+    data_buffer[i] = transfer(NULLBYTE);
+  }
+}
+
+void SPIMemoryTransport::writeBuf(const uint8_t *data_buffer, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++) {
+    transfer(data_buffer[i]);
+  }
+}
+
+// Only the single line mode can be built from transfer()
+bool SPIMemoryTransport::supportsIOMode(uint8_t ioMode) {
+  return (ioMode == SPIMEMORY_IO_SINGLE);
+}
+
+// Sends the opcode, the address (most significant byte first) and the dummy bytes of a command. The chip must already be selected
+// The address and dummy bytes go out on ADDRESSLINES(ioMode) lines. On more than one line the first dummy byte is the
+// mode byte of the chip, and is sent as 0xFF so that the chip does not enter continuous read mode
+void SPIMemoryTransport::_sendCommand(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode) {
+  transfer(opcode);
+  _setDataLines(ADDRESSLINES(ioMode));
+  while (addressBytes) {
+    addressBytes--;
+    transfer(address >> (8 * addressBytes));
+  }
+  while (dummyBytes--) {
+    transfer((ADDRESSLINES(ioMode) > 1) ? 0xFF : DUMMYBYTE);
+  }
+  _setDataLines(DATALINES(ioMode));
+}
+
+// Reads size bytes into data_buffer with a single read command
+//  Takes six arguments -
+//    1. opcode --> READDATA / FASTREAD
+//    2. address --> Address of the first byte to be read
+//    3. addressBytes --> 3 or 4, depending on the addressing mode of the chip
+//    4. dummyBytes --> Number of dummy bytes between the address and the data
+//    5. data_buffer --> Buffer the data is read into
+//    6. size --> Number of bytes to be read
+//    7. ioMode --> Lines used for the address and the data (SPIMEMORY_IO_*). Must match the opcode
+void SPIMemoryTransport::readData(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t *data_buffer, uint32_t size, uint8_t ioMode) {
+  select();
+  _sendCommand(opcode, address, addressBytes, dummyBytes, ioMode);
+  readBuf(data_buffer, size);
+  _setDataLines(1);
+  deselect();
+}
+
+// Programs size bytes from data_buffer with a single program command. The data must not cross a page boundary
+//  Takes six arguments -
+//    1. opcode --> PAGEPROG
+//    2. address --> Address of the first byte to be written
+//    3. addressBytes --> 3 or 4, depending on the addressing mode of the chip
+//    4. data_buffer --> Data to be written. It is not modified
+//    5. size --> Number of bytes to be written
+//    6. writeEnable --> If true, a write enable command is sent ahead of the program command
+//    7. ioMode --> Lines used for the address and the data (SPIMEMORY_IO_*). Must match the opcode
+bool SPIMemoryTransport::programPage(uint8_t opcode, uint32_t address, uint8_t addressBytes, const uint8_t *data_buffer, uint32_t size, bool writeEnable, uint8_t ioMode) {
+  if (writeEnable) {
+    select();
+    transfer(WRITEENABLE);
+    deselect();
+  }
+  select();
+  _sendCommand(opcode, address, addressBytes, 0, ioMode);
+  writeBuf(data_buffer, size);
+  _setDataLines(1);
+  deselect();
+  return true;
+}
+
+// Opens a read command (see readData() for the arguments). The data lines are left at DATALINES(ioMode) until endRead()
+void SPIMemoryTransport::beginRead(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode) {
+  select();
+  _sendCommand(opcode, address, addressBytes, dummyBytes, ioMode);
+}
+
+void SPIMemoryTransport::readNext(uint8_t *data_buffer, uint32_t size) {
+  readBuf(data_buffer, size);
+}
+
+void SPIMemoryTransport::endRead(void) {
+  _setDataLines(1);
+  deselect();
+}
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                 Arduino SPIClass based transport                   //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+
+// The pins are not touched here - the transport may be constructed before the core is ready. begin() sets them up
+SPIMemoryArduinoTransport::SPIMemoryArduinoTransport(uint8_t cs, SPIClass *spiinterface) : _settings(SPI_CLK, MSBFIRST, SPI_MODE0) {
+  _spi = spiinterface;
+  _csPin = cs;
+}
+
+bool SPIMemoryArduinoTransport::begin(void) {
+  pinMode(_csPin, OUTPUT);
+  deselect();
+  _spi->begin();
+  return true;
+}
+
+void SPIMemoryArduinoTransport::setClock(uint32_t clockSpeed) {
+  _settings = SPISettings(clockSpeed, MSBFIRST, SPI_MODE0);
+}
+
+void SPIMemoryArduinoTransport::beginTransaction(void) {
+  _spi->beginTransaction(_settings);
+}
+
+void SPIMemoryArduinoTransport::endTransaction(void) {
+  _spi->endTransaction();
+}
+
+void SPIMemoryArduinoTransport::select(void) {
+  digitalWrite(_csPin, LOW);
+}
+
+void SPIMemoryArduinoTransport::deselect(void) {
+  digitalWrite(_csPin, HIGH);
+}
+
+uint8_t SPIMemoryArduinoTransport::transfer(uint8_t data) {
+  return _spi->transfer(data);
+}
+
+uint16_t SPIMemoryArduinoTransport::transfer16(uint16_t data) {
+  return _spi->transfer16(data);
+}
+
+void SPIMemoryArduinoTransport::readBuf(uint8_t *data_buffer, uint32_t size) {
+#if defined (ARDUINO_ARCH_ESP32) || defined (ARDUINO_ARCH_NATIVE)
+  _spi->transfer(data_buffer, size);   // Whole buffer goes through the SPI FIFO in one call
+#else
+  SPIMemoryTransport::readBuf(data_buffer, size);
+#endif
+}
+
+void SPIMemoryArduinoTransport::writeBuf(const uint8_t *data_buffer, uint32_t size) {
+#if defined (ARDUINO_ARCH_ESP32) || defined (ARDUINO_ARCH_NATIVE)
+  _spi->writeBytes(data_buffer, size);   // Transmit only - the received bytes are discarded
+#else
+  SPIMemoryTransport::writeBuf(data_buffer, size);
+#endif
+}
+
+#endif
@@ -0,0 +1,93 @@
+/* Arduino SPIMemory Library v.3.4.0
+ * Copyright (C) 2019 by Prajwal Bhattaram
+ * Created by Prajwal Bhattaram - 19/05/2015
+ *
+ * This file is part of the Arduino SPIMemory Library. This library is for
+ * Flash and FRAM memory modules. In its current form it enables reading,
+ * writing and erasing data from and to various locations;
+ * suspending and resuming programming/erase and powering down for low power operation.
+ *
+ * This Library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This Library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License v3.0
+ * along with the Arduino SPIMemory Library.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SPIMEMORYTRANSPORT_H
+#define SPIMEMORYTRANSPORT_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+// The bus a memory chip is reached through. SPIFlash and SPIFram only talk to the chip through this interface
+// when SPIMEMORY_TRANSPORT is defined, so a different backend (DMA driver, host mock) can be swapped in without
+// touching the chip logic.
+//
+// Only the low level functions have to be implemented. The command sequences (readData, programPage) have default
+// implementations built from them, and a backend that can queue whole transactions should override those.
+//
+// A backend that can drive two or four data lines says so through supportsIOMode(). The default command sequences
+// then switch the bus width with _setDataLines() between the phases of a command.
+class SPIMemoryTransport {
+public:
+  virtual ~SPIMemoryTransport(void) {};
+  //----------------------------------- Bus control -------------------------------------//
+  virtual bool     begin(void) = 0;
+  virtual void     setClock(uint32_t clockSpeed) = 0;
+  virtual void     beginTransaction(void) = 0;
+  virtual void     endTransaction(void) = 0;
+  virtual void     select(void) = 0;
+  virtual void     deselect(void) = 0;
+  //---------------------------------- Data transfer ------------------------------------//
+  virtual uint8_t  transfer(uint8_t data) = 0;
+  virtual uint16_t transfer16(uint16_t data);
+  virtual void     readBuf(uint8_t *data_buffer, uint32_t size);
+  virtual void     writeBuf(const uint8_t *data_buffer, uint32_t size);
+  //-------------------------------- Command sequences ----------------------------------//
+  // Both functions frame the whole command with the chip select - they must not be called between select() and deselect()
+  virtual bool     supportsIOMode(uint8_t ioMode);
+  virtual void     readData(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t *data_buffer, uint32_t size, uint8_t ioMode = SPIMEMORY_IO_SINGLE);
+  virtual bool     programPage(uint8_t opcode, uint32_t address, uint8_t addressBytes, const uint8_t *data_buffer, uint32_t size, bool writeEnable, uint8_t ioMode = SPIMEMORY_IO_SINGLE);
+  // A read that is consumed in pieces: beginRead() selects the chip and sends the command, every readNext() carries on
+  // where the last one stopped, and endRead() deselects the chip. Nothing else may be sent in between
+  virtual void     beginRead(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode = SPIMEMORY_IO_SINGLE);
+  virtual void     readNext(uint8_t *data_buffer, uint32_t size);
+  virtual void     endRead(void);
+
+protected:
+  virtual void     _setDataLines(uint8_t /*lines*/) {};
+  void     _sendCommand(uint8_t opcode, uint32_t address, uint8_t addressBytes, uint8_t dummyBytes, uint8_t ioMode = SPIMEMORY_IO_SINGLE);
+};
+
+// Backend built on the Arduino SPIClass of the core. This is what the library has always used. SPIClass has one data
+// line each way, so only SPIMEMORY_IO_SINGLE is supported
+class SPIMemoryArduinoTransport : public SPIMemoryTransport {
+public:
+  SPIMemoryArduinoTransport(uint8_t cs = CS, SPIClass *spiinterface = &SPI);
+  bool     begin(void);
+  void     setClock(uint32_t clockSpeed);
+  void     beginTransaction(void);
+  void     endTransaction(void);
+  void     select(void);
+  void     deselect(void);
+  uint8_t  transfer(uint8_t data);
+  uint16_t transfer16(uint16_t data);
+  void     readBuf(uint8_t *data_buffer, uint32_t size);
+  void     writeBuf(const uint8_t *data_buffer, uint32_t size);
+
+private:
+  SPIClass *_spi;
+  SPISettings _settings;
+  uint8_t  _csPin;
+};
+
+#endif // _SPIMEMORYTRANSPORT_H_
@@ -41,8 +41,15 @@
    #define xfer(n)   SPI.transfer(n)
    #define BEGIN_SPI SPI.begin();
 
+ // Everything goes through the SPIMemoryTransport of the instance (see SPIMemoryTransport.h)
+ #elif defined (SPIMEMORY_TRANSPORT)
+   #define CHIP_SELECT   _bus->select();
+   #define CHIP_DESELECT _bus->deselect();
+   #define xfer(n)   _bus->transfer(n)
+   #define BEGIN_SPI _bus->begin();
+
  // Defines and variables specific to SAMD architecture
- #elif defined (ARDUINO_ARCH_SAMD) || defined(ARCH_STM32)|| defined(ARDUINO_ARCH_ESP32)
+ #elif defined (ARDUINO_ARCH_SAMD) || defined(ARCH_STM32)
    #define CHIP_SELECT   digitalWrite(csPin, LOW);
    #define CHIP_DESELECT digitalWrite(csPin, HIGH);
    #define xfer(n)   _spi->transfer(n)
@@ -95,6 +102,124 @@
 #define READSFDP      0x5A
 #define UNIQUEID      0x4B
 #define FRAMSERNO     0xC3
+#define FASTREAD_DUAL   0x3B  // Fast Read Dual Output (1-1-2)
+#define FASTREAD_QUAD   0x6B  // Fast Read Quad Output (1-1-4)
+#define FASTREAD_QUADIO 0xEB  // Fast Read Quad I/O (1-4-4)
+#define PAGEPROG_QUAD   0x32  // Quad Input Page Program (1-1-4)
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                             I/O modes                              //
+//     High nibble = lines used for the address, low nibble = lines   //
+//         used for the data. The instruction is always on one        //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_IO_AUTO     0x00    // Widest mode supported by both the chip and the transport
+#define SPIMEMORY_IO_SINGLE   0x11
+#define SPIMEMORY_IO_DUAL     0x12
+#define SPIMEMORY_IO_QUAD     0x14
+#define SPIMEMORY_IO_QUADIO   0x44
+#define ADDRESSLINES(x)       ((x) >> 4)
+#define DATALINES(x)          ((x) & 0x0F)
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                         Busy wait strategy                         //
+//   Operations statistics are kept for (see SPIFlash::getWaitStats)  //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_WAIT_PROGRAM    0x00
+#define SPIMEMORY_WAIT_ERASE4K    0x01
+#define SPIMEMORY_WAIT_ERASE32K   0x02
+#define SPIMEMORY_WAIT_ERASE64K   0x03
+#define SPIMEMORY_WAIT_CHIPERASE  0x04
+#define SPIMEMORY_WAIT_OTHER      0x05    // Status register writes, or an operation of unknown type
+#define SPIMEMORY_WAIT_TYPES      6
+#define SPIMEMORY_POLL_MIN_US     10      // First status poll interval once the expected time is up
+#define SPIMEMORY_POLL_MAX_US     2000    // The poll interval doubles up to this
+// Typical times from the Winbond W25Q datasheets, used when the chip's SFDP table has not been read
+#define SPIMEMORY_TYP_BYTEPROG_US     30        // tBP1
+#define SPIMEMORY_TYP_PAGEPROG_US     400       // tPP
+#define SPIMEMORY_TYP_ERASE4K_US      45000L    // tSE
+#define SPIMEMORY_TYP_ERASE32K_US     120000L   // tBE1
+#define SPIMEMORY_TYP_ERASE64K_US     150000L   // tBE2
+#define SPIMEMORY_TYP_CHIPERASE_US    10000000L // tCE
+// ... and the worst case ones
+#define SPIMEMORY_MAX_ERASE4K_US      400000L   // tSE
+#define SPIMEMORY_MAX_ERASE32K_US     1600000L  // tBE1
+#define SPIMEMORY_MAX_ERASE64K_US     2000000L  // tBE2
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                      Erase suspend for reads                       //
+//     How reads get past an erase started by erase*Async() (see      //
+//                     SPIFlash::setReadSuspend)                      //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_SUSPEND_MIN_RUN_US  500     // Least time an erase runs after a resume before it is suspended again
+#define SPIMEMORY_SUSPEND_TIMEOUT_US  100     // tSUS is 20 us on the W25Q
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                       Write-combining buffer                       //
+//                     (see SPIFlashWriteBuffer)                      //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_WRITEBUFFER_TIMEOUT_MS  1000    // Longest time a page stays staged, if poll() is called
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                             Read cache                             //
+//                    (see SPIFlash::setReadCache)                    //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_CACHE_LINE            256         // Bytes per line - a power of two from a page to a 4 KB sector
+#define SPIMEMORY_CACHE_READAHEAD       1           // Lines read past a miss that carries on from the last line read
+#define SPIMEMORY_CACHE_MAX_READAHEAD   15          // Most lines setReadCache() allows to be read past a miss
+#define SPIMEMORY_CACHE_EMPTY           0xFFFFFFFF  // Tag of a slot that holds nothing
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                          Auto power-down                           //
+//                 (see SPIFlash::setAutoPowerDown)                   //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_TDP_US            3           // Power-down instruction to power-down mode (tDP)
+#define SPIMEMORY_TRES1_US          3           // Release from power-down to the next command (tRES1)
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                          Striped volumes                           //
+//                      (see SPIFlashVolume.h)                        //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_VOLUME_MAX_CHIPS  4           // Chips one SPIFlashVolume can stripe across
+#define SPIMEMORY_VOLUME_VEC        16          // Pages a chip reads per command for a volume read - on the stack
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                              Strings                               //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_STR_CHUNK         64          // Bytes readStr() reads into a String at a time - on the stack
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                       Write verify policies                        //
+//   What errorCheck = true reads back (see SPIFlash::setVerifyPolicy) //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_VERIFY_OFF      0x00    // Nothing is read back
+#define SPIMEMORY_VERIFY_FULL     0x01    // The range is read back and compared byte for byte (default)
+#define SPIMEMORY_VERIFY_SAMPLED  0x02    // As FULL, but only the pages whose number is a multiple of the sample interval
+#define SPIMEMORY_VERIFY_CHUNK    256     // Bytes read back per bulk read
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                          Runtime policies                          //
+//   Per instance, see SPIFlash::setPolicy() and SPIFlashPolicy. The  //
+//      HIGHSPEED and DISABLEOVERFLOW build flags set the default     //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_POLICY_SAFE        0x00    // Checks that the range is blank before writing, and rolls over to 0x00 at the end of the chip
+#define SPIMEMORY_POLICY_HIGHSPEED   0x01    // No _notPrevWritten() readback. The sectors must have been erased beforehand
+#define SPIMEMORY_POLICY_NOOVERFLOW  0x02    // Accesses past the end of the chip fail with OUTOFBOUNDS instead of rolling over
+#if defined (HIGHSPEED) && defined (DISABLEOVERFLOW)
+  #define SPIMEMORY_POLICY_DEFAULT   (SPIMEMORY_POLICY_HIGHSPEED | SPIMEMORY_POLICY_NOOVERFLOW)
+#elif defined (HIGHSPEED)
+  #define SPIMEMORY_POLICY_DEFAULT   SPIMEMORY_POLICY_HIGHSPEED
+#elif defined (DISABLEOVERFLOW)
+  #define SPIMEMORY_POLICY_DEFAULT   SPIMEMORY_POLICY_NOOVERFLOW
+#else
+  #define SPIMEMORY_POLICY_DEFAULT   SPIMEMORY_POLICY_SAFE
+#endif
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+//                       Cached chip parameters                       //
+//   Bump the version whenever SPIFlash::chipParams or what goes in   //
+//     it changes, so that records saved by older builds are redone   //
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
+#define SPIMEMORY_CHIPPARAMS_VERSION  0x01
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 //                     General size definitions                       //
@@ -126,20 +251,40 @@
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 #define SFDP_HEADER_ADDR 0x00
 #define SFDP_SIGNATURE_DWORD 0x01
-#define SFDP_NPH_DWORD 0x02
-#define SFDP_NPH_BYTE 0x03
-#define SFDP_PARAM_TABLE_LENGTH_DWORD 0x01
-#define SFDP_PARAM_TABLE_LENGTH_BYTE 0x04
-#define SFDP_BASIC_PARAM_TABLE_HDR_ADDR 0x08
-#define SFDP_BASIC_PARAM_TABLE_NO 0x01
+#define SFDP_NPH_OFFSET 0x06                  // Byte of the SFDP header with the number of parameter headers
+#define SFDP_HEADER_LENGTH 0x08               // Bytes in the SFDP header, and in each parameter header
+#define SFDP_PARAM_ID_LSB_OFFSET 0x00
+#define SFDP_PARAM_LENGTH_OFFSET 0x03         // In DWORDs
+#define SFDP_PARAM_POINTER_OFFSET 0x04
+#define SFDP_PARAM_ID_MSB_OFFSET 0x07
+#define SFDP_BASIC_PARAM_TABLE_ID 0xFF00
+#define SFDP_SECTOR_MAP_PARAM_TABLE_ID 0xFF81
+#define SFDP_FASTREAD_MODES_DWORD 0x01
 #define SFDP_MEMORY_DENSITY_DWORD 0x02
-#define SFDP_SECTOR_MAP_PARAM_TABLE_NO 0x02
-#define SFDP_ERASE1_BYTE 0x01
+#define SFDP_FASTREAD_QUAD_DWORD 0x03
+#define SFDP_FASTREAD_DUAL_DWORD 0x04
 #define SFDP_ERASE1_INSTRUCTION_DWORD 0x08
 #define SFDP_ERASE2_INSTRUCTION_DWORD 0x09
 #define SFDP_SECTOR_ERASE_TIME_DWORD 0x0A
 #define SFDP_CHIP_ERASE_TIME_DWORD 0x0B
 #define SFDP_PROGRAM_TIME_DWORD 0x0B
+#define SFDP_QE_DWORD 0x0F
+#define SFDP_SUPPORTS_112 0x00010000          // DWORD 1 fast read support bits
+#define SFDP_SUPPORTS_144 0x00200000
+#define SFDP_SUPPORTS_114 0x00400000
+#define SFDP_QE_SR2_WRITESTAT2 0x04           // QE is bit 1 of status register 2, written with 31h
+#define SFDP_MAP_DESCRIPTOR 0x02              // Sector map descriptor DWORD 1 bits
+#define SFDP_LAST_DESCRIPTOR 0x01
+#define SFDP_ALL_ERASE_TYPES 0x0F
+// How much of the SFDP area begin() reads - one burst each, on the stack
+#define SFDP_MAX_PARAM_HEADERS 8
+#define SFDP_BASIC_PARAM_TABLE_MAX_DWORDS 16  // JESD216B - the library does not use the later DWORDs
+#define SFDP_SECTOR_MAP_MAX_DWORDS 32
+// What _getSFDPIOModes() found (SPIFlash::_sfdpIOModes)
+#define SFDP_IO_DUAL 0x01
+#define SFDP_IO_QUAD 0x02
+#define SFDP_IO_QUADIO 0x04
+#define SFDP_IO_QE 0x08
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 //					Chip specific instructions 						  //
@@ -188,7 +333,7 @@
 #define BUSY          0x01
 #define STDSPI        0x0A
 #define ALTSPI     0x0B
-#if defined (ARDUINO_ARCH_ESP32)
+#if defined (ARDUINO_ARCH_ESP32) || defined (ARDUINO_ARCH_NATIVE)
 #define SPI_CLK       20000000        //Hz equivalent of 20MHz
 #else
 #define SPI_CLK       104000000       //Hz equivalent of 104MHz
@@ -196,6 +341,7 @@
 #define ENFASTREAD    0x01
 #define WRTEN         0x02
 #define SUS           0x80
+#define QE            0x02            // Quad Enable in Status register 2
 #define WSE           0x04
 #define WSP           0x08
 #define ADS           0x01            // Current Address mode in Status register 3
@@ -26,7 +26,6 @@
  #ifndef DIAGNOSTICS_H
  #define DIAGNOSTICS_H
 
- #include "SPIMemory.h"
  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
  //                       List of Error codes                          //
  //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
@@ -55,6 +54,9 @@
   #define UNKNOWNERROR            0xFE
   //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~//
 
+ // After the error codes - SPIFlashT.h, which SPIMemory.h pulls in, uses them
+ #include "SPIMemory.h"
+
  class Diagnostics {
  public:
    //------------------------------------ Constructor ------------------------------------//
@@ -1,6 +1,8 @@
 #include "SerialBT_Commander.h"
 #include <stdarg.h>
 
+#define BT_STRING_MAX  256  // Longest string the read command shows - read into a buffer on the stack
+
 SerialBT_Commander::SerialBT_Commander(const char* deviceName) 
     : btDeviceName(deviceName), commandBuffer("") {
 }
@@ -52,7 +54,7 @@ void SerialBT_Commander::printMenu() {
     println("  read <addr>            - Read string from address (hex)");
     println("  readb <addr> <len>     - Read bytes (e.g., readb 1000 16)");
     println("  readrange <start> <end> - Read address range (hex)");
-    println("  readall                - Dump entire flash (4MB!)");
+    println("  readall                - Dump entire flash (whole volume!)");
     println("  stop                   - Stop readall operation");
     println("");
     println("Erase Commands:");
@@ -67,6 +69,7 @@ void SerialBT_Commander::printMenu() {
     println("  ringstatus             - Show ring buffer position");
     println("  ringsetpos <addr>      - Set ring buffer position");
     println("  ringreset              - Reset ring buffer to 0x00000000");
+    println("  ringahead <n>          - Keep n erased sectors ahead of writes");
     println("");
     println("Auto-Write Commands:");
     println("  autostart              - Start auto-writing vehicle data");
@@ -136,13 +139,16 @@ void SerialBT_Commander::handleWriteBytesCommand(String args) {
 void SerialBT_Commander::handleReadCommand(String args) {
     if (args.length() > 0) {
         uint32_t addr = parseHex(args);
-        String data = "";
+        char data[BT_STRING_MAX + 1];
+        uint32_t length;
         
         printf("[BT] Reading string from 0x%08X\n", addr);
         
         flashRingBufferPause();
-        if (flashReadString(addr, data)) {
-            printf("[BT] Result: %s\n", data.c_str());
+        if (flashReadString(addr, data, sizeof(data), length)) {
+            printf("[BT] Result: %s\n", data);
+        } else if (length > BT_STRING_MAX) {
+            printf("[BT] ✗ String is %u characters - longer than %u\n", length, BT_STRING_MAX);
         } else {
             println("[BT] ✗ Read failed");
         }
@@ -264,15 +270,63 @@ void SerialBT_Commander::handleInfoCommand() {
     if (flashInitialized) {
         xSemaphoreTake(spiMutex, portMAX_DELAY);
         uint32_t jedecID = flash.getJEDECID();
-        uint32_t capacity = flash.getCapacity();
-        uint16_t maxPages = flash.getMaxPage();
+        uint32_t capacity = flashVolume.getCapacity();
+        uint32_t maxPages = flashVolume.getMaxPage();
+        uint8_t chips = flashVolume.getChipCount();
+        
+        // Statistics are kept per chip - added up over the volume
+        SPIFlash::waitStats waits[SPIMEMORY_WAIT_TYPES] = {};
+        SPIFlash::cacheStats cache = {};
+        SPIFlash::powerStats power = {};
+        for (uint8_t c = 0; c < chips; c++) {
+            SPIFlash* chip = flashVolume.getChip(c);
+            for (uint8_t i = 0; i < SPIMEMORY_WAIT_TYPES; i++) {
+                SPIFlash::waitStats chipWaits = chip->getWaitStats(i);
+                waits[i].waits += chipWaits.waits;
+                waits[i].polls += chipWaits.polls;
+                waits[i].waitTime += chipWaits.waitTime;
+                if (chipWaits.maxWaitTime > waits[i].maxWaitTime) waits[i].maxWaitTime = chipWaits.maxWaitTime;
+                waits[i].yieldTime += chipWaits.yieldTime;
+            }
+            SPIFlash::cacheStats chipCache = chip->getCacheStats();
+            cache.hits += chipCache.hits;
+            cache.misses += chipCache.misses;
+            cache.readAheads += chipCache.readAheads;
+            SPIFlash::powerStats chipPower = chip->getPowerStats();
+            power.powerDowns += chipPower.powerDowns;
+            power.wakeUps += chipPower.wakeUps;
+            power.wakeTime += chipPower.wakeTime;
+            if (chipPower.maxWakeTime > power.maxWakeTime) power.maxWakeTime = chipPower.maxWakeTime;
+            power.timeAsleep += chipPower.timeAsleep;
+        }
         xSemaphoreGive(spiMutex);
         
         println("\n[INFO] Flash Chip Information:");
         printf("  JEDEC ID: 0x%08X\n", jedecID);
+        printf("  Chips: %u (pages striped across them)\n", chips);
         printf("  Capacity: %u bytes (%.2f MB)\n", capacity, capacity / 1048576.0);
         printf("  Max Pages: %u\n", maxPages);
         printf("  Sector Size: %u bytes\n", FLASH_SECTOR_SIZE);
+        
+        // Busy waits per operation - "yielded" is the CPU time other tasks got back
+        static const char* waitNames[SPIMEMORY_WAIT_TYPES] = {"Program", "4K erase", "32K erase", "64K erase", "Chip erase", "Other"};
+        println("  Busy waits:");
+        for (uint8_t i = 0; i < SPIMEMORY_WAIT_TYPES; i++) {
+            if (waits[i].waits == 0) continue;
+            printf("    %-10s %u waits, %u polls, %u us total, %u us max, %u us yielded (%u%%)\n",
+                   waitNames[i], waits[i].waits, waits[i].polls, waits[i].waitTime, waits[i].maxWaitTime,
+                   waits[i].yieldTime, waits[i].waitTime ? (uint32_t)((uint64_t)waits[i].yieldTime * 100 / waits[i].waitTime) : 0);
+        }
+
+        // Lines are pages - "read ahead" pages came in with the miss before them
+        uint32_t lookups = cache.hits + cache.misses;
+        printf("  Read cache: %u hits, %u misses, %u read ahead (%u%% hits)\n",
+               cache.hits, cache.misses, cache.readAheads, lookups ? (uint32_t)((uint64_t)cache.hits * 100 / lookups) : 0);
+
+        // Deep power-downs while idle, and what waking up for the next command cost
+        printf("  Power-down: %u times, %u ms asleep, %u wake-ups (%u us avg, %u us max)\n",
+               power.powerDowns, power.timeAsleep, power.wakeUps,
+               power.wakeUps ? power.wakeTime / power.wakeUps : 0, power.maxWakeTime);
     } else {
         println("[ERROR] Flash not initialized!");
     }
@@ -341,6 +395,9 @@ void SerialBT_Commander::processCommand(String cmd) {
     else if (command == "ringreset") {
         handleRingResetCommand();
     }
+    else if (command == "ringahead") {
+        handleRingAheadCommand(args);
+    }
     else if (command == "autostart") {
         handleAutoStartCommand();
     }
@@ -354,7 +411,7 @@ void SerialBT_Commander::processCommand(String cmd) {
 }
 
 void SerialBT_Commander::handleReadAllCommand() {
-    println("[BT] Starting full flash dump (4MB)...");
+    println("[BT] Starting full flash dump...");
     println("[BT] This will take several minutes...");
     println("[BT] Send 'stop' command to abort");
     println("[BT] Ring buffer writes paused during read\n");
@@ -363,57 +420,65 @@ void SerialBT_Commander::handleReadAllCommand() {
     flashRingBufferPause();
     
     // Redirect output through Bluetooth
-    uint8_t buffer[256];
-    uint32_t totalBytes = 0;
-    const uint32_t FLASH_SIZE = 4194304;
-    bool stopped = false;
+    struct {
+        SerialBT_Commander* commander;
+        uint32_t size;
+        uint32_t totalBytes;
+        bool stopped;
+    } dump = {this, flashVolume.getCapacity(), 0, false};
     
     println("\n========== FLASH MEMORY DUMP START ==========");
-    printf("Total Size: %u bytes (4.00 MB)\n", FLASH_SIZE);
+    printf("Total Size: %u bytes (%.2f MB)\n", dump.size, dump.size / 1048576.0);
     println("Format: [Address] Data (16 bytes per line)");
     println("=============================================\n");
     
-    for (uint32_t addr = 0; addr < FLASH_SIZE; addr += 256) {
+    // The flash is streamed 256 bytes at a time - returning false stops the read.
+    // Chunks arrive with the SPI mutex already released, so printing may block.
+    auto printChunk = [](uint32_t addr, const uint8_t* data, uint32_t size, void* context) -> bool {
+        auto* state = (decltype(dump)*)context;
+        SerialBT_Commander* self = state->commander;
+        
         // Check for stop command
-        if (SerialBT.available()) {
-            String cmd = SerialBT.readStringUntil('\n');
+        if (self->SerialBT.available()) {
+            String cmd = self->SerialBT.readStringUntil('\n');
             cmd.trim();
             cmd.toLowerCase();
             if (cmd == "stop") {
-                stopped = true;
-                println("\n[BT] ✓ Read operation stopped by user");
-                break;
+                state->stopped = true;
+                self->println("\n[BT] ✓ Read operation stopped by user");
+                return false;
             }
         }
         
-        if (!flashRead(addr, buffer, 256)) {
-            printf("[ERROR] Failed to read at 0x%08X\n", addr);
-            break;
-        }
-        
         // Print in hex format
-        for (size_t i = 0; i < 256; i++) {
+        for (uint32_t i = 0; i < size; i++) {
             if ((addr + i) % 16 == 0) {
-                if (i > 0) println("");
-                printf("[%08X] ", addr + i);
+                if (state->totalBytes > 0) self->println("");
+                self->printf("[%08X] ", addr + i);
             }
-            printf("%02X ", buffer[i]);
-            totalBytes++;
+            self->printf("%02X ", data[i]);
+            state->totalBytes++;
         }
         
         // Progress every 64KB
-        if ((addr % (64 * 1024)) == 0 && addr > 0) {
-            printf("\n[PROGRESS] %u%% - %u KB\n", 
-                  (addr * 100) / FLASH_SIZE, addr / 1024);
+        uint32_t end = addr + size;
+        if ((end % (64 * 1024)) == 0 && end < state->size) {
+            self->printf("\n[PROGRESS] %u%% - %u KB\n", 
+                  (uint32_t)((uint64_t)end * 100 / state->size), end / 1024);
         }
         
-        delay(10); // Prevent watchdog and allow BT buffer to flush
+        delay(10); // Allow BT buffer to flush
+        return true;
+    };
+    
+    if (!flashReadStream(0, dump.size, printChunk, &dump, 256) && !dump.stopped) {
+        printf("[ERROR] Failed to read at 0x%08X\n", dump.totalBytes);
     }
     
-    if (!stopped) {
+    if (!dump.stopped) {
         println("\n\n========== FLASH MEMORY DUMP COMPLETE ==========");
     }
-    printf("Total bytes read: %u (%.2f MB)\n", totalBytes, totalBytes / 1048576.0);
+    printf("Total bytes read: %u (%.2f MB)\n", dump.totalBytes, dump.totalBytes / 1048576.0);
     println("================================================\n");
     
     // Resume ring buffer writes
@@ -500,9 +565,15 @@ void SerialBT_Commander::handleRingStatusCommand() {
         printf("  Current sector: %u\n", sector);
         printf("  Status: %s\n", paused ? "PAUSED" : "ACTIVE");
         printf("  Auto-write: %s\n", autoWrite ? "ENABLED" : "DISABLED");
+        
+        uint32_t p50, p99, maxLatency;
+        uint16_t writes = flashRingBufferLatency(p50, p99, maxLatency);
+        printf("  Erase-ahead: %u sectors\n", flashRingBufferGetEraseAhead());
+        printf("  Write latency (last %u): p50 %u us, p99 %u us, max %u us\n", writes, p50, p99, maxLatency);
+        printf("  Writes stalled by an erase: %u\n", flashRingBufferEraseStalls());
     }
     
-    printf("  Flash capacity: 0x%08X (4.00 MB)\n", 4194304);
+    printf("  Flash capacity: 0x%08X (%.2f MB)\n", flashVolume.getCapacity(), flashVolume.getCapacity() / 1048576.0);
     printf("  Sector size: 0x%08X (%u bytes)\n", FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
 }
 
@@ -529,6 +600,20 @@ void SerialBT_Commander::handleRingResetCommand() {
     println("[BT] ✓ Ring buffer reset to 0x00000000");
 }
 
+void SerialBT_Commander::handleRingAheadCommand(String args) {
+    if (args.length() > 0) {
+        long sectors = args.toInt();
+        if (sectors < 0 || sectors > 255) {
+            println("[BT] ✗ Erase-ahead must be 0-255 sectors");
+            return;
+        }
+        flashRingBufferSetEraseAhead(sectors);
+        printf("[BT] ✓ Keeping %u erased sectors ahead of writes\n", flashRingBufferGetEraseAhead());
+    } else {
+        println("[ERROR] Usage: ringahead <sectors>");
+    }
+}
+
 void SerialBT_Commander::handleAutoStartCommand() {
     if (!ringBufferInitialized) {
         println("[BT] ✗ Ring buffer not initialized!");
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include <SPI.h>
+#include <algorithm>
 #include <SPIMemory.h>
 #include "SerialBT_Commander.h"
 
@@ -8,12 +9,71 @@
 #define SPI_FLASH_MISO  12
 #define SPI_FLASH_MOSI  13
 #define SPI_FLASH_CS    26
+#define SPI_FLASH_CS1   27  // Chip selects of the further chips of the volume (see FLASH_CHIP_COUNT)
+#define SPI_FLASH_CS2   32
+#define SPI_FLASH_CS3   33
 
 // Flash memory constants
-const uint32_t FLASH_SECTOR_SIZE = 4096;
-#define FLASH_TOTAL_SIZE  4194304  // 4MB (W25Q32)
+#define FLASH_CHIP_COUNT  1        // W25Q32 chips on the bus, striped page by page into one volume (1 to 4)
+#define FLASH_CHIP_SIZE   4194304  // 4MB (W25Q32)
+const uint32_t FLASH_SECTOR_SIZE = 4096 * FLASH_CHIP_COUNT;  // Smallest erase - the same 4 KB sector on every chip
+const uint32_t FLASH_PAGE_SIZE = 256;
+#define FLASH_TOTAL_SIZE  (FLASH_CHIP_SIZE * FLASH_CHIP_COUNT)
+#define FLASH_READ_CACHE_LINES  16  // Pages kept in RAM by the read cache (0 --> every read goes to the chip)
+#define FLASH_READ_AHEAD        2   // Pages read past a miss that carries on from the last page read
+#define FLASH_AUTO_POWER_DOWN_MS  2000  // Idle time before the flash goes into deep power-down (0 --> never)
+#define FLASH_IDLE_CHECK_MS       500   // How often loop() checks for it
 
-SPIFlash flash(SPI_FLASH_CS);
+#if defined (ARDUINO_ARCH_NATIVE)
+#include <NativeSPITransport.h>
+
+// Host build: the SPI model also has the dual/quad data lines, which the
+// Arduino transport of the library does not drive (see lib/NativeBoard)
+NativeSPITransport flashBus(SPI_FLASH_CS);
+NativeSPITransport flashBus1(SPI_FLASH_CS1);
+NativeSPITransport flashBus2(SPI_FLASH_CS2);
+NativeSPITransport flashBus3(SPI_FLASH_CS3);
+#define FLASH_BUS(bus, cs)  bus
+#else
+#define FLASH_BUS(bus, cs)  cs
+#endif
+
+SPIFlashT<W25Q32JV> flash(FLASH_BUS(flashBus, SPI_FLASH_CS));
+#if FLASH_CHIP_COUNT > 1
+SPIFlashT<W25Q32JV> flash1(FLASH_BUS(flashBus1, SPI_FLASH_CS1));
+#endif
+#if FLASH_CHIP_COUNT > 2
+SPIFlashT<W25Q32JV> flash2(FLASH_BUS(flashBus2, SPI_FLASH_CS2));
+#endif
+#if FLASH_CHIP_COUNT > 3
+SPIFlashT<W25Q32JV> flash3(FLASH_BUS(flashBus3, SPI_FLASH_CS3));
+#endif
+
+// All data goes through the volume - with one chip it is just that chip, with
+// more, consecutive pages go to consecutive chips so that they program side by side.
+// Each chip's begin() checks its device ID and sets its worst case busy times,
+// which bound every wait the volume makes on it
+SPIFlashT<W25Q32JV>* flashChips[FLASH_CHIP_COUNT] = {
+  &flash,
+#if FLASH_CHIP_COUNT > 1
+  &flash1,
+#endif
+#if FLASH_CHIP_COUNT > 2
+  &flash2,
+#endif
+#if FLASH_CHIP_COUNT > 3
+  &flash3,
+#endif
+};
+const uint8_t flashChipSelects[] = {SPI_FLASH_CS, SPI_FLASH_CS1, SPI_FLASH_CS2, SPI_FLASH_CS3};
+SPIFlashVolume flashVolume(flashChips, FLASH_CHIP_COUNT);
+
+#if defined (ARDUINO_ARCH_NATIVE)
+#include <W25Q32Emulator.h>
+
+// Host build: every flash chip is a W25Q32JV model on the SPI bus (see lib/NativeBoard)
+W25Q32Emulator flashChip[FLASH_CHIP_COUNT];
+#endif
 
 // Task handles
 TaskHandle_t monitorTaskHandle = NULL;
@@ -183,7 +243,7 @@ bool flashWrite(uint32_t address, const uint8_t* data, size_t length) {
   }
   
   xSemaphoreTake(spiMutex, portMAX_DELAY);
-  bool success = flash.writeByteArray(address, (uint8_t*)data, length);
+  bool success = flashVolume.writeByteArray(address, (uint8_t*)data, length);
   xSemaphoreGive(spiMutex);
   
   return success;
@@ -201,8 +261,7 @@ bool flashWriteString(uint32_t address, const String& str) {
   }
   
   xSemaphoreTake(spiMutex, portMAX_DELAY);
-  String tempStr = str;
-  bool success = flash.writeStr(address, tempStr);
+  bool success = flashVolume.writeStr(address, str.c_str(), str.length());
   xSemaphoreGive(spiMutex);
   
   return success;
@@ -226,7 +285,7 @@ bool flashRead(uint32_t address, uint8_t* buffer, size_t length) {
   }
   
   xSemaphoreTake(spiMutex, portMAX_DELAY);
-  bool success = flash.readByteArray(address, buffer, length);
+  bool success = flashVolume.readByteArray(address, buffer, length);
   xSemaphoreGive(spiMutex);
   
   return success;
@@ -244,20 +303,102 @@ bool flashReadString(uint32_t address, String& str) {
   }
   
   xSemaphoreTake(spiMutex, portMAX_DELAY);
-  bool success = flash.readStr(address, str);
+  bool success = flashVolume.readStr(address, str);
+  xSemaphoreGive(spiMutex);
+  
+  return success;
+}
+
+/**
+ * @brief Read a string from flash memory into a buffer, without a String
+ * @param address Starting address to read
+ * @param buffer Filled with the string and its null terminator
+ * @param size Size of buffer
+ * @param length Set to the length of the string - also when it does not fit
+ * in buffer, 0 if there is no string at address
+ * @return true if successful, false otherwise
+ */
+bool flashReadString(uint32_t address, char* buffer, size_t size, uint32_t& length) {
+  length = 0;
+  if (!flashInitialized) {
+    return false;
+  }
+  
+  xSemaphoreTake(spiMutex, portMAX_DELAY);
+  bool success = flashVolume.readStr(address, buffer, size, &length);
   xSemaphoreGive(spiMutex);
   
   return success;
 }
 
+#define FLASH_PROGRESS_STEP  (64 * 1024)  // Bytes between flashReadAll() progress lines
+
+/**
+ * @brief Stream a flash range to a callback, one chunk at a time
+ * Each chunk is read into a buffer while holding the SPI mutex - with one chip as a
+ * single read command, striped over several with one read command per chip - without
+ * going through the read cache. The mutex is released (and chip select deasserted)
+ * before the callback runs, so a slow consumer such as a Bluetooth dump never holds
+ * the bus. The task yields between chunks to let other tasks in and feed the watchdog.
+ * @param address Starting address to read
+ * @param length Number of bytes to read
+ * @param callback Called for every chunk - return false to stop the read
+ * @param context Passed on to the callback
+ * @param chunkSize Bytes read per mutex hold and handed to the callback at a time
+ * @return true if the whole range was read, false on error or if stopped
+ */
+bool flashReadStream(uint32_t address, size_t length, SPIFlash::streamCallback callback, void* context, size_t chunkSize) {
+  if (!flashInitialized || callback == NULL || chunkSize == 0) {
+    return false;
+  }
+  
+  if (address + length > FLASH_TOTAL_SIZE) {
+    Serial.println("[ERROR] Read address out of bounds");
+    return false;
+  }
+  
+  uint8_t* chunk = (uint8_t*)malloc(chunkSize);
+  if (chunk == NULL) {
+    Serial.println("[ERROR] Failed to allocate memory!");
+    return false;
+  }
+  
+  // The volume hands the whole chunk over in one go - it is consumed after the mutex is released
+  auto keepChunk = [](uint32_t, const uint8_t*, uint32_t, void*) -> bool { return true; };
+  
+  bool success = true;
+  while (length > 0 && success) {
+    size_t size = (length < chunkSize) ? length : chunkSize;
+    
+    xSemaphoreTake(spiMutex, portMAX_DELAY);
+    success = flashVolume.readStream(address, size, chunk, size, keepChunk, NULL);
+    xSemaphoreGive(spiMutex);
+    
+    if (success) {
+      success = callback(address, chunk, size, context);
+    }
+    
+    address += size;
+    length -= size;
+    
+    // Yield point between chunks
+    vTaskDelay(1);
+  }
+  
+  free(chunk);
+  return success;
+}
+
 /**
  * @brief Read entire flash memory contents
- * @param buffer Buffer to store all data (must be FLASH_TOTAL_SIZE bytes)
+ * The chip is streamed to the consumer rather than copied into a 4MB buffer
+ * @param consumer Called for every chunk - return false to stop the read
+ * @param context Passed on to the consumer
  * @param printProgress Print progress to serial (default: true)
  * @return true if successful, false otherwise
  */
-bool flashReadAll(uint8_t* buffer, bool printProgress = true) {
-  if (!flashInitialized || buffer == NULL) {
+bool flashReadAll(SPIFlash::streamCallback consumer, void* context, bool printProgress = true) {
+  if (!flashInitialized || consumer == NULL) {
     return false;
   }
   
@@ -265,42 +406,60 @@ bool flashReadAll(uint8_t* buffer, bool printProgress = true) {
     Serial.println("[INFO] Reading entire flash memory...");
   }
   
-  const size_t chunkSize = 256;
-  for (uint32_t addr = 0; addr < FLASH_TOTAL_SIZE; addr += chunkSize) {
-    if (!flashRead(addr, &buffer[addr], chunkSize)) {
+  bool success = true;
+  for (uint32_t addr = 0; addr < FLASH_TOTAL_SIZE && success; addr += FLASH_PROGRESS_STEP) {
+    success = flashReadStream(addr, FLASH_PROGRESS_STEP, consumer, context);
+    if (!success) {
       Serial.printf("[ERROR] Failed to read at address 0x%08X\n", addr);
-      return false;
     }
-    
-    if (printProgress && (addr % (64 * 1024)) == 0) {
-      Serial.printf("[PROGRESS] %d%% complete\n", (addr * 100) / FLASH_TOTAL_SIZE);
+    else if (printProgress) {
+      Serial.printf("[PROGRESS] %d%% complete\n", ((addr + FLASH_PROGRESS_STEP) * 100) / FLASH_TOTAL_SIZE);
     }
   }
   
-  if (printProgress) {
+  if (success && printProgress) {
     Serial.println("[INFO] Read complete!");
   }
   
+  return success;
+}
+
+/**
+ * @brief Print a chunk of flash data in hex, 16 bytes per line (flashReadStream callback)
+ * @param context Points to the running byte count
+ */
+static bool dumpChunk(uint32_t address, const uint8_t* data, uint32_t size, void* context) {
+  uint32_t* totalBytes = (uint32_t*)context;
+  
+  for (uint32_t i = 0; i < size; i++) {
+    if ((address + i) % 16 == 0) {
+      if (*totalBytes > 0) Serial.println();
+      Serial.printf("[%08X] ", address + i);
+    }
+    Serial.printf("%02X ", data[i]);
+    (*totalBytes)++;
+  }
+  
+  // Progress update every 64KB
+  uint32_t end = address + size;
+  if ((end % (64 * 1024)) == 0 && end < FLASH_TOTAL_SIZE) {
+    Serial.printf("\n[PROGRESS] %u%% - %u KB read\n", 
+                  (end * 100) / FLASH_TOTAL_SIZE, end / 1024);
+  }
   return true;
 }
 
 /**
  * @brief Dump entire flash memory to Serial output in hex format
  * This is practical for viewing/saving flash contents without needing 4MB RAM
- * @param chunkSize Size of chunks to read at a time (default 256 bytes)
+ * @param chunkSize Bytes read per SPI mutex hold (default: 256)
  */
-void flashDumpAll(size_t chunkSize = 256) {
+void flashDumpAll(size_t chunkSize) {
   if (!flashInitialized) {
     Serial.println("[ERROR] Flash not initialized!");
     return;
   }
   
-  uint8_t* buffer = (uint8_t*)malloc(chunkSize);
-  if (buffer == NULL) {
-    Serial.println("[ERROR] Failed to allocate memory!");
-    return;
-  }
-  
   Serial.println("\n========== FLASH MEMORY DUMP START ==========");
   Serial.printf("Total Size: %u bytes (%.2f MB)\n", FLASH_TOTAL_SIZE, FLASH_TOTAL_SIZE / 1048576.0);
   Serial.println("Format: [Address] Data (16 bytes per line)");
@@ -308,38 +467,13 @@ void flashDumpAll(size_t chunkSize = 256) {
   
   uint32_t totalBytes = 0;
   
-  for (uint32_t addr = 0; addr < FLASH_TOTAL_SIZE; addr += chunkSize) {
-    // Read chunk
-    if (!flashRead(addr, buffer, chunkSize)) {
-      Serial.printf("[ERROR] Failed to read at 0x%08X\n", addr);
-      break;
-    }
-    
-    // Print chunk in hex format (16 bytes per line)
-    for (size_t i = 0; i < chunkSize; i++) {
-      if ((addr + i) % 16 == 0) {
-        if (i > 0) Serial.println();
-        Serial.printf("[%08X] ", addr + i);
-      }
-      Serial.printf("%02X ", buffer[i]);
-      totalBytes++;
-    }
-    
-    // Progress update every 64KB
-    if ((addr % (64 * 1024)) == 0 && addr > 0) {
-      Serial.printf("\n[PROGRESS] %u%% - %u KB read\n", 
-                    (addr * 100) / FLASH_TOTAL_SIZE, addr / 1024);
-    }
-    
-    // Allow watchdog reset
-    vTaskDelay(pdMS_TO_TICKS(1));
+  if (!flashReadStream(0, FLASH_TOTAL_SIZE, dumpChunk, &totalBytes, chunkSize)) {
+    Serial.printf("[ERROR] Failed to read at 0x%08X\n", totalBytes);
   }
   
   Serial.println("\n\n========== FLASH MEMORY DUMP COMPLETE ==========");
   Serial.printf("Total bytes read: %u (%.2f MB)\n", totalBytes, totalBytes / 1048576.0);
   Serial.println("================================================\n");
-  
-  free(buffer);
 }
 
 /**
@@ -379,7 +513,7 @@ bool flashEraseAll() {
   Serial.println("[WARNING] This may take several seconds...");
   
   xSemaphoreTake(spiMutex, portMAX_DELAY);
-  bool success = flash.eraseChip();
+  bool success = flashVolume.eraseChip();
   xSemaphoreGive(spiMutex);
   
   if (success) {
@@ -391,6 +525,54 @@ bool flashEraseAll() {
   return success;
 }
 
+#define FLASH_READ_SUSPENDS       16   // Reads that can suspend one sector erase (0 --> reads wait for erases)
+#define FLASH_SUSPEND_MIN_RUN_US  500  // Least time an erase runs between two suspends
+#define FLASH_ERASE_SLACK_MS      250  // Added to the worst case erase time - for read suspends and the polling tick
+
+/**
+ * @brief Wait for the erase of a range started by eraseSectorAsync() / eraseSectionAsync()
+ * The SPI mutex is taken once per tick to poll for completion and released in
+ * between. Reads from other tasks get the bus in between and suspend the
+ * erase instead of waiting for the whole tSE / tBE (see setReadSuspend() in
+ * setup()). Gives up once the erases have taken longer than their worst case
+ * datasheet time - a chip stuck busy, or a floating MISO that reads 0xFF,
+ * would otherwise keep the task here for good.
+ * @param address Start of the range being erased
+ * @param length Length of the range being erased
+ * @return true once every erase has finished, false if one could not be started or timed out
+ */
+static bool flashWaitForErase(uint32_t address, uint32_t length) {
+  SPIFlash::erasePlan plan;
+  xSemaphoreTake(spiMutex, portMAX_DELAY);
+  bool planned = flashVolume.planErase(address, length, plan);
+  xSemaphoreGive(spiMutex);
+  uint32_t timeout = (planned ? plan.maxTime / 1000 : 0) + FLASH_ERASE_SLACK_MS;
+  
+  uint32_t startTime = millis();
+  bool busy = true;
+  while (busy) {
+    if (millis() - startTime > timeout) {
+      Serial.printf("[ERROR] Erase still busy after %lu ms (worst case %u ms) - giving up\n",
+                    millis() - startTime, timeout - FLASH_ERASE_SLACK_MS);
+      break;
+    }
+    vTaskDelay(1);
+    xSemaphoreTake(spiMutex, portMAX_DELAY);
+    busy = flashVolume.eraseBusy();
+    xSemaphoreGive(spiMutex);
+  }
+  
+  // Once the erases are done this only reports whether every one of them was started. Otherwise the short timeout
+  // makes it fail at once and drop the rest of the range
+  xSemaphoreTake(spiMutex, portMAX_DELAY);
+  bool success = flashVolume.awaitErase(busy ? 1 : BUSY_TIMEOUT);
+  xSemaphoreGive(spiMutex);
+  if (!success) {
+    Serial.printf("[ERROR] Erase at 0x%08X failed (error 0x%02X)\n", address, flashVolume.error());
+  }
+  return success;
+}
+
 /**
  * @brief Erase a single sector at specified address
  * @param address Address within the sector to erase (will erase entire 4KB sector)
@@ -410,14 +592,16 @@ bool flashEraseSector(uint32_t address) {
   Serial.printf("[INFO] Erasing sector %u at address 0x%08X\n", sectorNum, address);
   
   xSemaphoreTake(spiMutex, portMAX_DELAY);
-  bool success = flash.eraseSector(address);
+  bool success = flashVolume.eraseSectorAsync(address);
   xSemaphoreGive(spiMutex);
   
-  return success;
+  return success && flashWaitForErase(address, 1);
 }
 
 /**
  * @brief Erase multiple sectors in specified address range
+ * The range is covered with as few erases as possible - 64KB and 32KB blocks
+ * where they are aligned, 4KB sectors at the edges (see SPIFlash::planErase).
  * @param startAddress Starting address (will round down to sector boundary)
  * @param endAddress Ending address (will round up to sector boundary)
  * @return true if successful, false otherwise
@@ -432,28 +616,33 @@ bool flashEraseRange(uint32_t startAddress, uint32_t endAddress) {
     return false;
   }
   
-  // Align to sector boundaries
-  uint32_t startSector = (startAddress / FLASH_SECTOR_SIZE);
-  uint32_t endSector = (endAddress / FLASH_SECTOR_SIZE);
-  uint32_t numSectors = endSector - startSector + 1;
+  SPIFlash::erasePlan plan;
+  uint32_t length = endAddress - startAddress + 1;
   
-  Serial.printf("[INFO] Erasing %u sectors (0x%08X to 0x%08X)\n", 
-                numSectors, startSector * FLASH_SECTOR_SIZE, 
-                (endSector + 1) * FLASH_SECTOR_SIZE - 1);
+  xSemaphoreTake(spiMutex, portMAX_DELAY);
+  bool success = flashVolume.planErase(startAddress, length, plan);
+  xSemaphoreGive(spiMutex);
+  if (!success) {
+    Serial.println("[ERROR] Invalid address range");
+    return false;
+  }
   
-  for (uint32_t sector = startSector; sector <= endSector; sector++) {
-    uint32_t sectorAddr = sector * FLASH_SECTOR_SIZE;
-    
-    if (!flashEraseSector(sectorAddr)) {
-      Serial.printf("[ERROR] Failed to erase sector %u\n", sector);
-      return false;
-    }
-    
-    Serial.printf("[PROGRESS] Erased sector %u/%u\n", 
-                  sector - startSector + 1, numSectors);
+  Serial.printf("[INFO] Erasing 0x%08X to 0x%08X: %u x 64KB, %u x 32KB, %u x 4KB (estimated %u ms)\n",
+                plan.addr, plan.addr + plan.size - 1, plan.blocks64K, plan.blocks32K, plan.sectors,
+                plan.estimate / 1000);
+  
+  uint32_t startTime = millis();
+  xSemaphoreTake(spiMutex, portMAX_DELAY);
+  success = flashVolume.eraseSectionAsync(startAddress, length);
+  xSemaphoreGive(spiMutex);
+  success = success && flashWaitForErase(startAddress, length);
+  
+  if (!success) {
+    Serial.println("[ERROR] Range erase failed!");
+    return false;
   }
   
-  Serial.println("[INFO] Range erase complete!");
+  Serial.printf("[INFO] Range erase complete in %lu ms\n", millis() - startTime);
   return true;
 }
 
@@ -461,11 +650,124 @@ bool flashEraseRange(uint32_t startAddress, uint32_t endAddress) {
 // RING BUFFER MANAGEMENT
 //=============================================================================
 
+#define RING_ERASE_AHEAD      2    // Erased sectors kept in front of the write position
+#define RING_LATENCY_SAMPLES  128  // Latest ring buffer writes kept for the latency percentiles
+#define RING_PAGE_VEC         8    // Buffers flashRingBufferWritev() programs into a page at once
+
 // Ring buffer state
 uint32_t ringBufferWriteAddress = 0;  // Current write position
 bool ringBufferInitialized = false;
 bool ringBufferPaused = false;  // Flag to pause ring buffer writes
 
+// Erase-ahead state. Every sector from the write position up to
+// ringBufferErasedEnd is erased, so writes only have to program them
+uint32_t ringBufferErasedEnd = 0;
+bool ringBufferErasing = false;       // The sector at ringBufferErasedEnd is being erased
+uint8_t ringBufferEraseAhead = RING_ERASE_AHEAD;
+uint32_t ringBufferEraseStalls = 0;   // Writes that had to wait for their sector to be erased
+
+// Write latency of the latest ring buffer writes (us)
+uint32_t ringBufferLatency[RING_LATENCY_SAMPLES];
+uint16_t ringBufferLatencyCount = 0;
+uint16_t ringBufferLatencyNext = 0;
+
+/**
+ * @brief Bytes between the write position and the end of the erased space
+ */
+static uint32_t ringBufferErasedBytes() {
+  return (ringBufferErasedEnd + FLASH_TOTAL_SIZE - ringBufferWriteAddress) % FLASH_TOTAL_SIZE;
+}
+
+/**
+ * @brief Forget the erased space in front of the write position
+ * Called whenever the write position is moved. A running erase-ahead is
+ * left to finish, but no longer counts.
+ */
+static void ringBufferClearErased() {
+  if (ringBufferErasing) {
+    flashWaitForErase(ringBufferErasedEnd, 1);
+    ringBufferErasing = false;
+  }
+  // Rounded up - the rest of a sector the write position is in the middle of is taken as erased
+  ringBufferErasedEnd = ((ringBufferWriteAddress + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE) % FLASH_TOTAL_SIZE;
+}
+
+/**
+ * @brief Check on the running erase-ahead without waiting for it
+ * @return true once it has finished (or if none is running)
+ */
+static bool ringBufferEraseFinished() {
+  if (!ringBufferErasing) {
+    return true;
+  }
+  
+  xSemaphoreTake(spiMutex, portMAX_DELAY);
+  bool busy = flashVolume.eraseBusy();
+  bool success = busy || flashVolume.awaitErase();
+  xSemaphoreGive(spiMutex);
+  if (busy) {
+    return false;
+  }
+  
+  ringBufferErasing = false;
+  if (success) {
+    ringBufferErasedEnd = (ringBufferErasedEnd + FLASH_SECTOR_SIZE) % FLASH_TOTAL_SIZE;
+  }
+  return true;
+}
+
+/**
+ * @brief Keep ringBufferEraseAhead erased sectors in front of the write position
+ * Starts erasing the next sector and returns without waiting for it - the
+ * chip erases while the caller is idle. Called after every ring buffer write
+ * and by the auto-write task between writes; each call moves the erased space
+ * on by at most one sector.
+ */
+void flashRingBufferEraseAhead() {
+  if (!flashInitialized || !ringBufferInitialized || !ringBufferEraseFinished()) {
+    return;
+  }
+  if (ringBufferErasedBytes() / FLASH_SECTOR_SIZE >= ringBufferEraseAhead) {
+    return;
+  }
+  
+  xSemaphoreTake(spiMutex, portMAX_DELAY);
+  ringBufferErasing = flashVolume.eraseSectorAsync(ringBufferErasedEnd);
+  xSemaphoreGive(spiMutex);
+}
+
+/**
+ * @brief Make sure the sector starting at the write position is erased
+ * Normally erase-ahead has done it already. Otherwise waits for the
+ * erase-ahead of this sector, or erases it on the spot.
+ * @return true if successful, false otherwise
+ */
+static bool ringBufferPrepareSector() {
+  ringBufferEraseFinished();
+  if (ringBufferErasedBytes()) {
+    return true;
+  }
+  
+  ringBufferEraseStalls++;
+  if (ringBufferErasing) {
+    // Erase-ahead is on this very sector - ringBufferErasedEnd is the write position
+    bool success = flashWaitForErase(ringBufferWriteAddress, 1);
+    ringBufferErasing = false;
+    if (success) {
+      ringBufferErasedEnd = (ringBufferWriteAddress + FLASH_SECTOR_SIZE) % FLASH_TOTAL_SIZE;
+    }
+    return success;
+  }
+  
+  Serial.printf("[RING] Erasing sector %u at 0x%08X\n", 
+                ringBufferWriteAddress / FLASH_SECTOR_SIZE, ringBufferWriteAddress);
+  if (!flashEraseSector(ringBufferWriteAddress)) {
+    return false;
+  }
+  ringBufferErasedEnd = (ringBufferWriteAddress + FLASH_SECTOR_SIZE) % FLASH_TOTAL_SIZE;
+  return true;
+}
+
 /**
  * @brief Initialize ring buffer by finding the first empty sector
  * Scans flash to find where to start writing
@@ -508,9 +810,11 @@ bool flashRingBufferInit() {
     // If we found data before and now found empty sector, start here
     if (foundData && isEmpty) {
       ringBufferWriteAddress = addr;
+      ringBufferClearErased();
       ringBufferInitialized = true;
       Serial.printf("[RING] Write position set to sector %u (address 0x%08X)\n", 
                     sector, ringBufferWriteAddress);
+      flashRingBufferEraseAhead();
       return true;
     }
     
@@ -529,19 +833,25 @@ bool flashRingBufferInit() {
     ringBufferWriteAddress = 0;
   }
   
+  ringBufferClearErased();
   ringBufferInitialized = true;
   Serial.printf("[RING] Write position set to address 0x%08X\n", ringBufferWriteAddress);
+  flashRingBufferEraseAhead();
   return true;
 }
 
 /**
- * @brief Write data in ring buffer mode
- * Automatically wraps around to beginning and erases next sector before writing
- * @param data Pointer to data to write
- * @param length Length of data
+ * @brief Write several buffers in ring buffer mode, one after the other
+ * The buffers are written as if they were one record - e.g. a header, the
+ * fields of a struct and a padding - without being copied into one buffer
+ * first. Automatically wraps around to beginning. Sectors are erased ahead of
+ * the write position (see flashRingBufferEraseAhead()), so writes normally
+ * only program pages
+ * @param vec Buffers to write, in order
+ * @param count Number of buffers
  * @return true if successful, false otherwise
  */
-bool flashRingBufferWrite(const uint8_t* data, size_t length) {
+bool flashRingBufferWritev(const SPIFlash::iovec* vec, uint8_t count) {
   if (!flashInitialized || !ringBufferInitialized) {
     Serial.println("[ERROR] Ring buffer not initialized! Call flashRingBufferInit() first");
     return false;
@@ -552,36 +862,69 @@ bool flashRingBufferWrite(const uint8_t* data, size_t length) {
     return false;
   }
   
-  if (data == NULL || length == 0) {
+  if (vec == NULL) {
+    return false;
+  }
+  size_t length = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    length += vec[i].iov_len;
+  }
+  if (length == 0) {
     return false;
   }
   
-  Serial.printf("[RING] Writing %u bytes at 0x%08X\n", length, ringBufferWriteAddress);
+  Serial.printf("[RING] Writing %u bytes at 0x%08X\n", (uint32_t)length, ringBufferWriteAddress);
   
+  uint32_t startTime = micros();
   size_t bytesWritten = 0;
+  uint8_t segment = 0;        // Buffer the next byte comes from, and its offset in it
+  size_t segmentOffset = 0;
   
   while (bytesWritten < length) {
-    // Calculate current sector
-    uint32_t currentSector = ringBufferWriteAddress / FLASH_SECTOR_SIZE;
-    uint32_t sectorOffset = ringBufferWriteAddress % FLASH_SECTOR_SIZE;
+    // If at sector boundary, the sector has to be erased before it is written
+    if (ringBufferWriteAddress % FLASH_SECTOR_SIZE == 0 && !ringBufferPrepareSector()) {
+      Serial.println("[ERROR] Failed to erase sector");
+      return false;
+    }
+    
+    // Calculate how much we can write in current page (pages never straddle a sector)
+    size_t remainingInPage = FLASH_PAGE_SIZE - (ringBufferWriteAddress % FLASH_PAGE_SIZE);
+    size_t toWrite = (length - bytesWritten) < remainingInPage ? 
+                     (length - bytesWritten) : remainingInPage;
     
-    // If at sector boundary, erase the sector first
-    if (sectorOffset == 0) {
-      Serial.printf("[RING] Erasing sector %u at 0x%08X\n", 
-                    currentSector, ringBufferWriteAddress);
-      if (!flashEraseSector(ringBufferWriteAddress)) {
-        Serial.println("[ERROR] Failed to erase sector");
-        return false;
+    // The parts of the buffers that go in this page. A page made of more than
+    // RING_PAGE_VEC of them is programmed in several goes
+    SPIFlash::iovec pageVec[RING_PAGE_VEC];
+    uint8_t pageCount = 0;
+    size_t taken = 0;
+    while (taken < toWrite && pageCount < RING_PAGE_VEC) {
+      size_t part = std::min(vec[segment].iov_len - segmentOffset, toWrite - taken);
+      if (part) {
+        pageVec[pageCount].iov_base = (uint8_t*)vec[segment].iov_base + segmentOffset;
+        pageVec[pageCount].iov_len = part;
+        pageCount++;
+      }
+      taken += part;
+      segmentOffset += part;
+      if (segmentOffset == vec[segment].iov_len) {
+        segment++;
+        segmentOffset = 0;
       }
     }
+    toWrite = taken;
     
-    // Calculate how much we can write in current sector
-    size_t remainingInSector = FLASH_SECTOR_SIZE - sectorOffset;
-    size_t toWrite = (length - bytesWritten) < remainingInSector ? 
-                     (length - bytesWritten) : remainingInSector;
-    
-    // Write data
-    if (!flashWrite(ringBufferWriteAddress, &data[bytesWritten], toWrite)) {
+    // One page program, waited for and read back (as the chips' verify
+    // policy says) before the record counts as logged.
+    // The sector was erased when the write position entered it, so the blank
+    // check readback is skipped for ring buffer writes only
+    xSemaphoreTake(spiMutex, portMAX_DELAY);
+    bool success;
+    uint8_t policy = flashVolume.getPolicy();
+    flashVolume.setPolicy(policy | SPIMEMORY_POLICY_HIGHSPEED);
+    success = flashVolume.writev(ringBufferWriteAddress, pageVec, pageCount, true);
+    flashVolume.setPolicy(policy);
+    xSemaphoreGive(spiMutex);
+    if (!success) {
       Serial.println("[ERROR] Failed to write data");
       return false;
     }
@@ -596,29 +939,84 @@ bool flashRingBufferWrite(const uint8_t* data, size_t length) {
     }
   }
   
+  ringBufferLatency[ringBufferLatencyNext] = micros() - startTime;
+  ringBufferLatencyNext = (ringBufferLatencyNext + 1) % RING_LATENCY_SAMPLES;
+  if (ringBufferLatencyCount < RING_LATENCY_SAMPLES) {
+    ringBufferLatencyCount++;
+  }
+  
   Serial.printf("[RING] Write complete. Next write address: 0x%08X\n", ringBufferWriteAddress);
+  flashRingBufferEraseAhead();
   return true;
 }
 
+/**
+ * @brief Write latency of the latest RING_LATENCY_SAMPLES ring buffer writes
+ * Measured from the start of the first erase or program to the last page
+ * being verified.
+ * @param p50 Median (us)
+ * @param p99 99th percentile (us)
+ * @param maxLatency Longest write (us)
+ * @return Number of writes the figures are taken from
+ */
+uint16_t flashRingBufferLatency(uint32_t &p50, uint32_t &p99, uint32_t &maxLatency) {
+  uint32_t sorted[RING_LATENCY_SAMPLES];
+  uint16_t count = ringBufferLatencyCount;
+  
+  p50 = p99 = maxLatency = 0;
+  if (!count) {
+    return 0;
+  }
+  memcpy(sorted, ringBufferLatency, count * sizeof(uint32_t));
+  std::sort(sorted, sorted + count);
+  p50 = sorted[(count - 1) / 2];
+  p99 = sorted[(count * 99 + 99) / 100 - 1];
+  maxLatency = sorted[count - 1];
+  return count;
+}
+
+/**
+ * @brief Number of writes that had to wait for their sector to be erased
+ */
+uint32_t flashRingBufferEraseStalls() {
+  return ringBufferEraseStalls;
+}
+
+/**
+ * @brief Set how many erased sectors are kept in front of the write position
+ * @param sectors 0 erases every sector when the write position reaches it
+ */
+void flashRingBufferSetEraseAhead(uint8_t sectors) {
+  ringBufferEraseAhead = sectors;
+  flashRingBufferEraseAhead();
+}
+
+/**
+ * @brief Get how many erased sectors are kept in front of the write position
+ */
+uint8_t flashRingBufferGetEraseAhead() {
+  return ringBufferEraseAhead;
+}
+
+/**
+ * @brief Write data in ring buffer mode
+ * @param data Pointer to data to write
+ * @param length Length of data
+ * @return true if successful, false otherwise
+ */
+bool flashRingBufferWrite(const uint8_t* data, size_t length) {
+  SPIFlash::iovec vec = {(void*)data, data ? length : 0};
+  return flashRingBufferWritev(&vec, 1);
+}
+
 /**
  * @brief Write string in ring buffer mode
+ * The string is written straight from its own buffer, null terminator included
  * @param str String to write
  * @return true if successful, false otherwise
  */
 bool flashRingBufferWriteString(const String& str) {
-  // Add null terminator
-  size_t len = str.length() + 1;
-  uint8_t* buffer = (uint8_t*)malloc(len);
-  if (buffer == NULL) {
-    Serial.println("[ERROR] Failed to allocate memory");
-    return false;
-  }
-  
-  str.getBytes(buffer, len);
-  bool result = flashRingBufferWrite(buffer, len);
-  free(buffer);
-  
-  return result;
+  return flashRingBufferWrite((const uint8_t*)str.c_str(), str.length() + 1);
 }
 
 /**
@@ -644,7 +1042,9 @@ bool flashRingBufferSetPosition(uint32_t address) {
   address = (address / FLASH_SECTOR_SIZE) * FLASH_SECTOR_SIZE;
   
   ringBufferWriteAddress = address;
+  ringBufferClearErased();
   ringBufferInitialized = true;
+  flashRingBufferEraseAhead();
   
   Serial.printf("[RING] Write position set to 0x%08X\n", ringBufferWriteAddress);
   return true;
@@ -655,7 +1055,9 @@ bool flashRingBufferSetPosition(uint32_t address) {
  */
 void flashRingBufferReset() {
   ringBufferWriteAddress = 0;
+  ringBufferClearErased();
   ringBufferInitialized = true;
+  flashRingBufferEraseAhead();
   Serial.println("[RING] Ring buffer reset to address 0x00000000");
 }
 
@@ -772,17 +1174,27 @@ void autoWriteTask(void* parameter) {
       datalog.concat(inputs.breakSwitch);
       datalog.concat(";");
       
-      // Pad to MAXPAGESIZE with dots
-      for(int i = datalog.length(); i < MAXPAGESIZE-1; i++){
-        datalog.concat(".");
+      // Pad to MAXPAGESIZE with dots and a null terminator, written from a
+      // constant buffer behind the fields rather than appended to the String
+      static char padding[MAXPAGESIZE];
+      if (padding[0] != '.') {
+        memset(padding, '.', MAXPAGESIZE - 1);
+        padding[MAXPAGESIZE - 1] = '\0';
       }
+      size_t fieldsLength = datalog.length();
+      size_t paddingStart = std::min(fieldsLength, (size_t)MAXPAGESIZE - 1);
+      SPIFlash::iovec record[2] = {
+        {(void*)datalog.c_str(), fieldsLength},
+        {&padding[paddingStart], MAXPAGESIZE - paddingStart}
+      };
+      size_t recordLength = fieldsLength + record[1].iov_len;
       
       // Write to ring buffer
-      if (flashRingBufferWriteString(datalog)) {
+      if (flashRingBufferWritev(record, 2)) {
         writeCount++;
         Serial.printf("[AUTO] #%u: Logged vehicle data at 0x%08X (Speed: %.1f km/h, SOC: %d%%)\n", 
                       writeCount, 
-                      flashRingBufferGetPosition() - datalog.length(), 
+                      (uint32_t)((flashRingBufferGetPosition() + FLASH_TOTAL_SIZE - recordLength) % FLASH_TOTAL_SIZE), 
                       vehicleInfo.speedKmh,
                       BMSData.SOC);
       } else {
@@ -790,6 +1202,9 @@ void autoWriteTask(void* parameter) {
       }
     }
     
+    // Erase ahead while waiting for the next write
+    flashRingBufferEraseAhead();
+    
     // Wait 1 second before next write
     vTaskDelay(pdMS_TO_TICKS(1000));
   }
@@ -931,30 +1346,75 @@ void setup() {
   Serial.println("\n=== FreeRTOS Flash Memory System ===");
   Serial.println("Initializing Winbond W25Q32JVSSIQ SPI Flash...");
   
+#if defined (ARDUINO_ARCH_NATIVE)
+  for (uint8_t i = 0; i < FLASH_CHIP_COUNT; i++) {
+    nativeAttachSPIDevice(SPI, flashChipSelects[i], flashChip[i]);
+  }
+#endif
+
   // Configure custom SPI pins
   SPI.begin(SPI_FLASH_CLK, SPI_FLASH_MISO, SPI_FLASH_MOSI, SPI_FLASH_CS);
   
-  // Initialize the flash memory
-  if (flash.begin()) {
+  // Initialize every flash chip, then the volume over them
+  bool chipsFound = true;
+  for (uint8_t i = 0; i < FLASH_CHIP_COUNT; i++) {
+    chipsFound = flashChips[i]->begin() && chipsFound;
+  }
+  if (chipsFound && flashVolume.begin()) {
     flashInitialized = true;
     Serial.println("✓ Flash memory initialized successfully!");
     
     // Get flash chip information
     uint32_t jedecID = flash.getJEDECID();
-    uint32_t capacity = flash.getCapacity();
-    uint16_t maxPages = flash.getMaxPage();
+    uint32_t capacity = flashVolume.getCapacity();
+    uint32_t maxPages = flashVolume.getMaxPage();
     
     Serial.printf("  JEDEC ID: 0x%08X\n", jedecID);
+    Serial.printf("  Chips: %u (pages striped across them)\n", FLASH_CHIP_COUNT);
     Serial.printf("  Capacity: %u bytes (%.2f MB)\n", capacity, capacity / 1048576.0);
     Serial.printf("  Max Pages: %u\n", maxPages);
     Serial.printf("  Sector Size: %u bytes\n", FLASH_SECTOR_SIZE);
+
+    bool pageMap = true;
+    bool readCache = FLASH_READ_CACHE_LINES;
+    bool autoPowerDown = FLASH_AUTO_POWER_DOWN_MS;
+    for (uint8_t i = 0; i < FLASH_CHIP_COUNT; i++) {
+      SPIFlash* chip = flashChips[i];
+
+      // Widest bus the chip and the SPI transport share - single line on the Arduino SPI driver
+      chip->setIOMode();
+
+      // Let reads from other tasks suspend sector erases instead of waiting for them
+      chip->setReadSuspend(FLASH_READ_SUSPENDS, FLASH_SUSPEND_MIN_RUN_US);
+
+      // Remember which pages are blank, so writes to freshly erased pages skip the readback check
+      pageMap = chip->trackErasedPages() && pageMap;
+
+      // Keep the last pages read in RAM - repeated BT reads and ring buffer scans are served from it
+      readCache = readCache && chip->setReadCache(FLASH_READ_CACHE_LINES, FLASH_PAGE_SIZE, FLASH_READ_AHEAD);
+
+      // Deep power-down while no task uses the flash - the next access wakes it up
+      autoPowerDown = autoPowerDown && chip->setAutoPowerDown(FLASH_AUTO_POWER_DOWN_MS);
+    }
+    Serial.printf("  I/O Mode: %u-%u (address-data lines)\n", ADDRESSLINES(flash.getIOMode()), DATALINES(flash.getIOMode()));
+    if (pageMap) {
+      Serial.printf("  Erased page map: %u bytes\n", capacity / FLASH_PAGE_SIZE / 8);
+    }
+    if (readCache) {
+      Serial.printf("  Read cache: %u x %u bytes per chip\n", FLASH_READ_CACHE_LINES, FLASH_PAGE_SIZE);
+    }
+    if (autoPowerDown) {
+      Serial.printf("  Auto power-down: after %u ms idle\n", FLASH_AUTO_POWER_DOWN_MS);
+    }
   } else {
     Serial.println("✗ Flash memory initialization failed!");
     Serial.println("Please check your wiring:");
     Serial.println("  CLK:  GPIO 14");
     Serial.println("  MISO: GPIO 12");
     Serial.println("  MOSI: GPIO 13");
-    Serial.println("  CS:   GPIO 26");
+    for (uint8_t i = 0; i < FLASH_CHIP_COUNT; i++) {
+      Serial.printf("  CS:   GPIO %u (chip %u)\n", flashChipSelects[i], i);
+    }
     while (1) {
       delay(1000);
     }
@@ -1001,6 +1461,13 @@ void setup() {
 }
 
 void loop() {
-  // Empty loop - FreeRTOS tasks handle everything
-  vTaskDelay(pdMS_TO_TICKS(1000));
+  // FreeRTOS tasks handle everything else. Power the flash down once none of them has used it for FLASH_AUTO_POWER_DOWN_MS
+  if (flashInitialized) {
+    xSemaphoreTake(spiMutex, portMAX_DELAY);
+    for (uint8_t i = 0; i < FLASH_CHIP_COUNT; i++) {
+      flashChips[i]->powerDownIfIdle();
+    }
+    xSemaphoreGive(spiMutex);
+  }
+  vTaskDelay(pdMS_TO_TICKS(FLASH_IDLE_CHECK_MS));
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+// The erase planner: planErase() covers a range with the fewest erases, and
+// eraseSection() sends exactly those and erases nothing outside the range
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPIMemory.h>
+#include <NativeSPITransport.h>
+#include <W25Q32Emulator.h>
+#include <unity.h>
+
+#define FLASH_CS  5
+
+W25Q32Emulator chip;
+NativeSPITransport bus(FLASH_CS);
+SPIFlash flash(bus);
+
+void setUp(void) {
+  flash.setPolicy(SPIMEMORY_POLICY_SAFE);
+}
+
+void tearDown(void) {}
+
+static void assertPlan(uint32_t addr, uint32_t size, uint32_t planAddr, uint32_t planSize,
+                       uint32_t sectors, uint32_t blocks32K, uint32_t blocks64K) {
+  SPIFlash::erasePlan plan;
+  TEST_ASSERT_TRUE(flash.planErase(addr, size, plan));
+  TEST_ASSERT_EQUAL_HEX32(planAddr, plan.addr);
+  TEST_ASSERT_EQUAL_UINT32(planSize, plan.size);
+  TEST_ASSERT_EQUAL_UINT32(sectors, plan.sectors);
+  TEST_ASSERT_EQUAL_UINT32(blocks32K, plan.blocks32K);
+  TEST_ASSERT_EQUAL_UINT32(blocks64K, plan.blocks64K);
+}
+
+void test_rounds_out_to_sectors(void) {
+  assertPlan(0x7100, 0x100, 0x7000, KB(4), 1, 0, 0);
+  assertPlan(0x7FFF, 2, 0x7000, KB(8), 2, 0, 0);
+}
+
+void test_aligned_blocks(void) {
+  assertPlan(0x10000, KB(64), 0x10000, KB(64), 0, 0, 1);
+  assertPlan(0x18000, KB(32), 0x18000, KB(32), 0, 1, 0);
+  assertPlan(0, W25Q32_CAPACITY, 0, W25Q32_CAPACITY, 0, 0, 64);
+}
+
+// Sectors up to the first 32 KB boundary, the largest blocks in between, sectors after the last
+void test_mixed_range(void) {
+  assertPlan(0x7000, 0x1A000, 0x7000, 0x1A000, 2, 1, 1);
+  assertPlan(0x3000, 0x2E000, 0x3000, 0x2E000, 6, 1, 2);
+}
+
+// The SFDP typical times are a multiplier below the maximum ones
+void test_times(void) {
+  SPIFlash::erasePlan plan;
+  TEST_ASSERT_TRUE(flash.planErase(0x7000, 0x1A000, plan));
+  TEST_ASSERT_EQUAL_UINT32(160000UL + 128000UL + 2 * 48000UL, plan.estimate);
+  TEST_ASSERT_EQUAL_UINT32((160000UL + 128000UL + 2 * 48000UL) * 8, plan.maxTime);
+}
+
+// With overflow allowed the range goes on from address 0
+void test_wraps_at_end(void) {
+  assertPlan(W25Q32_CAPACITY - KB(4), KB(8), W25Q32_CAPACITY - KB(4), KB(8), 2, 0, 0);
+  flash.setPolicy(SPIMEMORY_POLICY_NOOVERFLOW);
+  SPIFlash::erasePlan plan;
+  TEST_ASSERT_FALSE(flash.planErase(W25Q32_CAPACITY - KB(4), KB(8), plan));
+}
+
+void test_rejects_empty_range(void) {
+  SPIFlash::erasePlan plan;
+  TEST_ASSERT_FALSE(flash.planErase(0x1000, 0, plan));
+}
+
+// eraseSection() sends the erases of the plan, and the bytes just outside the range survive
+void test_section_follows_plan(void) {
+  uint8_t marker = 0x5A;
+  TEST_ASSERT_TRUE(flash.writeByte(0x3000 - 1, marker));
+  TEST_ASSERT_TRUE(flash.writeByte(0x31000, marker));
+  for (uint32_t addr = 0x3000; addr < 0x31000; addr += KB(4)) {
+    TEST_ASSERT_TRUE(flash.writeByte(addr, marker));
+  }
+
+  chip.resetStats();
+  TEST_ASSERT_TRUE(flash.eraseSection(0x3000, 0x2E000));
+  W25Q32Emulator::Stats stats = chip.getStats();
+  TEST_ASSERT_EQUAL_UINT64(6, stats.sectorErases);
+  TEST_ASSERT_EQUAL_UINT64(1, stats.block32Erases);
+  TEST_ASSERT_EQUAL_UINT64(2, stats.block64Erases);
+
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, chip.memory() + 0x3000, 0x2E000);
+  TEST_ASSERT_EQUAL_HEX8(marker, chip.memory()[0x3000 - 1]);
+  TEST_ASSERT_EQUAL_HEX8(marker, chip.memory()[0x31000]);
+}
+
+void setup() {
+  nativeAttachSPIDevice(SPI, FLASH_CS, chip);
+  chip.setTimeScale(0);
+  flash.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_rounds_out_to_sectors);
+  RUN_TEST(test_aligned_blocks);
+  RUN_TEST(test_mixed_range);
+  RUN_TEST(test_times);
+  RUN_TEST(test_wraps_at_end);
+  RUN_TEST(test_rejects_empty_range);
+  RUN_TEST(test_section_follows_plan);
+  exit(UNITY_END());
+}
+
+void loop() {}
@@ -0,0 +1,114 @@
+// The read cache: lines are served from RAM until a program or erase made
+// through the same object touches them, and are read from the chip again after
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPIMemory.h>
+#include <NativeSPITransport.h>
+#include <W25Q32Emulator.h>
+#include <unity.h>
+
+#define FLASH_CS  5
+
+W25Q32Emulator chip;
+NativeSPITransport bus(FLASH_CS);
+SPIFlash flash(bus);
+uint8_t buffer[64];
+
+void setUp(void) {
+  TEST_ASSERT_TRUE(flash.eraseSector(0));
+  TEST_ASSERT_TRUE(flash.setReadCache(4, SPI_PAGESIZE, 1));
+  flash.resetCacheStats();
+}
+
+void tearDown(void) {
+  flash.setReadCache(0);
+}
+
+static void read(uint32_t addr, uint32_t size) {
+  TEST_ASSERT_TRUE(flash.readByteArray(addr, buffer, size));
+}
+
+void test_hit_after_miss(void) {
+  read(0x100, 16);
+  uint64_t commands = chip.getStats().readCommands;
+  read(0x110, 16);
+  TEST_ASSERT_EQUAL_UINT32(1, flash.getCacheStats().misses);
+  TEST_ASSERT_EQUAL_UINT32(1, flash.getCacheStats().hits);
+  TEST_ASSERT_EQUAL_UINT64(commands, chip.getStats().readCommands);
+}
+
+void test_program_drops_line(void) {
+  read(0x100, 16);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, buffer, 16);
+  uint8_t data[4] = {0x11, 0x22, 0x33, 0x44};
+  TEST_ASSERT_TRUE(flash.writeByteArray(0x104, data, sizeof(data)));
+  read(0x100, 16);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, buffer + 4, sizeof(data));
+  TEST_ASSERT_EQUAL_HEX8(0xFF, buffer[8]);
+}
+
+void test_writev_drops_lines(void) {
+  read(0x1F0, 32);       // Two lines
+  uint8_t head[8], tail[8];
+  memset(head, 0xA1, sizeof(head));
+  memset(tail, 0xB2, sizeof(tail));
+  SPIFlash::iovec vec[2] = {{head, sizeof(head)}, {tail, sizeof(tail)}};
+  TEST_ASSERT_TRUE(flash.writev(0x1F8, vec, 2));
+  read(0x1F0, 32);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, buffer, 8);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xA1, buffer + 8, 8);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xB2, buffer + 16, 8);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, buffer + 24, 8);
+}
+
+void test_erase_drops_lines(void) {
+  uint8_t data[16];
+  memset(data, 0x42, sizeof(data));
+  TEST_ASSERT_TRUE(flash.writeByteArray(0x300, data, sizeof(data)));
+  read(0x300, 16);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0x42, buffer, 16);
+  TEST_ASSERT_TRUE(flash.eraseSector(0x300));
+  read(0x300, 16);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, buffer, 16);
+}
+
+// A sequential miss reads the next line with the same command
+void test_read_ahead(void) {
+  read(0x000, 16);
+  read(0x100, 16);
+  uint64_t commands = chip.getStats().readCommands;
+  read(0x200, 16);
+  TEST_ASSERT_EQUAL_UINT32(1, flash.getCacheStats().readAheads);
+  TEST_ASSERT_EQUAL_UINT64(commands, chip.getStats().readCommands);
+}
+
+// Writes made behind the object's back are only seen after clearReadCache()
+void test_clear(void) {
+  read(0x400, 16);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, buffer, 16);
+  SPIFlash other(bus);
+  TEST_ASSERT_TRUE(other.begin());
+  TEST_ASSERT_TRUE(other.writeByte(0x400, 0x00));
+  read(0x400, 16);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, buffer[0]);
+  flash.clearReadCache();
+  read(0x400, 16);
+  TEST_ASSERT_EQUAL_HEX8(0x00, buffer[0]);
+}
+
+void setup() {
+  nativeAttachSPIDevice(SPI, FLASH_CS, chip);
+  chip.setTimeScale(0);
+  flash.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_hit_after_miss);
+  RUN_TEST(test_program_drops_line);
+  RUN_TEST(test_writev_drops_lines);
+  RUN_TEST(test_erase_drops_lines);
+  RUN_TEST(test_read_ahead);
+  RUN_TEST(test_clear);
+  exit(UNITY_END());
+}
+
+void loop() {}
@@ -0,0 +1,90 @@
+// SFDP parsing: begin() on the W25Q32JV model has to find what its SFDP table
+// (W25Q32Emulator.cpp) says. Needs USES_SFDP, set by the native environment
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPIMemory.h>
+#include <NativeSPITransport.h>
+#include <W25Q32Emulator.h>
+#include <unity.h>
+
+#define FLASH_CS  5
+
+W25Q32Emulator chip;
+NativeSPITransport bus(FLASH_CS);
+SPIFlash flash(bus);
+SPIFlash::chipParams params;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_begin_reads_sfdp(void) {
+  TEST_ASSERT_TRUE(flash.begin());
+  TEST_ASSERT_TRUE(flash.getChipParams(params));
+  TEST_ASSERT_BITS_HIGH(0x04, params.chipFlags);     // sfdpAvailable
+}
+
+// DWORD 2: 32 Mbit, as a bit count
+void test_density(void) {
+  TEST_ASSERT_EQUAL_UINT32(W25Q32_CAPACITY, flash.getCapacity());
+  TEST_ASSERT_EQUAL_UINT32(W25Q32_CAPACITY, params.capacity);
+}
+
+// DWORDs 8 - 9: 4 KB (20h), 32 KB (52h) and 64 KB (D8h) erases, no 256 KB one
+void test_erase_types(void) {
+  TEST_ASSERT_EQUAL_HEX8(0x17, params.eraseSupported);
+  TEST_ASSERT_EQUAL_HEX8(0x20, params.eraseOpcode[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x52, params.eraseOpcode[1]);
+  TEST_ASSERT_EQUAL_HEX8(0xD8, params.eraseOpcode[2]);
+}
+
+// DWORD 10: typical 48 / 128 / 160 ms in 16 ms units, max 8x typical.
+// DWORD 11: chip erase 2 x 4 s typical
+void test_erase_times(void) {
+  TEST_ASSERT_EQUAL_UINT16(8, params.eraseTimeMultiplier);
+  TEST_ASSERT_EQUAL_UINT32(48000UL * 8, params.eraseTime[0]);
+  TEST_ASSERT_EQUAL_UINT32(128000UL * 8, params.eraseTime[1]);
+  TEST_ASSERT_EQUAL_UINT32(160000UL * 8, params.eraseTime[2]);
+  TEST_ASSERT_EQUAL_UINT32(8000000UL * 8, params.eraseTime[4]);
+}
+
+// DWORD 11: 256-byte pages, page 384 us, first byte 32 us, next bytes 3 us, max 6x typical
+void test_program_times(void) {
+  TEST_ASSERT_EQUAL_UINT16(256, params.pageSize);
+  TEST_ASSERT_EQUAL_UINT16(6, params.prgmTimeMultiplier);
+  TEST_ASSERT_EQUAL_UINT32(384 * 6, params.pagePrgmTime);
+  TEST_ASSERT_EQUAL_UINT32(32 * 6, params.byteFirstPrgmTime);
+  TEST_ASSERT_EQUAL_UINT32(3 * 6, params.byteAddnlPrgmTime);
+}
+
+// DWORDs 1, 3, 4 and 15: 1-1-2, 1-1-4 and 1-4-4 reads, QE in status register 2
+void test_io_modes(void) {
+  TEST_ASSERT_EQUAL_HEX8(SFDP_IO_DUAL | SFDP_IO_QUAD | SFDP_IO_QUADIO | SFDP_IO_QE, params.sfdpIOModes);
+  TEST_ASSERT_TRUE(flash.setIOMode(SPIMEMORY_IO_QUADIO));
+  TEST_ASSERT_TRUE(flash.setIOMode(SPIMEMORY_IO_SINGLE));
+}
+
+// What begin() found comes back from the saved parameters without reading SFDP again
+void test_saved_params(void) {
+  SPIFlash again(bus);
+  SPIFlash::chipParams copy;
+  TEST_ASSERT_TRUE(again.begin(params));
+  TEST_ASSERT_TRUE(again.getChipParams(copy));
+  TEST_ASSERT_EQUAL_MEMORY(&params, &copy, sizeof(params));
+}
+
+void setup() {
+  nativeAttachSPIDevice(SPI, FLASH_CS, chip);
+  chip.setTimeScale(0);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_reads_sfdp);
+  RUN_TEST(test_density);
+  RUN_TEST(test_erase_types);
+  RUN_TEST(test_erase_times);
+  RUN_TEST(test_program_times);
+  RUN_TEST(test_io_modes);
+  RUN_TEST(test_saved_params);
+  exit(UNITY_END());
+}
+
+void loop() {}
@@ -0,0 +1,109 @@
+// SPIFlashVolume striping: consecutive pages go to consecutive chips, and a
+// volume sector is the same 4 KB sector on every chip
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPIMemory.h>
+#include <NativeSPITransport.h>
+#include <W25Q32Emulator.h>
+#include <unity.h>
+
+#define FLASH_CS0  5
+#define FLASH_CS1  6
+
+W25Q32Emulator chip0, chip1;
+NativeSPITransport bus0(FLASH_CS0), bus1(FLASH_CS1);
+SPIFlash flash0(bus0), flash1(bus1);
+SPIFlash *chips[] = {&flash0, &flash1};
+SPIFlashVolume volume(chips, 2);
+uint8_t data[KB(16)], buffer[2048];
+
+void setUp(void) {
+  chip0.resetStats();
+  chip1.resetStats();
+}
+
+void tearDown(void) {}
+
+void test_geometry(void) {
+  TEST_ASSERT_EQUAL_UINT8(2, volume.getChipCount());
+  TEST_ASSERT_EQUAL_UINT32(2 * W25Q32_CAPACITY, volume.getCapacity());
+  TEST_ASSERT_EQUAL_UINT32(2 * KB(4), volume.getSectorSize());
+}
+
+// Pages 0, 2, 4 ... on the first chip, 1, 3, 5 ... on the second
+void test_striping(void) {
+  TEST_ASSERT_TRUE(volume.writeByteArray(0, data, 1024));
+  TEST_ASSERT_EQUAL_UINT64(2, chip0.getStats().pagePrograms);
+  TEST_ASSERT_EQUAL_UINT64(2, chip1.getStats().pagePrograms);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chip0.memory(), 256);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 256, chip1.memory(), 256);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 512, chip0.memory() + 256, 256);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 768, chip1.memory() + 256, 256);
+}
+
+// A range that starts and ends inside pages
+void test_unaligned(void) {
+  uint32_t addr = 0x10000 + 200;
+  SPIFlash::iovec vec[2] = {{data, 100}, {data + 100, 300}};
+  TEST_ASSERT_TRUE(volume.writev(addr, vec, 2));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chip0.memory() + 0x8000 + 200, 56);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 56, chip1.memory() + 0x8000, 256);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 312, chip0.memory() + 0x8100, 88);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, chip0.memory()[0x8000 + 199]);
+  TEST_ASSERT_TRUE(volume.readByteArray(addr, buffer, 400));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, buffer, 400);
+}
+
+void test_read_stream(void) {
+  TEST_ASSERT_TRUE(volume.writeByteArray(0x20000, data, sizeof(buffer)));
+  memset(buffer, 0, sizeof(buffer));
+  uint8_t chunk[300];
+  auto collect = [](uint32_t addr, const uint8_t *chunkData, uint32_t size, void *context) -> bool {
+    memcpy((uint8_t*)context + (addr - 0x20000), chunkData, size);
+    return true;
+  };
+  TEST_ASSERT_TRUE(volume.readStream(0x20000, sizeof(buffer), chunk, sizeof(chunk), collect, buffer));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, buffer, sizeof(buffer));
+}
+
+// Volume sector 1 is sector 1 (0x1000) of both chips
+void test_erase_sector(void) {
+  TEST_ASSERT_TRUE(volume.writeByteArray(KB(8) - 256, data, KB(8) + 512));
+  TEST_ASSERT_TRUE(volume.eraseSector(KB(8) + 100));
+  TEST_ASSERT_EQUAL_UINT64(1, chip0.getStats().sectorErases);
+  TEST_ASSERT_EQUAL_UINT64(1, chip1.getStats().sectorErases);
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, chip0.memory() + KB(4), KB(4));
+  TEST_ASSERT_EACH_EQUAL_HEX8(0xFF, chip1.memory() + KB(4), KB(4));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chip1.memory() + KB(4) - 256, 256);   // The page before the sector
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data + KB(8) + 256, chip0.memory() + KB(8), 256);    // And the one after
+}
+
+void test_out_of_range(void) {
+  TEST_ASSERT_FALSE(volume.writeByteArray(volume.getCapacity() - 100, data, 200));
+  TEST_ASSERT_FALSE(volume.readByteArray(volume.getCapacity(), buffer, 1));
+  TEST_ASSERT_EQUAL_UINT64(0, chip0.getStats().pagePrograms + chip1.getStats().pagePrograms);
+}
+
+void setup() {
+  nativeAttachSPIDevice(SPI, FLASH_CS0, chip0);
+  nativeAttachSPIDevice(SPI, FLASH_CS1, chip1);
+  chip0.setTimeScale(0);
+  chip1.setTimeScale(0);
+  flash0.begin();
+  flash1.begin();
+  volume.begin();
+  for (uint32_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 13 + 1);
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_geometry);
+  RUN_TEST(test_striping);
+  RUN_TEST(test_unaligned);
+  RUN_TEST(test_read_stream);
+  RUN_TEST(test_erase_sector);
+  RUN_TEST(test_out_of_range);
+  exit(UNITY_END());
+}
+
+void loop() {}
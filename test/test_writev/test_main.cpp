@@ -0,0 +1,107 @@
+// writev(): the buffers are split into one page program per page touched -
+// whatever the buffer boundaries - and roll over to address 0 at the end of the chip
+#include <Arduino.h>
+#include <SPI.h>
+#include <SPIMemory.h>
+#include <NativeSPITransport.h>
+#include <W25Q32Emulator.h>
+#include <unity.h>
+
+#define FLASH_CS  5
+
+W25Q32Emulator chip;
+NativeSPITransport bus(FLASH_CS);
+SPIFlash flash(bus);
+uint8_t data[1024];
+
+void setUp(void) {
+  flash.setPolicy(SPIMEMORY_POLICY_SAFE);
+  chip.resetStats();
+}
+
+void tearDown(void) {}
+
+void test_one_page(void) {
+  SPIFlash::iovec vec[3] = {{data, 10}, {data + 10, 20}, {data + 30, 30}};
+  TEST_ASSERT_TRUE(flash.writev(0x1010, vec, 3));
+  TEST_ASSERT_EQUAL_UINT64(1, chip.getStats().pagePrograms);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chip.memory() + 0x1010, 60);
+}
+
+// 128 + 256 + 16 bytes: three pages, the first two made of parts of two buffers
+void test_page_split(void) {
+  SPIFlash::iovec vec[4] = {{data, 100}, {data + 100, 0}, {data + 100, 200}, {data + 300, 100}};
+  TEST_ASSERT_TRUE(flash.writev(0x2080, vec, 4));
+  TEST_ASSERT_EQUAL_UINT64(3, chip.getStats().pagePrograms);
+  TEST_ASSERT_EQUAL_UINT64(400, chip.getStats().bytesProgrammed);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chip.memory() + 0x2080, 400);
+  TEST_ASSERT_EQUAL_HEX8(0xFF, chip.memory()[0x2080 + 400]);
+}
+
+// Many small buffers gathered into one page
+void test_gather(void) {
+  SPIFlash::iovec vec[16];
+  for (uint8_t i = 0; i < 16; i++) {
+    vec[i].iov_base = data + i * 16;
+    vec[i].iov_len = 16;
+  }
+  TEST_ASSERT_TRUE(flash.writev(0x3000, vec, 16));
+  TEST_ASSERT_EQUAL_UINT64(1, chip.getStats().pagePrograms);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chip.memory() + 0x3000, 256);
+}
+
+void test_empty(void) {
+  SPIFlash::iovec vec[2] = {{data, 0}, {data, 0}};
+  TEST_ASSERT_FALSE(flash.writev(0x4000, vec, 2));
+  TEST_ASSERT_FALSE(flash.writev(0x4000, NULL, 0));
+  TEST_ASSERT_EQUAL_UINT64(0, chip.getStats().pagePrograms);
+}
+
+// The last 100 bytes of the chip, then the first 100
+void test_wrap(void) {
+  SPIFlash::iovec vec[2] = {{data, 150}, {data + 150, 50}};
+  TEST_ASSERT_TRUE(flash.writev(W25Q32_CAPACITY - 100, vec, 2));
+  TEST_ASSERT_EQUAL_UINT64(2, chip.getStats().pagePrograms);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, chip.memory() + W25Q32_CAPACITY - 100, 100);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data + 100, chip.memory(), 100);
+  uint8_t back[200];
+  TEST_ASSERT_TRUE(flash.readByteArray(W25Q32_CAPACITY - 100, back, sizeof(back)));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(data, back, sizeof(back));
+}
+
+void test_no_wrap(void) {
+  flash.setPolicy(SPIMEMORY_POLICY_NOOVERFLOW);
+  SPIFlash::iovec vec = {data, 200};
+  TEST_ASSERT_FALSE(flash.writev(W25Q32_CAPACITY - 100, &vec, 1));
+  TEST_ASSERT_EQUAL_UINT64(0, chip.getStats().pagePrograms);
+}
+
+// A range that is not blank is refused before anything is programmed
+void test_not_blank(void) {
+  SPIFlash::iovec vec = {data, 16};
+  TEST_ASSERT_TRUE(flash.writev(0x5000, &vec, 1));
+  chip.resetStats();
+  TEST_ASSERT_FALSE(flash.writev(0x5008, &vec, 1));
+  TEST_ASSERT_EQUAL_UINT64(0, chip.getStats().pagePrograms);
+}
+
+void setup() {
+  nativeAttachSPIDevice(SPI, FLASH_CS, chip);
+  chip.setTimeScale(0);
+  flash.begin();
+  for (uint32_t i = 0; i < sizeof(data); i++) {
+    data[i] = (uint8_t)(i * 7 + 3);
+  }
+
+  UNITY_BEGIN();
+  RUN_TEST(test_one_page);
+  RUN_TEST(test_page_split);
+  RUN_TEST(test_gather);
+  RUN_TEST(test_empty);
+  RUN_TEST(test_wrap);
+  RUN_TEST(test_no_wrap);
+  RUN_TEST(test_not_blank);
+  exit(UNITY_END());
+}
+
+void loop() {}